@@ -0,0 +1,20 @@
+#ifndef AUTO_GAIN_H
+#define AUTO_GAIN_H
+
+#include <stdint.h>
+#include "tcs34725.h"
+
+// PROGI WYPELNIENIA KANALU CLEAR W PROMILACH ZAKRESU (HISTEREZA)
+#define AUTO_GAIN_HIGH_PERMILLE   800
+#define AUTO_GAIN_LOW_PERMILLE    200
+
+// LICZBA PROBEK POMIJANYCH PO ZMIANIE USTAWIEN (INTEGRACJA W TOKU)
+#define AUTO_GAIN_SETTLE_SAMPLES  2
+
+extern volatile uint8_t auto_gain_enabled;
+
+void AutoGain_SetEnabled(uint8_t enabled);
+void AutoGain_Process(uint8_t sensor, const TCS34725_Data_t *data);
+void AutoGain_ClampToInterval(uint32_t interval_ms);
+
+#endif
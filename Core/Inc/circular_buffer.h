@@ -6,6 +6,8 @@
 
 #define UART_TXBUF_LEN 1512
 #define UART_RXBUF_LEN 128
+// Znaczniki odbioru znakow startu ramki - tyle ramek minimalnej dlugosci miesci bufor RX
+#define UART_RX_STAMPS 8
 
 extern uint8_t UART_TxBuf[UART_TXBUF_LEN];
 extern uint8_t UART_RxBuf[UART_RXBUF_LEN];
@@ -19,12 +21,21 @@ extern volatile int UART_RX_Busy;
 
 typedef struct {
     TCS34725_Data_t data;
-    uint32_t timestamp;
+    uint64_t timestamp_us;  // Srodek integracji w us od startu (Timebase_NowUs)
+    uint8_t gain_index;   // Ustawienia aktywne przy pomiarze (do lux/CCT)
+    uint8_t time_index;
+    uint16_t spread;      // Rozrzut kanalu C przy nadprobkowaniu (TCS_SPREAD_NONE - brak)
 } ColorBufferEntry_t;
 
-extern ColorBufferEntry_t ColorBuffer[COLOR_BUFFER_SIZE];
-extern volatile uint32_t ColorBuffer_WritePos;
-extern volatile uint8_t ColorBuffer_DataAvailable;
+// Archiwum pomiarow jednego czujnika
+typedef struct {
+    ColorBufferEntry_t entries[COLOR_BUFFER_SIZE];
+    volatile uint32_t write_pos;       // POZYCJA ZAPISU
+    volatile uint8_t data_available;   // FLAGA CZY ROZPOCZETO ZBIERANIE DANYCH
+    volatile uint32_t seq;             // LICZNIK SEKWENCJI (nieparzysty = trwa zapis)
+} ColorArchive_t;
+
+extern ColorArchive_t ColorBuffer[TCS_SENSOR_COUNT];
 
 extern volatile uint32_t timer_interval;
 
@@ -32,11 +43,15 @@ uint8_t UART_RX_IsEmpty(void);
 
 int16_t UART_RX_GetChar(void);
 
+void UART_RX_StampStart(int pos, uint64_t now_us);
+uint64_t UART_RX_StartTimeUs(int pos);
+
 void UART_TX_FSend(char* format, ...);
 
-uint8_t ColorBuffer_Put(TCS34725_Data_t *data, uint32_t timestamp);
-ColorBufferEntry_t* ColorBuffer_GetLatest(void);
-ColorBufferEntry_t* ColorBuffer_GetByTimeOffset(uint32_t timeOffsetMs);
+uint8_t ColorBuffer_Put(uint8_t sensor, TCS34725_Data_t *data, uint16_t spread, uint64_t timestamp_us);
+uint8_t ColorBuffer_ReadLatest(uint8_t sensor, ColorBufferEntry_t *entry);
+uint8_t ColorBuffer_ReadByTimeOffset(uint8_t sensor, uint32_t timeOffsetMs, ColorBufferEntry_t *entry);
+uint8_t ColorBuffer_ReadByTimeOffsetUs(uint8_t sensor, uint64_t timeOffsetUs, ColorBufferEntry_t *entry);
 
 
 
@@ -0,0 +1,36 @@
+#ifndef CLOCK_PROFILE_H
+#define CLOCK_PROFILE_H
+
+#include <stdint.h>
+#include "main.h"
+
+// PROFILE ZEGARA (wszystkie z HSI 16 MHz)
+typedef enum {
+    CLOCK_PROFILE_LOW_POWER,    // HSI bez PLL, 16 MHz, skala 3
+    CLOCK_PROFILE_DEFAULT,      // PLL 84 MHz, skala 3 - konfiguracja CubeMX
+    CLOCK_PROFILE_MAX,          // PLL 180 MHz, skala 1 z overdrive
+    CLOCK_PROFILE_COUNT
+} ClockProfile_t;
+
+#define CLOCK_LOW_POWER_HZ      16000000U
+#define CLOCK_DEFAULT_HZ        84000000U
+#define CLOCK_MAX_HZ            180000000U
+
+// Profil po starcie, jesli zaden nie zostal zapamietany w rejestrze zapasowym RTC
+#ifndef CLOCK_PROFILE_BOOT
+#define CLOCK_PROFILE_BOOT      CLOCK_PROFILE_DEFAULT
+#endif
+
+#define CLOCK_BKP_TAG           0x434C4B00U   // "CLK" + profil w najmlodszym bajcie
+#define CLOCK_SWITCH_TIMEOUT_MS 20U           // Oczekiwanie na wolne magistrale I2C
+
+// Wywolac po TimeSync_Init (dostep do rejestrow zapasowych RTC)
+void Clock_Init(void);
+// Przelaczenie profilu; persist = 1 zapamietuje go jako profil po starcie.
+// HAL_BUSY - magistrala I2C nie zwolnila sie w CLOCK_SWITCH_TIMEOUT_MS.
+HAL_StatusTypeDef Clock_SetProfile(ClockProfile_t profile, uint8_t persist);
+ClockProfile_t Clock_GetProfile(void);
+ClockProfile_t Clock_GetBootProfile(void);
+uint32_t Clock_GetProfileHz(ClockProfile_t profile);
+
+#endif
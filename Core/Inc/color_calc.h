@@ -0,0 +1,36 @@
+#ifndef COLOR_CALC_H
+#define COLOR_CALC_H
+
+#include <stdint.h>
+#include "tcs34725.h"
+
+// WSPOLCZYNNIKI TAOS DN40 (x1000) DLA CZUJNIKA BEZ SZYBKI
+#define DN40_R_COEF     136
+#define DN40_G_COEF     1000
+#define DN40_B_COEF     (-444)
+#define DN40_DF         310      // Device factor
+#define DN40_CT_COEF    3810
+#define DN40_CT_OFFSET  1391
+
+// WARTOSCI ZWRACANE GDY WYNIK JEST NIEWIARYGODNY (NASYCENIE, R'=0)
+#define LUX_INVALID     99999999UL
+#define CCT_INVALID     99999U
+
+// FLAGI POL ODPOWIEDZI ANS (SETFMT)
+#define ANS_FMT_RAW     0x01
+#define ANS_FMT_LUX     0x02
+#define ANS_FMT_CCT     0x04
+#define ANS_FMT_TIME    0x08     // Czas bezwzgledny probki (po TIMESYNC)
+#define ANS_FMT_ALL     (ANS_FMT_RAW | ANS_FMT_LUX | ANS_FMT_CCT | ANS_FMT_TIME)
+
+typedef struct {
+    uint32_t lux_x100;   // Natezenie oswietlenia w 0.01 lx
+    uint32_t cct;        // Temperatura barwowa w K
+} ColorCalc_Result_t;
+
+uint16_t ColorCalc_AtimeCycles(uint8_t time_index);
+uint32_t ColorCalc_FullScale(uint8_t time_index);
+uint8_t ColorCalc_Compute(const TCS34725_Data_t *data, uint8_t gain_index,
+                          uint8_t time_index, ColorCalc_Result_t *result);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef COLOR_STATS_H
+#define COLOR_STATS_H
+
+#include <stdint.h>
+#include "tcs34725.h"
+
+// MAKSYMALNA DLUGOSC OKNA STATYSTYK (W PROBKACH)
+#define STATS_WINDOW_MAX      64
+#define STATS_WINDOW_DEFAULT  16
+
+// KANALY W KOLEJNOSCI ODPOWIEDZI ANS
+#define STATS_CH_R      0
+#define STATS_CH_G      1
+#define STATS_CH_B      2
+#define STATS_CH_C      3
+#define STATS_CHANNELS  4
+
+// Sumy sa liczone dokladnie na liczbach calkowitych, wiec srednia
+// i wariancja okna nie gromadza bledu zaokraglen przy przesuwaniu.
+typedef struct {
+    uint16_t window;                  // Zadana dlugosc okna
+    uint16_t count;                   // Liczba probek w oknie
+    uint32_t sum[STATS_CHANNELS];
+    uint64_t sum_sq[STATS_CHANNELS];
+    uint16_t min[STATS_CHANNELS];
+    uint16_t max[STATS_CHANNELS];
+} ColorStats_Snapshot_t;
+
+void ColorStats_Update(uint8_t sensor, const TCS34725_Data_t *data);
+uint8_t ColorStats_SetWindow(uint16_t window);
+uint16_t ColorStats_GetWindow(void);
+uint8_t ColorStats_Read(uint8_t sensor, ColorStats_Snapshot_t *snapshot);
+uint16_t ColorStats_Mean(const ColorStats_Snapshot_t *snapshot, uint8_t ch);
+uint32_t ColorStats_Variance(const ColorStats_Snapshot_t *snapshot, uint8_t ch);
+
+#endif
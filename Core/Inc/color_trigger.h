@@ -0,0 +1,35 @@
+#ifndef COLOR_TRIGGER_H
+#define COLOR_TRIGGER_H
+
+#include <stdint.h>
+#include "tcs34725.h"
+
+// LICZBA REGUL I ROZMIAR KOLEJKI ZDARZEN
+#define TRIGGER_RULES_MAX   4
+#define TRIGGER_EVENTS_MAX  8
+
+// TYPY REGUL (ZNAKI W PARAMETRZE SETTRG)
+#define TRIGGER_TYPE_OFF     'N'  // Regula wylaczona
+#define TRIGGER_TYPE_ABS     'A'  // Zmiana bezwzgledna kanalu w zliczeniach
+#define TRIGGER_TYPE_REL     'R'  // Zmiana wzgledna kanalu w promilach
+#define TRIGGER_TYPE_CHROMA  'D'  // Odleglosc chromatycznosci rg w 1/10000
+
+// PROG REGULY - 16 BITOW W SLOWIE KONFIGURACJI
+#define TRIGGER_THRESHOLD_MAX  0xFFFFU
+
+typedef struct {
+    uint8_t sensor;
+    uint8_t rule;
+    TCS34725_Data_t data;
+    uint32_t timestamp;
+} TriggerEvent_t;
+
+void ColorTrigger_Evaluate(uint8_t sensor, const TCS34725_Data_t *data, uint32_t timestamp);
+uint8_t ColorTrigger_SetRule(uint8_t index, char type, char channel,
+                             uint32_t threshold, const char *host);
+uint8_t ColorTrigger_GetRule(uint8_t index, char *type, char *channel, uint16_t *threshold);
+uint8_t ColorTrigger_HasEvents(void);
+uint8_t ColorTrigger_PopEvent(TriggerEvent_t *event);
+const char* ColorTrigger_GetHost(void);
+
+#endif
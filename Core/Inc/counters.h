@@ -0,0 +1,37 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+
+// LICZNIKI PRACY - narastajace od startu, przepelniaja sie modulo 2^32
+typedef enum {
+    CNT_RX_BYTES,           // Znaki odebrane przez USART2
+    CNT_RX_OVERRUNS,        // Znaki nadpisane w pelnym buforze odbiorczym
+    CNT_RX_FRAMES,          // Kompletne ramki przekazane do parse_frame
+    CNT_CRC_ERRORS,         // PARSE_CRC_ERROR
+    CNT_BAD_FRAMES,         // Odrzucone z odpowiedzia bledu (WRLEN, WRCMD, WRFRM)
+    CNT_IGNORED_FRAMES,     // Odrzucone bez odpowiedzi (za krotkie, inny odbiorca, zabronione znaki)
+    CNT_TX_BYTES,           // Znaki wyslane przez USART2
+    CNT_TX_OVERWRITES,      // Odpowiedzi nadpisujace niewyslane dane w buforze nadawczym
+    CNT_I2C_ERRORS,         // Bledy transferu zgloszone przez TCS34725_BusError
+    CNT_SAMPLES,            // Probki zapisane do archiwow
+    CNT_SAMPLES_SKIPPED,    // Odczyty pominiete - czujnik nie w stanie TCS_STATE_READY
+    CNT_COUNT
+} Counter_t;
+
+extern volatile uint32_t counters[CNT_COUNT];
+
+// Inkrementacja bez blokady przerwan (LDREX/STREX) - bezpieczna z kazdego poziomu
+static inline void Counter_Add(Counter_t cnt, uint32_t n) {
+    __atomic_fetch_add(&counters[cnt], n, __ATOMIC_RELAXED);
+}
+
+static inline void Counter_Inc(Counter_t cnt) {
+    Counter_Add(cnt, 1);
+}
+
+static inline uint32_t Counter_Get(Counter_t cnt) {
+    return counters[cnt];
+}
+
+#endif
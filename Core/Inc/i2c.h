@@ -41,7 +41,8 @@ extern I2C_HandleTypeDef hi2c1;
 void MX_I2C1_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+void I2C1_BusRecovery(void);
+void I2C1_UpdateClock(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
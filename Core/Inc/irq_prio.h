@@ -0,0 +1,50 @@
+#ifndef IRQ_PRIO_H
+#define IRQ_PRIO_H
+
+#include <stdint.h>
+#include "main.h"
+
+// POZIOMY PRIORYTETOW NVIC (NVIC_PRIORITYGROUP_4 - tylko wywlaszczanie, mniejszy = wazniejszy)
+// Wartosci musza odpowiadac HAL_NVIC_SetPriority w plikach CubeMX i .ioc
+#define IRQ_PRIO_TIMEBASE   0U    // TIM5 - nigdy nie maskowany, odczyt czasu bez blokady
+#define IRQ_PRIO_SENSOR     1U    // EXTI2 (INT), I2C1 EV/ER, DMA1 Stream0/6
+#define IRQ_PRIO_SAMPLING   2U    // TIM2 - tick probkowania
+#define IRQ_PRIO_UART       3U    // USART2
+#define IRQ_PRIO_TICK       15U   // SysTick (TICK_INT_PRIORITY)
+#define IRQ_PRIO_LEVELS     16U
+
+// PRZERWANIA OBJETE POMIAREM
+typedef enum {
+    IRQ_ID_EXTI2,
+    IRQ_ID_DMA1_S0,
+    IRQ_ID_DMA1_S6,
+    IRQ_ID_I2C1_EV,
+    IRQ_ID_I2C1_ER,
+    IRQ_ID_TIM2,
+    IRQ_ID_TIM5,
+    IRQ_ID_USART2,
+    IRQ_ID_SYSTICK,
+    IRQ_ID_COUNT
+} IrqId_t;
+
+// Wyniki w 0.1 us: najdluzsza obsluga i najgorsze opoznienie wejscia
+// (blokada sekcja krytyczna lub przerwaniem tego samego poziomu + wywlaszczenia wyzszych)
+typedef struct {
+    uint8_t prio;
+    uint32_t count;
+    uint32_t exec_max_x10;
+    uint32_t latency_max_x10;
+} IrqStats_t;
+
+// Wejscie do obslugi - znacznik DWT przekazywany do IrqStats_Exit
+static inline uint32_t IrqStats_Enter(void) {
+    return DWT->CYCCNT;
+}
+
+void IrqStats_Exit(IrqId_t id, uint32_t start_cycles);
+void IrqStats_Get(IrqId_t id, IrqStats_t *stats);
+
+uint32_t Irq_Lock(uint32_t prio);
+void Irq_Unlock(uint32_t key);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// OKNO POMIARU WSPOLCZYNNIKA WYPELNIENIA (CZAS PRACY RDZENIA)
+#define POWER_DUTY_WINDOW_MS  1000
+
+void Power_Init(void);
+void Power_Idle(void);
+uint16_t Power_GetDuty(void);
+uint32_t Power_GetWakeups(void);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "main.h"
+
+// Sondy czasu wykonania na liczniku cykli DWT. Wlaczone w konfiguracji Debug
+// (DEBUG) lub przez PROFILE_ENABLE; w wydaniu makra PROF_* znikaja.
+#if defined(DEBUG) && !defined(PROFILE_ENABLE)
+#define PROFILE_ENABLE 1
+#endif
+
+// MIERZONE MIEJSCA
+typedef enum {
+    PROF_SITE_PARSE_FRAME,
+    PROF_SITE_BUILD_RESPONSE,
+    PROF_SITE_CRC16,
+    PROF_SITE_PROCESS_CMD,
+    PROF_SITE_SENSOR_LOOP,
+    PROF_SITE_ISR_SENSOR,       // EXTI2, I2C1, DMA1 - z pomiaru IrqStats
+    PROF_SITE_ISR_SAMPLING,     // TIM2
+    PROF_SITE_ISR_UART,         // USART2
+    PROF_SITE_COUNT
+} ProfileSite_t;
+
+// Histogram log2: przedzial b to [2^b, 2^(b+1)) cykli, ostatni zbiera reszte
+#define PROF_HIST_BINS  16U
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_HIST_BINS];
+} ProfileStats_t;
+
+#if PROFILE_ENABLE
+#define PROF_BEGIN(site)        uint32_t prof_##site = DWT->CYCCNT
+#define PROF_END(site)          Profile_Record((site), DWT->CYCCNT - prof_##site)
+#else
+#define PROF_BEGIN(site)        ((void) 0)
+#define PROF_END(site)          ((void) 0)
+#endif
+
+void Profile_Init(void);
+void Profile_Record(ProfileSite_t site, uint32_t cycles);
+// Kopia statystyk miejsca; reset = 1 zeruje je po odczycie
+void Profile_Read(ProfileSite_t site, ProfileStats_t *stats, uint8_t reset);
+
+#endif
@@ -39,6 +39,32 @@
 #define CMD_STR_GETLED  "GETLED"
 #define CMD_STR_RDRAW   "RDRAW"
 #define CMD_STR_RDARC   "RDARC"
+#define CMD_STR_RDARCU  "RDARCU"
+#define CMD_STR_STATS   "STATS"
+#define CMD_STR_SETWIN  "SETWIN"
+#define CMD_STR_GETWIN  "GETWIN"
+#define CMD_STR_SETTRG  "SETTRG"
+#define CMD_STR_GETTRG  "GETTRG"
+#define CMD_STR_SETSRC  "SETSRC"
+#define CMD_STR_GETSRC  "GETSRC"
+#define CMD_STR_SETAUTO "SETAUTO"
+#define CMD_STR_GETAUTO "GETAUTO"
+#define CMD_STR_RDLUX   "RDLUX"
+#define CMD_STR_SETFMT  "SETFMT"
+#define CMD_STR_GETFMT  "GETFMT"
+#define CMD_STR_GETSNS  "GETSNS"
+#define CMD_STR_GETDUTY "GETDUTY"
+#define CMD_STR_SETOVS  "SETOVS"
+#define CMD_STR_GETOVS  "GETOVS"
+#define CMD_STR_TIMESYNC "TIMESYNC"
+#define CMD_STR_GETTASK "GETTASK"
+#define CMD_STR_GETIRQ  "GETIRQ"
+#define CMD_STR_PROFILE "PROFILE"
+#define CMD_STR_RDCNT   "RDCNT"
+#define CMD_STR_SETTRC  "SETTRC"
+#define CMD_STR_RDTRC   "RDTRC"
+#define CMD_STR_SETCLK  "SETCLK"
+#define CMD_STR_GETCLK  "GETCLK"
 
 //KOMENDY DLUGOSC PARAMETROW
 #define PARAM_LEN_SETINT    5
@@ -46,6 +72,19 @@
 #define PARAM_LEN_SETTIME   1
 #define PARAM_LEN_SETLED    1
 #define PARAM_LEN_RDARC     5
+#define PARAM_LEN_RDARCU    10
+#define PARAM_LEN_SETWIN    3
+#define PARAM_LEN_SETTRG    8
+#define PARAM_LEN_GETTRG    1
+#define PARAM_LEN_SETSRC    1
+#define PARAM_LEN_SETAUTO   1
+#define PARAM_LEN_SETFMT    1
+#define PARAM_LEN_SETOVS    3
+#define PARAM_LEN_TIMESYNC  32
+#define PARAM_LEN_PROFILE   1
+#define PARAM_LEN_SETTRC    1
+#define PARAM_LEN_RDTRC     10
+#define PARAM_LEN_SETCLK    2
 
 //KOMENDY ENUM
 typedef enum {
@@ -66,6 +105,40 @@ typedef enum {
 
     RDRAW_CMD,
     RDARC_CMD,
+    RDARCU_CMD,
+
+    STATS_CMD,
+    SETWIN_CMD,
+    GETWIN_CMD,
+
+    SETTRG_CMD,
+    GETTRG_CMD,
+
+    SETSRC_CMD,
+    GETSRC_CMD,
+
+    SETAUTO_CMD,
+    GETAUTO_CMD,
+
+    RDLUX_CMD,
+    SETFMT_CMD,
+    GETFMT_CMD,
+
+    GETSNS_CMD,
+    GETDUTY_CMD,
+
+    SETOVS_CMD,
+    GETOVS_CMD,
+
+    TIMESYNC_CMD,
+    GETTASK_CMD,
+    GETIRQ_CMD,
+    PROFILE_CMD,
+    RDCNT_CMD,
+    SETTRC_CMD,
+    RDTRC_CMD,
+    SETCLK_CMD,
+    GETCLK_CMD,
 } Command;
 
 //PREFIKSY I ODPOWIEDZ POTWIERDZAJACA
@@ -75,6 +148,28 @@ typedef enum {
 #define TIME_PREFIX         "TIME"
 #define LED_PREFIX          "LED"
 #define INT_PREFIX          "INT"
+#define STATS_PREFIX        "STAT"
+#define WIN_PREFIX          "WIN"
+#define TRG_PREFIX          "TRG"
+#define EVT_PREFIX          "EVT"
+#define SRC_PREFIX          "SRC"
+#define AUTO_PREFIX         "AUTO"
+#define LUX_PREFIX          "LUX"
+#define FMT_PREFIX          "FMT"
+#define SNS_PREFIX          "SNS"
+#define DUTY_PREFIX         "DUTY"
+#define OVS_PREFIX          "OVS"
+#define TSY_PREFIX          "TSY"
+#define TASK_PREFIX         "TASK"
+#define IRQ_PREFIX          "IRQ"
+#define PRF_PREFIX          "PRF"
+#define CNT_PREFIX          "CNT"
+#define TRC_PREFIX          "TRC"
+#define CLK_PREFIX          "CLK"
+
+// PRZYROSTEK WYBORU CZUJNIKA NA KONCU DANYCH, NP. RDRAW@1
+#define SENSOR_SUFFIX_CHAR  '@'
+#define SENSOR_SUFFIX_LEN   2
 
 //KODY BLEDOW TEKSTOWO
 #define WRCHSUM_STR "WRCHSUM"
@@ -84,6 +179,8 @@ typedef enum {
 #define WRFRM_STR "WRFRM"
 #define WRTIME_STR "WRTIME"
 #define NODATA_STR "NODATA"
+#define WRBUSY_STR "WRBUSY"
+#define WRSENS_STR "WRSENS"
 
 //KODY BŁEDÓW
 typedef enum {
@@ -94,6 +191,8 @@ typedef enum {
     WRFRM,
     WRTIME,
     NODATA,
+    WRBUSY,
+    WRSENS,
 } ErrorCode;
 
 // KODY BŁĘDÓW PARSOWANIA
@@ -128,6 +227,8 @@ typedef struct {
     char params[MAX_PAYLOAD_LEN + 1];  
     uint8_t params_len;                
     uint16_t crc;
+    uint8_t sensor;                    // Indeks czujnika z przyrostka @n (domyslnie 0)
+    uint64_t rx_us;                    // Odbior znaku startu ramki (Timebase_NowUs)
 } Frame;
 
 
@@ -137,13 +238,15 @@ ParseResult parse_frame(const char *buffer, size_t len, Frame *frame, char *resp
 uint16_t calculate_frame_crc(const Frame *frame);
 uint8_t build_response_frame(char *buffer, size_t buffer_size, const char *sender,
                          const char *receiver, uint8_t frame_id, const char *response_data, ErrorCode error);
+int hex_decode_string(const char *hex_str, char *output, size_t output_size);
+int hex_encode_string(const char *input, char *output, size_t output_size);
 void process_command(Frame *frame, char *response_buffer, size_t response_size);
 void process_protocol_data(void);
+void process_trigger_events(void);
 
 // GLOBALNE ZMIENNE
-extern volatile uint8_t current_gain_index;      // INDEKS GAIN
-extern volatile uint8_t current_time_index;      // INDEKS CZASU INTEGRACJI
 extern volatile uint8_t led_state;               // STAN LED
+extern volatile uint8_t ans_format;              // POLA ODPOWIEDZI ANS (ANS_FMT_*)
 
 // DLUGOSCI TABLIC USTAWIEN
 #define GAIN_VALUES_COUNT 4
@@ -152,6 +255,9 @@ extern volatile uint8_t led_state;               // STAN LED
 // TABLICA GAIN
 extern const uint8_t GAIN_TABLE[GAIN_VALUES_COUNT];
 
+// MNOZNIKI WZMOCNIENIA ODPOWIADAJACE GAIN_TABLE
+extern const uint8_t GAIN_MULTIPLIER[GAIN_VALUES_COUNT];
+
 // TABLICA CZASU INTEGRACJI
 extern const uint16_t TIME_TABLE[TIME_VALUES_COUNT];
 
@@ -0,0 +1,21 @@
+#ifndef RTC_CLOCK_H
+#define RTC_CLOCK_H
+
+#include <stdint.h>
+
+// Kalendarz RTC taktowany z LSE i rejestry zapasowe - przetrwaja reset (zasilanie VBAT)
+#define RTC_CLOCK_MAGIC        0x54535931U   // "TSY1" - kalendarz ustawiony przez TIMESYNC
+
+// REJESTRY ZAPASOWE
+#define RTC_CLOCK_BKP_MAGIC    0
+#define RTC_CLOCK_BKP_SUBUS    1   // us ponad pelna sekunde w chwili ustawienia kalendarza
+#define RTC_CLOCK_BKP_DRIFT    2   // Dryf TIM5 wzgledem czasu hosta w ppb (int32)
+#define RTC_CLOCK_BKP_CLOCK    3   // Profil zegara po starcie (CLOCK_BKP_TAG | profil)
+
+uint8_t RtcClock_Init(void);
+uint8_t RtcClock_Read(uint64_t *epoch_us);
+void RtcClock_Write(uint64_t epoch_us);
+uint32_t RtcClock_BackupRead(uint8_t reg);
+void RtcClock_BackupWrite(uint8_t reg, uint32_t value);
+
+#endif
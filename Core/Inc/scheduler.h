@@ -0,0 +1,37 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// FLAGI ZDARZEN - ustawiane z przerwan, kasowane przed uruchomieniem zadania
+#define SCHED_EVT_SENSOR    (1U << 0)   // Koniec transferu I2C/DMA, blad, INT, tick TIM2
+#define SCHED_EVT_UART_RX   (1U << 1)   // Odebrany znak UART
+#define SCHED_EVT_TRIGGER   (1U << 2)   // Zdarzenie wyzwalacza w kolejce
+#define SCHED_EVT_COUNT     3
+#define SCHED_EVT_ALL       ((1U << SCHED_EVT_COUNT) - 1)
+
+#define SCHED_TASKS_MAX     8
+#define SCHED_NO_DEADLINE   UINT32_MAX
+
+typedef void (*Sched_TaskFn_t)(void);
+
+// Statystyka zadania; opoznienie liczone od pierwszej flagi do startu zadania
+typedef struct {
+    uint32_t runs;
+    uint32_t latency_max_us;
+    uint32_t latency_avg_us;
+    uint32_t exec_max_us;
+} Sched_TaskStats_t;
+
+void Sched_Init(void);
+uint8_t Sched_AddTask(Sched_TaskFn_t fn, uint32_t events);
+void Sched_Signal(uint32_t events);
+void Sched_SignalAfter(uint32_t events, uint32_t delay_ms);
+void Sched_OnTick(void);
+uint32_t Sched_NextDeadline(void);
+uint8_t Sched_HasPending(void);
+void Sched_Run(void);
+uint8_t Sched_TaskCount(void);
+void Sched_GetStats(uint8_t task, Sched_TaskStats_t *stats);
+
+#endif
@@ -10,6 +10,10 @@
 //WYMAGANY BIT PRZED KAŻDYM ADRESEM
 #define TCS34725_COMMAND_BIT	0x80
 
+// Komenda funkcji specjalnej - kasowanie przerwania RGBC
+#define TCS34725_SPECIAL_FN       0x60
+#define TCS34725_SF_CLEAR_INT     0x06
+
 // Rejestry
 #define TCS34725_ENABLE           0x00
 #define TCS34725_ATIME            0x01 // Czas integracji
@@ -34,6 +38,24 @@
 #define TCS34725_ENABLE_AEN       0x02 // RGBC Enable
 #define TCS34725_ENABLE_PON       0x01 // Power on
 
+// Maski bitowe rejestru STATUS
+#define TCS34725_STATUS_AINT      0x10 // Przerwanie RGBC
+#define TCS34725_STATUS_AVALID    0x01 // Zakonczony cykl integracji
+
+// Maska bitowa rejestru CONFIG
+#define TCS34725_CONFIG_WLONG     0x02 // Czas oczekiwania x12
+
+// WTIME - krok oczekiwania 2.4ms, maksymalnie 256 krokow (x12 z WLONG)
+#define TCS34725_WTIME_STEP_01MS  24
+#define TCS34725_WTIME_MAX_STEPS  256
+#define TCS34725_WLONG_FACTOR     12
+// Najdluzsze oczekiwanie odmierzane przez czujnik - 256 krokow z WLONG (7372.8ms)
+#define TCS34725_WAIT_MAX_01MS    (TCS34725_WTIME_MAX_STEPS * TCS34725_WTIME_STEP_01MS \
+                                   * TCS34725_WLONG_FACTOR)
+
+// PERS - przerwanie po kazdym cyklu integracji
+#define TCS34725_PERS_EVERY_CYCLE 0x00
+
 // Czas integracji ATIME
 #define TCS34725_INTEGRATIONTIME_2_4MS  0xFF
 #define TCS34725_INTEGRATIONTIME_24MS   0xF6
@@ -54,9 +76,17 @@ typedef enum {
     TCS_STATE_POWERUP_WAIT,   // Czekanie na start PON (3ms)
     TCS_STATE_READY,          // Gotowy do pracy
     TCS_STATE_BUSY,           // Trwa odczyt DMA
+    TCS_STATE_CLEARING,       // Trwa kasowanie przerwania przez DMA
+    TCS_STATE_RECOVERY,       // Blad magistrali - odblokowanie i ponowna inicjalizacja
     TCS_STATE_ERROR           // Blad inicjalizacji (zly ID)
 } TCS_State_t;
 
+// Zrodlo wyzwalania odczytu
+typedef enum {
+    TCS_SOURCE_TIMER,         // Odczyt co timer_interval z TIM2
+    TCS_SOURCE_INT            // Odczyt po przerwaniu czujnika (nowa integracja)
+} TCS_Source_t;
+
 
 typedef struct {
     uint16_t c; // Clear
@@ -65,12 +95,131 @@ typedef struct {
     uint16_t b; // Blue
 } TCS34725_Data_t;
 
+// Minimalny odstep miedzy kolejnymi probami odblokowania magistrali
+#define TCS_RECOVERY_BACKOFF_MS  100
+
+// Liczba czujnikow i magistral I2C (konfiguracja w tablicach tcs_sensors / tcs_buses)
+#ifndef TCS_SENSOR_COUNT
+#define TCS_SENSOR_COUNT    1
+#endif
+#ifndef TCS_BUS_COUNT
+#define TCS_BUS_COUNT       1
+#endif
+
+// Multiplekser TCA9548A - wybor kanalu jednym bajtem maski
+#define TCA9548A_ADDRESS    (0x70 << 1)
+#define TCS_NO_MUX          0xFF     // Czujnik podlaczony bezposrednio do magistrali
+
+// Domyslne ustawienia czujnika po starcie
+#define TCS_DEFAULT_GAIN_INDEX  0    // 1x
+#define TCS_DEFAULT_TIME_INDEX  3    // 154ms
+
+// Nadprobkowanie - kolejne integracje usredniane w jednej probce archiwum
+#define TCS_OVERSAMPLE_MAX      16
+#define TCS_SPREAD_NONE         0xFFFF   // Rozrzut nie zapisywany
+
+// Kolejka transakcji I2C (jedna na magistrale)
+#define TCS_XFER_QUEUE_LEN  16
+#define TCS_XFER_DATA_LEN   8
+
+typedef enum {
+    TCS_XFER_READ,            // Odczyt rejestrow od adresu reg
+    TCS_XFER_WRITE            // Zapis bajtow z bufora data
+} TCS_XferType_t;
+
+typedef struct TCS34725_Xfer TCS34725_Xfer_t;
+typedef void (*TCS34725_XferCallback_t)(uint8_t sensor, TCS34725_Xfer_t *xfer);
+
+struct TCS34725_Xfer {
+    TCS_XferType_t type;
+    uint8_t sensor;                   // Indeks czujnika w tcs_sensors
+    uint8_t reg;                      // Adres rejestru z bitem komendy
+    uint8_t len;
+    uint8_t data[TCS_XFER_DATA_LEN];  // Bufor DMA tej transakcji
+    TCS34725_XferCallback_t callback; // Wywolywany z przerwania po zakonczeniu
+};
+
+// Operacje magistrali - na plytce HAL I2C z DMA (tcs34725_hal.c), na hoscie symulator.
+// Transfer konczy sie asynchronicznie wywolaniem TCS34725_BusComplete lub TCS34725_BusError.
+typedef struct {
+    HAL_StatusTypeDef (*mem_read)(void *ctx, uint16_t addr, uint8_t reg, uint8_t *data, uint16_t len);
+    HAL_StatusTypeDef (*write)(void *ctx, uint16_t addr, uint8_t *data, uint16_t len);
+    void (*abort)(void *ctx);         // Przerwanie transferu w toku
+    void (*recover)(void *ctx);       // Odblokowanie linii SDA/SCL i ponowna inicjalizacja
+} TCS34725_BusOps_t;
+
+// Magistrala I2C z wlasna kolejka - magistrale pracuja niezaleznie
+typedef struct {
+    const TCS34725_BusOps_t *ops;
+    void *ctx;                        // Uchwyt przekazywany do ops (np. I2C_HandleTypeDef)
+    TCS34725_Xfer_t queue[TCS_XFER_QUEUE_LEN];
+    volatile uint8_t head;            // Transakcja w toku lub nastepna
+    volatile uint8_t count;
+    volatile uint8_t active;          // Transakcja na magistrali
+    volatile uint8_t mux_channel;     // Wybrany kanal TCA9548A (TCS_NO_MUX - zaden)
+    volatile uint8_t mux_switching;   // Trwa zapis wyboru kanalu
+    volatile uint8_t error;           // Blad zgloszony w HAL_I2C_ErrorCallback
+    uint8_t mux_mask;                 // Bufor DMA dla wyboru kanalu
+    uint32_t recovery_tick;
+} TCS34725_Bus_t;
+
+// Instancja czujnika - konfiguracja polaczenia, stan i ustawienia
+typedef struct {
+    uint8_t bus;                      // Indeks w tcs_buses
+    uint8_t mux_channel;              // Kanal TCA9548A lub TCS_NO_MUX
+    GPIO_TypeDef *int_port;           // Linia INT czujnika (NULL - brak)
+    uint16_t int_pin;
+    volatile TCS_State_t state;
+    volatile uint8_t gain_index;      // Indeks GAIN_TABLE - ustawienie zadane
+    volatile uint8_t time_index;      // Indeks TIME_TABLE - ustawienie zadane
+    volatile uint8_t gain_applied;    // Indeks GAIN_TABLE w czujniku (zapis CONTROL zakonczony)
+    volatile uint8_t time_applied;    // Indeks TIME_TABLE w czujniku (zapis ATIME zakonczony)
+    uint32_t poweron_tick;
+    volatile uint8_t oversample;      // Integracje na probke (1 - bez usredniania)
+    volatile uint8_t keep_spread;     // Zapis rozrzutu kanalu C (max - min)
+    uint8_t ovs_count;                // Integracje zebrane w biezacej probce
+    uint8_t ovs_saturated;            // Ktoras z integracji nasycona
+    uint32_t ovs_sum[4];              // Sumy kanalow C, R, G, B
+    uint16_t ovs_min;
+    uint16_t ovs_max;
+    uint32_t ovs_read_tick;           // Odczyt poprzedniej integracji (tryb timera)
+    uint64_t ovs_first_us;            // Srodek pierwszej integracji probki
+    uint64_t int_us;                  // Zbocze INT - koniec integracji (0 - nieznany)
+    uint64_t read_start_us;           // Zlecenie odczytu danych
+    uint64_t read_done_us;            // Zakonczenie odczytu danych
+} TCS34725_Sensor_t;
+
 // Funkcje
-void TCS34725_Init(I2C_HandleTypeDef *hi2c);
-void TCS34725_WriteReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t value);
-void TCS34725_HandleLoop(I2C_HandleTypeDef *hi2c);
-void TCS34725_Start_DMA_Read(I2C_HandleTypeDef *hi2c);
+void TCS34725_Init(void);
+void TCS34725_InitSensor(uint8_t sensor);
+HAL_StatusTypeDef TCS34725_WriteReg(uint8_t sensor, uint8_t reg, uint8_t value);
+HAL_StatusTypeDef TCS34725_QueueWrite(uint8_t sensor, uint8_t reg, uint8_t value,
+                                      TCS34725_XferCallback_t callback);
+HAL_StatusTypeDef TCS34725_QueueRead(uint8_t sensor, uint8_t reg, uint8_t len,
+                                     TCS34725_XferCallback_t callback);
+HAL_StatusTypeDef TCS34725_SetGain(uint8_t sensor, uint8_t gain_index);
+HAL_StatusTypeDef TCS34725_SetTime(uint8_t sensor, uint8_t time_index);
+void TCS34725_HandleLoop(void);
+void TCS34725_Start_DMA_Read(uint8_t sensor);
+void TCS34725_SetSampleSource(TCS_Source_t source);
+void TCS34725_ApplyPacing(uint8_t sensor);
+void TCS34725_ApplyPacingAll(void);
+uint8_t TCS34725_NeedsTimer(void);
+void TCS34725_BusComplete(TCS34725_Bus_t *bus);
+void TCS34725_BusError(TCS34725_Bus_t *bus);
+void TCS34725_HoldBuses(uint8_t hold);
+uint8_t TCS34725_BusesIdle(void);
+uint16_t TCS34725_GetIntegrationTimeMs(uint8_t index);
+uint32_t TCS34725_GetSampleTimeMs(uint8_t sensor, uint8_t time_index);
+uint32_t TCS34725_GetMaxSampleTimeMs(void);
+void TCS34725_SetOversample(uint8_t sensor, uint8_t count, uint8_t keep_spread);
+void TCS34725_OnTimerTick(void);
+void TCS34725_OnInterrupt(uint16_t pin);
 
-extern volatile TCS_State_t sensor_state;
+extern TCS34725_Sensor_t tcs_sensors[TCS_SENSOR_COUNT];
+extern TCS34725_Bus_t tcs_buses[TCS_BUS_COUNT];
+extern volatile TCS_Source_t sample_source;
+extern volatile uint8_t sampling_active;
+extern volatile uint32_t tcs_recovery_count;
 
 #endif /* INC_TCS34725_H_ */
@@ -32,16 +32,21 @@ extern "C" {
 
 /* USER CODE END Includes */
 
-extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim2;
 
-/* USER CODE BEGIN Private defines */
+extern TIM_HandleTypeDef htim5;
 
+/* USER CODE BEGIN Private defines */
+#define TIM2_TICKS_PER_MS  10U
 /* USER CODE END Private defines */
 
-void MX_TIM3_Init(void);
+void MX_TIM2_Init(void);
+void MX_TIM5_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+void TIM2_SetSampleInterval(uint32_t interval_ms);
+void TIM2_StartSampling(uint32_t interval_ms);
+void TIM_UpdateClock(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
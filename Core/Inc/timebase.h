@@ -0,0 +1,11 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+// Czas w mikrosekundach od startu - TIM5 (32 bit, 1MHz) rozszerzony do 64 bitow
+void Timebase_Init(void);
+uint64_t Timebase_NowUs(void);
+void Timebase_OnOverflow(void);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <stdint.h>
+
+// ZRODLO CZASU BEZWZGLEDNEGO
+typedef enum {
+    TIMESYNC_NONE,     // Brak - tylko czas od startu
+    TIMESYNC_RTC,      // Odtworzony z RTC po resecie (rozdzielczosc 1/256 s)
+    TIMESYNC_HOST,     // Zsynchronizowany komenda TIMESYNC
+} TimeSync_Source_t;
+
+// Wymiana o opoznieniu w obie strony wiekszym od progu nie jest uwzgledniana
+#define TIMESYNC_MAX_DELAY_US   100000U
+// Minimalny odstep miedzy korektami do oceny dryfu i jego ograniczenie
+#define TIMESYNC_DRIFT_MIN_US   10000000U
+#define TIMESYNC_DRIFT_MAX_PPB  500000
+
+void TimeSync_Init(void);
+uint8_t TimeSync_Exchange(uint64_t t1_us, uint64_t t4_us, uint64_t rx_local_us);
+void TimeSync_SetTransmitTime(uint64_t tx_local_us);
+uint64_t TimeSync_ToEpochUs(uint64_t local_us);
+TimeSync_Source_t TimeSync_GetSource(void);
+int64_t TimeSync_GetLastOffsetUs(void);
+uint32_t TimeSync_GetLastDelayUs(void);
+int32_t TimeSync_GetDriftPpb(void);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "tim.h"
+
+// PIERSCIEN ZDARZEN - 8 bajtow na wpis, nadpisywany od najstarszego
+#define TRACE_LEN           256U    // Potega dwojki
+#define TRACE_PAGE_LEN      14U     // Wpisy w jednej odpowiedzi RDTRC
+
+// ZDARZENIA (argumenty a8 / a16)
+typedef enum {
+    TRC_NONE,
+    TRC_FRAME_START,    // Znak & w przerwaniu USART2 / poziom bufora RX
+    TRC_FRAME_END,      // Kompletna ramka w parserze / - / dlugosc ramki
+    TRC_PARSE,          // Wynik parse_frame: ParseResult / -
+    TRC_CMD_START,      // Command / identyfikator ramki
+    TRC_CMD_END,        // Command / identyfikator ramki
+    TRC_TX_LEVEL,       // Zajetosc bufora nadawczego po UART_TX_FSend: - / bajty
+    TRC_XFER_START,     // Start transakcji I2C: magistrala / czujnik << 8 | rejestr
+    TRC_XFER_DONE,      // Koniec transakcji I2C: magistrala / czujnik
+    TRC_BUS_ERROR,      // Blad magistrali: magistrala / -
+    TRC_STATE,          // Zmiana stanu czujnika: czujnik / TCS_State_t
+    TRC_SAMPLE,         // Probka w archiwum: czujnik / kanal C
+    TRC_TIMER_TICK,     // Tick probkowania TIM2
+    TRC_EVENT_COUNT
+} TraceEvent_t;
+
+typedef struct {
+    uint32_t time_us;   // Mlodsze 32 bity TIM5 (zawija co ~71.6 min)
+    uint8_t event;
+    uint8_t a8;
+    uint16_t a16;
+} TraceEntry_t;
+
+extern TraceEntry_t trace_ring[TRACE_LEN];
+extern volatile uint32_t trace_head;      // Numer nastepnego wpisu (narasta bez konca)
+extern volatile uint8_t trace_enabled;
+
+// Zapis z dowolnego poziomu przerwan: rezerwacja miejsca LDREX/STREX, bez blokady
+static inline void Trace_Event(TraceEvent_t event, uint8_t a8, uint16_t a16) {
+    if (!trace_enabled) {
+        return;
+    }
+    uint32_t seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    TraceEntry_t *entry = &trace_ring[seq & (TRACE_LEN - 1)];
+    entry->time_us = htim5.Instance->CNT;
+    entry->event = (uint8_t) event;
+    entry->a8 = a8;
+    entry->a16 = a16;
+}
+
+void Trace_Enable(uint8_t enable);
+// Kopiuje do max wpisow od numeru *seq (lub od najstarszego zachowanego);
+// *seq dostaje numer pierwszego skopiowanego wpisu. Zwraca liczbe wpisow.
+uint8_t Trace_Read(uint32_t *seq, TraceEntry_t *entries, uint8_t max);
+
+#endif
@@ -0,0 +1,98 @@
+#include "auto_gain.h"
+#include "protocol.h"
+#include "color_calc.h"
+
+volatile uint8_t auto_gain_enabled = 0;
+
+static uint8_t settle_samples[TCS_SENSOR_COUNT];
+
+extern volatile uint32_t timer_interval;
+
+
+// Czulosc ustawien: mnoznik wzmocnienia x liczba cykli integracji
+static uint32_t sensitivity(uint8_t gain_index, uint8_t time_index) {
+    return (uint32_t)GAIN_MULTIPLIER[gain_index] * ColorCalc_AtimeCycles(time_index);
+}
+
+// Czy dany czas integracji miesci sie w interwale probkowania
+static uint8_t time_fits(uint8_t sensor, uint8_t time_index) {
+    if (sample_source == TCS_SOURCE_INT && tcs_sensors[sensor].int_port != NULL) {
+        return 1; // Czujnik sam wyznacza tempo probkowania
+    }
+    return TCS34725_GetSampleTimeMs(sensor, time_index) < timer_interval;
+}
+
+// Zwiekszenie czulosci tylko gdy przewidywane wypelnienie pozostanie ponizej progu gornego
+static uint8_t step_fits(uint16_t clear, uint8_t gain_index, uint8_t time_index,
+                         uint8_t new_gain_index, uint8_t new_time_index) {
+    uint64_t predicted = (uint64_t)clear * sensitivity(new_gain_index, new_time_index)
+                         / sensitivity(gain_index, time_index);
+    return predicted * 1000 < (uint64_t)ColorCalc_FullScale(new_time_index) * AUTO_GAIN_HIGH_PERMILLE;
+}
+
+static void apply_settings(uint8_t sensor, uint8_t gain_index, uint8_t time_index) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+
+    if (gain_index != s->gain_index) {
+        if (TCS34725_SetGain(sensor, gain_index) == HAL_OK) {
+            settle_samples[sensor] = AUTO_GAIN_SETTLE_SAMPLES;
+        }
+    }
+    if (time_index != s->time_index) {
+        if (TCS34725_SetTime(sensor, time_index) == HAL_OK) {
+            settle_samples[sensor] = AUTO_GAIN_SETTLE_SAMPLES;
+            TCS34725_ApplyPacing(sensor);
+        }
+    }
+}
+
+void AutoGain_SetEnabled(uint8_t enabled) {
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        settle_samples[i] = 0;
+    }
+    auto_gain_enabled = enabled;
+}
+
+// Wywolywane z przerwania dla kazdej nowej probki - jeden krok regulacji
+void AutoGain_Process(uint8_t sensor, const TCS34725_Data_t *data) {
+    if (!auto_gain_enabled) {
+        return;
+    }
+    if (settle_samples[sensor] > 0) {
+        settle_samples[sensor]--;
+        return;
+    }
+
+    uint8_t gain_index = tcs_sensors[sensor].gain_index;
+    uint8_t time_index = tcs_sensors[sensor].time_index;
+    uint32_t fill_permille = (uint32_t)data->c * 1000 / ColorCalc_FullScale(time_index);
+
+    if (fill_permille >= AUTO_GAIN_HIGH_PERMILLE) {
+        // Nasycenie - najpierw zmniejszenie wzmocnienia, potem czasu integracji
+        if (gain_index > 0) {
+            apply_settings(sensor, gain_index - 1, time_index);
+        } else if (time_index > 0) {
+            apply_settings(sensor, gain_index, time_index - 1);
+        }
+    } else if (fill_permille < AUTO_GAIN_LOW_PERMILLE) {
+        // Slaby sygnal - najpierw dluzsza integracja (lepszy SNR), potem wzmocnienie
+        if (time_index + 1 < TIME_VALUES_COUNT && time_fits(sensor, time_index + 1)
+                && step_fits(data->c, gain_index, time_index, gain_index, time_index + 1)) {
+            apply_settings(sensor, gain_index, time_index + 1);
+        } else if (gain_index + 1 < GAIN_VALUES_COUNT
+                && step_fits(data->c, gain_index, time_index, gain_index + 1, time_index)) {
+            apply_settings(sensor, gain_index + 1, time_index);
+        }
+    }
+}
+
+// Skrocenie czasu integracji tak, aby miescil sie w nowym interwale
+void AutoGain_ClampToInterval(uint32_t interval_ms) {
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        uint8_t time_index = tcs_sensors[i].time_index;
+        while (time_index > 0 && TCS34725_GetSampleTimeMs(i, time_index) >= interval_ms) {
+            time_index--;
+        }
+        apply_settings(i, tcs_sensors[i].gain_index, time_index);
+    }
+}
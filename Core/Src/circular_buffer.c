@@ -1,6 +1,13 @@
 #include "main.h"
 #include "usart.h"
 #include "circular_buffer.h"
+#include "protocol.h"
+#include "color_stats.h"
+#include "color_trigger.h"
+#include "timebase.h"
+#include "irq_prio.h"
+#include "counters.h"
+#include "trace.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,6 +20,16 @@ volatile int UART_TX_Busy = 0;
 volatile int UART_RX_Empty = 0;
 volatile int UART_RX_Busy = 0;
 
+// Pary (pozycja znaku startu w UART_RxBuf, chwila odbioru) - kazda ramka czekajaca
+// w buforze RX zachowuje wlasny znacznik T2 do chwili jej przetworzenia
+typedef struct {
+	int pos;
+	uint64_t us;
+} UART_RxStamp_t;
+
+static UART_RxStamp_t rx_stamps[UART_RX_STAMPS];
+static uint8_t rx_stamp_next = 0;
+
 uint8_t UART_RX_IsEmpty(void) {
 	return (UART_RX_Empty == UART_RX_Busy);
 }
@@ -28,22 +45,52 @@ int16_t UART_RX_GetChar(void) {
 	}
 }
 
+// Wywolywane z przerwania USART2 dla odebranego znaku startu ramki
+void UART_RX_StampStart(int pos, uint64_t now_us) {
+	rx_stamps[rx_stamp_next].pos = pos;
+	rx_stamps[rx_stamp_next].us = now_us;
+	rx_stamp_next = (rx_stamp_next + 1) % UART_RX_STAMPS;
+}
+
+// Chwila odbioru znaku startu z pozycji pos; najnowszy znacznik tej pozycji jest
+// biezacy - starszy z poprzedniego obiegu bufora zostal juz nadpisany. 0 - brak.
+uint64_t UART_RX_StartTimeUs(int pos) {
+	uint64_t us = 0;
+	uint32_t key = Irq_Lock(IRQ_PRIO_UART);
+	for (uint8_t i = 1; i <= UART_RX_STAMPS; i++) {
+		const UART_RxStamp_t *stamp = &rx_stamps[(rx_stamp_next + UART_RX_STAMPS - i) % UART_RX_STAMPS];
+		if (stamp->pos == pos) {
+			us = stamp->us;
+			break;
+		}
+	}
+	Irq_Unlock(key);
+	return us;
+}
+
 void UART_TX_FSend(char *format, ...) {
-	char tmp_rs[128];
+	char tmp_rs[MAX_FRAME_LEN];
 	int i;
 	volatile int idx;
 	va_list arglist;
 	va_start(arglist, format);
-	vsprintf(tmp_rs, format, arglist);
+	vsnprintf(tmp_rs, sizeof(tmp_rs), format, arglist);
 	va_end(arglist);
+	int len = strlen(tmp_rs);
+	// Brak miejsca - nowe dane nadpisza jeszcze niewyslane
+	int used = (UART_TX_Empty - UART_TX_Busy + UART_TXBUF_LEN) % UART_TXBUF_LEN;
+	if (len > UART_TXBUF_LEN - 1 - used) {
+		Counter_Inc(CNT_TX_OVERWRITES);
+	}
 	idx = UART_TX_Empty;
-	for (i = 0; i < strlen(tmp_rs); i++) {
+	for (i = 0; i < len; i++) {
 		UART_TxBuf[idx] = tmp_rs[i];
 		idx++;
 		if (idx >= UART_TXBUF_LEN)
 			idx = 0;
 	}
-	__disable_irq();
+	// Maskowany tylko USART2 - przerwania czujnikow i timerow obsluguja sie dalej
+	uint32_t key = Irq_Lock(IRQ_PRIO_UART);
 	if ((UART_TX_Empty == UART_TX_Busy) && (__HAL_UART_GET_FLAG(&huart2, UART_FLAG_TXE) == SET)) {
 		UART_TX_Empty = idx;
 		uint8_t tmp = UART_TxBuf[UART_TX_Busy];
@@ -54,74 +101,125 @@ void UART_TX_FSend(char *format, ...) {
 	} else {
 		UART_TX_Empty = idx;
 	}
-	__enable_irq();
+	Irq_Unlock(key);
+	Trace_Event(TRC_TX_LEVEL, 0,
+			(UART_TX_Empty - UART_TX_Busy + UART_TXBUF_LEN) % UART_TXBUF_LEN);
 }
 
 
-// BUFER KOLOROWY
-ColorBufferEntry_t ColorBuffer[COLOR_BUFFER_SIZE];
-volatile uint32_t ColorBuffer_WritePos = 0;  // POZYCJA ZAPISU
-volatile uint8_t ColorBuffer_DataAvailable = 0;  // FLAGA CZY ROZPOCZETO ZBIERANIE DANYCH
+// BUFER KOLOROWY - osobne archiwum dla kazdego czujnika
+ColorArchive_t ColorBuffer[TCS_SENSOR_COUNT];
 
-uint8_t ColorBuffer_Put(TCS34725_Data_t *data, uint32_t timestamp) {
-    __disable_irq();
+// Jedynym zapisujacym archiwum czujnika jest callback DMA jego magistrali,
+// wiec nie blokujemy przerwan. Czytelnik wykrywa zapis po zmianie licznika
+// sekwencji i ponawia kopie.
+uint8_t ColorBuffer_Put(uint8_t sensor, TCS34725_Data_t *data, uint16_t spread, uint64_t timestamp_us) {
+    ColorArchive_t *archive = &ColorBuffer[sensor];
+    ColorBufferEntry_t *entry = &archive->entries[archive->write_pos];
 
-    ColorBuffer[ColorBuffer_WritePos].data = *data;
-    ColorBuffer[ColorBuffer_WritePos].timestamp = timestamp;
-    ColorBuffer_WritePos = (ColorBuffer_WritePos + 1) % COLOR_BUFFER_SIZE;
+    archive->seq++;
+    __DMB();
 
-    ColorBuffer_DataAvailable = 1;
+    entry->data = *data;
+    entry->timestamp_us = timestamp_us;
+    entry->gain_index = tcs_sensors[sensor].gain_applied;
+    entry->time_index = tcs_sensors[sensor].time_applied;
+    entry->spread = spread;
+    archive->write_pos = (archive->write_pos + 1) % COLOR_BUFFER_SIZE;
 
-    __enable_irq();
+    archive->data_available = 1;
+
+    __DMB();
+    archive->seq++;
+    Counter_Inc(CNT_SAMPLES);
+    Trace_Event(TRC_SAMPLE, sensor, data->c);
+
+    ColorStats_Update(sensor, data);
+    ColorTrigger_Evaluate(sensor, data, (uint32_t)(timestamp_us / 1000));
 
     return 1;
 }
 
-ColorBufferEntry_t* ColorBuffer_GetLatest(void) {
+// Kopiuje najnowszy wpis, ponawia jesli w trakcie kopiowania nastapil zapis
+uint8_t ColorBuffer_ReadLatest(uint8_t sensor, ColorBufferEntry_t *entry) {
+    ColorArchive_t *archive = &ColorBuffer[sensor];
+    uint32_t seq;
 
-    if (!ColorBuffer_DataAvailable) {
-        return NULL;
-    }
+    do {
+        seq = archive->seq;
+        __DMB();
 
-    uint32_t latest_index;
-    if (ColorBuffer_WritePos == 0) {
-        latest_index = COLOR_BUFFER_SIZE - 1;
-    } else {
-        latest_index = ColorBuffer_WritePos - 1;
-    }
+        if (!archive->data_available) {
+            return 0;
+        }
+
+        uint32_t latest_index;
+        if (archive->write_pos == 0) {
+            latest_index = COLOR_BUFFER_SIZE - 1;
+        } else {
+            latest_index = archive->write_pos - 1;
+        }
+
+        *entry = archive->entries[latest_index];
+
+        __DMB();
+    } while ((seq & 1) || seq != archive->seq);
+
+    return 1;
+}
 
-    return &ColorBuffer[latest_index];
+// Kopiuje wpis sprzed timeOffsetMs
+uint8_t ColorBuffer_ReadByTimeOffset(uint8_t sensor, uint32_t timeOffsetMs, ColorBufferEntry_t *entry) {
+    return ColorBuffer_ReadByTimeOffsetUs(sensor, (uint64_t)timeOffsetMs * 1000, entry);
 }
 
-ColorBufferEntry_t* ColorBuffer_GetByTimeOffset(uint32_t timeOffsetMs) {
+// Kopiuje wpis sprzed timeOffsetUs, ponawia wyszukiwanie jesli nastapil zapis
+uint8_t ColorBuffer_ReadByTimeOffsetUs(uint8_t sensor, uint64_t timeOffsetUs, ColorBufferEntry_t *entry) {
+    ColorArchive_t *archive = &ColorBuffer[sensor];
 
-    uint32_t maxOffset = COLOR_BUFFER_SIZE * timer_interval;
-    if (timeOffsetMs == 0 || timeOffsetMs > maxOffset) {
-        return NULL;
+    uint64_t maxOffset = (uint64_t)COLOR_BUFFER_SIZE * timer_interval * 1000;
+    if (timeOffsetUs == 0 || timeOffsetUs > maxOffset) {
+        return 0;
     }
 
-    uint32_t currentTime = HAL_GetTick();
-    uint32_t targetTime = currentTime - timeOffsetMs;
-
-    uint32_t index;
-    if (ColorBuffer_WritePos == 0) {
-        index = COLOR_BUFFER_SIZE - 1;
-    } else {
-        index = ColorBuffer_WritePos - 1;
+    uint64_t currentTime = Timebase_NowUs();
+    if (timeOffsetUs > currentTime) {
+        return 0;
     }
+    uint64_t targetTime = currentTime - timeOffsetUs;
 
-    for (uint32_t i = 0; i < COLOR_BUFFER_SIZE; i++) {
-        if (ColorBuffer[index].timestamp <= targetTime) {
-            return &ColorBuffer[index];
-        }
+    uint32_t seq;
+    uint8_t found;
 
-        if (index == 0) {
+    do {
+        seq = archive->seq;
+        __DMB();
+
+        found = 0;
+
+        uint32_t index;
+        if (archive->write_pos == 0) {
             index = COLOR_BUFFER_SIZE - 1;
         } else {
-            index--;
+            index = archive->write_pos - 1;
         }
-    }
-    return NULL;
-}
 
+        for (uint32_t i = 0; i < COLOR_BUFFER_SIZE; i++) {
+            if (archive->entries[index].timestamp_us <= targetTime) {
+                *entry = archive->entries[index];
+                found = 1;
+                break;
+            }
+
+            if (index == 0) {
+                index = COLOR_BUFFER_SIZE - 1;
+            } else {
+                index--;
+            }
+        }
+
+        __DMB();
+    } while ((seq & 1) || seq != archive->seq);
 
+    return found;
+}
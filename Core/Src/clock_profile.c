@@ -0,0 +1,176 @@
+#include "clock_profile.h"
+#include "tim.h"
+#include "usart.h"
+#include "i2c.h"
+#include "tcs34725.h"
+#include "rtc_clock.h"
+#include "irq_prio.h"
+#include "scheduler.h"
+
+typedef struct {
+    uint32_t sysclk_hz;
+    uint32_t pll_n;             // VCO = HSI / 16 * N; 0 - SYSCLK prosto z HSI
+    uint32_t pll_p;
+    uint32_t voltage_scale;
+    uint8_t overdrive;
+    uint32_t apb1_div;          // PCLK1 max 45 MHz
+    uint32_t apb2_div;          // PCLK2 max 90 MHz
+    uint32_t flash_latency;     // Dla 2.7 - 3.6 V
+} ClockConfig_t;
+
+static const ClockConfig_t clock_configs[CLOCK_PROFILE_COUNT] = {
+    [CLOCK_PROFILE_LOW_POWER] = { CLOCK_LOW_POWER_HZ, 0, 0, PWR_REGULATOR_VOLTAGE_SCALE3, 0,
+                                  RCC_HCLK_DIV1, RCC_HCLK_DIV1, FLASH_LATENCY_0 },
+    [CLOCK_PROFILE_DEFAULT]   = { CLOCK_DEFAULT_HZ, 336, RCC_PLLP_DIV4, PWR_REGULATOR_VOLTAGE_SCALE3, 0,
+                                  RCC_HCLK_DIV2, RCC_HCLK_DIV1, FLASH_LATENCY_2 },
+    [CLOCK_PROFILE_MAX]       = { CLOCK_MAX_HZ, 360, RCC_PLLP_DIV2, PWR_REGULATOR_VOLTAGE_SCALE1, 1,
+                                  RCC_HCLK_DIV4, RCC_HCLK_DIV2, FLASH_LATENCY_5 },
+};
+
+// SystemClock_Config (CubeMX) odpowiada profilowi domyslnemu
+static ClockProfile_t current_profile = CLOCK_PROFILE_DEFAULT;
+static uint8_t overdrive_on = 0;
+
+
+// Peryferia zalezne od PCLK1 - wywolywane po kazdej zmianie SYSCLK lub dzielnikow,
+// takze w polowie przelaczenia (na HSI), aby TIM5 nie odmierzal czasu zlym taktem
+static void update_peripherals(void) {
+    uint32_t key = Irq_Lock(IRQ_PRIO_SENSOR);
+    TIM_UpdateClock();
+    Irq_Unlock(key);
+    USART2_UpdateClock();
+    I2C1_UpdateClock();
+}
+
+static HAL_StatusTypeDef switch_sysclk(uint32_t source, uint32_t apb1_div, uint32_t apb2_div,
+                                       uint32_t flash_latency) {
+    RCC_ClkInitTypeDef clk = {0};
+
+    clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+                    | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+    clk.SYSCLKSource = source;
+    clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+    clk.APB1CLKDivider = apb1_div;
+    clk.APB2CLKDivider = apb2_div;
+    HAL_StatusTypeDef status = HAL_RCC_ClockConfig(&clk, flash_latency);
+    update_peripherals();
+    return status;
+}
+
+// PLL, skale napiecia i overdrive mozna zmieniac tylko, gdy rdzen nie pracuje z PLL,
+// wiec kazde przelaczenie przechodzi przez HSI
+static HAL_StatusTypeDef apply_config(const ClockConfig_t *cfg) {
+    RCC_OscInitTypeDef osc = {0};
+
+    if (switch_sysclk(RCC_SYSCLKSOURCE_HSI, RCC_HCLK_DIV1, RCC_HCLK_DIV1, FLASH_LATENCY_0) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    if (overdrive_on && !cfg->overdrive) {
+        if (HAL_PWREx_DisableOverDrive() != HAL_OK) {
+            return HAL_ERROR;
+        }
+        overdrive_on = 0;
+    }
+
+    osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    osc.PLL.PLLState = RCC_PLL_OFF;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    __HAL_PWR_VOLTAGESCALING_CONFIG(cfg->voltage_scale);
+
+    if (cfg->pll_n == 0) {
+        // 16 MHz prosto z HSI - PLL pozostaje wylaczony
+        return switch_sysclk(RCC_SYSCLKSOURCE_HSI, cfg->apb1_div, cfg->apb2_div, cfg->flash_latency);
+    }
+
+    osc.PLL.PLLState = RCC_PLL_ON;
+    osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+    osc.PLL.PLLM = 16;
+    osc.PLL.PLLN = cfg->pll_n;
+    osc.PLL.PLLP = cfg->pll_p;
+    osc.PLL.PLLQ = 2;
+    osc.PLL.PLLR = 2;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    if (cfg->overdrive && !overdrive_on) {
+        if (HAL_PWREx_EnableOverDrive() != HAL_OK) {
+            return HAL_ERROR;
+        }
+        overdrive_on = 1;
+    }
+    return switch_sysclk(RCC_SYSCLKSOURCE_PLLCLK, cfg->apb1_div, cfg->apb2_div, cfg->flash_latency);
+}
+
+void Clock_Init(void) {
+    ClockProfile_t boot = Clock_GetBootProfile();
+
+    current_profile = CLOCK_PROFILE_DEFAULT;
+    overdrive_on = 0;
+    if (boot != current_profile) {
+        Clock_SetProfile(boot, 0);
+    }
+}
+
+// Na czas przelaczenia: transakcje I2C wstrzymane (CCR i TRISE zaleza od PCLK1),
+// nadajnik USART2 zatrzymany po biezacym bajcie. Znak odbierany w trakcie
+// przelaczenia moze zostac przeklamany - host ponawia ramke po bledzie CRC.
+HAL_StatusTypeDef Clock_SetProfile(ClockProfile_t profile, uint8_t persist) {
+    if (profile >= CLOCK_PROFILE_COUNT) {
+        return HAL_ERROR;
+    }
+
+    if (profile != current_profile) {
+        uint32_t start = HAL_GetTick();
+
+        TCS34725_HoldBuses(1);
+        while (!TCS34725_BusesIdle()) {
+            if (HAL_GetTick() - start > CLOCK_SWITCH_TIMEOUT_MS) {
+                TCS34725_HoldBuses(0);
+                return HAL_BUSY;
+            }
+        }
+
+        HAL_NVIC_DisableIRQ(USART2_IRQn);
+        while (__HAL_UART_GET_FLAG(&huart2, UART_FLAG_TC) == RESET
+                && HAL_GetTick() - start <= CLOCK_SWITCH_TIMEOUT_MS) {
+        }
+
+        HAL_StatusTypeDef status = apply_config(&clock_configs[profile]);
+        if (status == HAL_OK) {
+            current_profile = profile;
+        } else if (apply_config(&clock_configs[current_profile]) != HAL_OK) {
+            Error_Handler();
+        }
+
+        HAL_NVIC_EnableIRQ(USART2_IRQn);
+        TCS34725_HoldBuses(0);
+        Sched_Signal(SCHED_EVT_SENSOR);
+        if (status != HAL_OK) {
+            return status;
+        }
+    }
+
+    if (persist) {
+        RtcClock_BackupWrite(RTC_CLOCK_BKP_CLOCK, CLOCK_BKP_TAG | profile);
+    }
+    return HAL_OK;
+}
+
+ClockProfile_t Clock_GetProfile(void) {
+    return current_profile;
+}
+
+ClockProfile_t Clock_GetBootProfile(void) {
+    uint32_t stored = RtcClock_BackupRead(RTC_CLOCK_BKP_CLOCK);
+
+    if ((stored & 0xFFFFFF00U) == CLOCK_BKP_TAG && (stored & 0xFFU) < CLOCK_PROFILE_COUNT) {
+        return (ClockProfile_t)(stored & 0xFFU);
+    }
+    return CLOCK_PROFILE_BOOT;
+}
+
+uint32_t Clock_GetProfileHz(ClockProfile_t profile) {
+    return profile < CLOCK_PROFILE_COUNT ? clock_configs[profile].sysclk_hz : 0;
+}
@@ -0,0 +1,65 @@
+#include "color_calc.h"
+#include "protocol.h"
+
+// Liczba cykli integracji 2.4ms dla indeksu czasu
+uint16_t ColorCalc_AtimeCycles(uint8_t time_index) {
+    return 256 - (TIME_TABLE[time_index] & 0xFF);
+}
+
+// Maksymalna wartosc kanalu clear dla danego czasu integracji
+uint32_t ColorCalc_FullScale(uint8_t time_index) {
+    uint32_t max_count = (uint32_t)ColorCalc_AtimeCycles(time_index) * 1024;
+    return max_count > 65535 ? 65535 : max_count;
+}
+
+// Lux i CCT wedlug TAOS DN40 na liczbach calkowitych.
+// Zwraca 0 gdy kanal clear jest nasycony - wtedy wyniki maja wartosci *_INVALID.
+uint8_t ColorCalc_Compute(const TCS34725_Data_t *data, uint8_t gain_index,
+                          uint8_t time_index, ColorCalc_Result_t *result) {
+    result->lux_x100 = LUX_INVALID;
+    result->cct = CCT_INVALID;
+
+    if (gain_index >= GAIN_VALUES_COUNT || time_index >= TIME_VALUES_COUNT) {
+        return 0;
+    }
+
+    // Nasycenie analogowe (pelna skala) lub cyfrowe (licznik 16-bit)
+    if (data->c >= ColorCalc_FullScale(time_index)) {
+        return 0;
+    }
+
+    // Kompensacja IR liczona w polowkach zliczen, aby nie obcinac IR = (R+G+B-C)/2
+    int32_t ir2 = (int32_t)data->r + data->g + data->b - data->c;
+    if (ir2 < 0) {
+        ir2 = 0;
+    }
+    int32_t r = 2 * (int32_t)data->r - ir2;
+    int32_t g = 2 * (int32_t)data->g - ir2;
+    int32_t b = 2 * (int32_t)data->b - ir2;
+
+    // 2 * G'' x1000
+    int32_t g2_milli = DN40_R_COEF * r + DN40_G_COEF * g + DN40_B_COEF * b;
+
+    // CPL = (ATIME_ms * AGAINx) / DF, przy ATIME w 0.1 ms skale sie skracaja:
+    // lux x100 = G''x1000 * DF / (ATIME_01ms * AGAINx)
+    uint32_t atime_01ms = (uint32_t)ColorCalc_AtimeCycles(time_index) * 24;
+    uint32_t cpl_den = 2 * atime_01ms * GAIN_MULTIPLIER[gain_index];
+
+    if (g2_milli <= 0) {
+        result->lux_x100 = 0;
+    } else {
+        uint64_t lux = ((uint64_t)g2_milli * DN40_DF + cpl_den / 2) / cpl_den;
+        result->lux_x100 = lux >= LUX_INVALID ? LUX_INVALID : (uint32_t)lux;
+    }
+
+    if (b < 0) {
+        b = 0;
+    }
+    if (r > 0) {
+        uint32_t cct = ((uint32_t)DN40_CT_COEF * (uint32_t)b + (uint32_t)r / 2) / (uint32_t)r
+                       + DN40_CT_OFFSET;
+        result->cct = cct >= CCT_INVALID ? CCT_INVALID : cct;
+    }
+
+    return 1;
+}
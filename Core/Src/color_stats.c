@@ -0,0 +1,166 @@
+#include "main.h"
+#include "color_stats.h"
+#include <string.h>
+
+// Stan statystyk jednego czujnika
+typedef struct {
+    // Okno probek dla kazdego kanalu
+    uint16_t window_values[STATS_CHANNELS][STATS_WINDOW_MAX];
+
+    // Kolejki monotoniczne z numerami probek (min rosnaco, max malejaco)
+    uint32_t min_deque[STATS_CHANNELS][STATS_WINDOW_MAX];
+    uint32_t max_deque[STATS_CHANNELS][STATS_WINDOW_MAX];
+    uint8_t min_head[STATS_CHANNELS], min_len[STATS_CHANNELS];
+    uint8_t max_head[STATS_CHANNELS], max_len[STATS_CHANNELS];
+
+    uint32_t sample_no;              // Numer kolejnej probki
+
+    ColorStats_Snapshot_t stats;
+    volatile uint32_t seq;           // Licznik sekwencji (nieparzysty = trwa zapis)
+    volatile uint8_t reset_pending;
+} ColorStats_State_t;
+
+static ColorStats_State_t sensor_stats[TCS_SENSOR_COUNT];
+
+// Dlugosc okna jest wspolna dla wszystkich czujnikow
+static volatile uint16_t requested_window = STATS_WINDOW_DEFAULT;
+
+
+static uint16_t channel_value(const TCS34725_Data_t *data, uint8_t ch) {
+    switch (ch) {
+        case STATS_CH_R: return data->r;
+        case STATS_CH_G: return data->g;
+        case STATS_CH_B: return data->b;
+        default:         return data->c;
+    }
+}
+
+static void stats_reset(ColorStats_State_t *st, uint16_t window) {
+    memset(&st->stats, 0, sizeof(st->stats));
+    st->stats.window = window;
+    memset(st->min_len, 0, sizeof(st->min_len));
+    memset(st->max_len, 0, sizeof(st->max_len));
+    memset(st->min_head, 0, sizeof(st->min_head));
+    memset(st->max_head, 0, sizeof(st->max_head));
+    st->sample_no = 0;
+}
+
+// Przesuniecie kolejki monotonicznej o nowa probke; keep_smaller wybiera min/max
+static uint16_t deque_push(uint32_t *deque, uint8_t *head, uint8_t *len,
+                           const uint16_t *values, uint16_t window,
+                           uint32_t no, uint16_t value, uint8_t keep_smaller) {
+    // Usuniecie probek, ktore wypadly z okna
+    if (*len > 0 && no - deque[*head] >= window) {
+        *head = (*head + 1) % STATS_WINDOW_MAX;
+        (*len)--;
+    }
+
+    // Usuniecie z konca probek, ktore juz nigdy nie beda ekstremum
+    while (*len > 0) {
+        uint8_t tail = (*head + *len - 1) % STATS_WINDOW_MAX;
+        uint16_t tail_value = values[deque[tail] % window];
+        if (keep_smaller ? (tail_value < value) : (tail_value > value)) {
+            break;
+        }
+        (*len)--;
+    }
+
+    deque[(*head + *len) % STATS_WINDOW_MAX] = no;
+    (*len)++;
+
+    return values[deque[*head] % window];
+}
+
+// Wywolywane z kontekstu przerwania po kazdym ColorBuffer_Put, O(1)
+void ColorStats_Update(uint8_t sensor, const TCS34725_Data_t *data) {
+    ColorStats_State_t *st = &sensor_stats[sensor];
+    ColorStats_Snapshot_t *stats = &st->stats;
+
+    st->seq++;
+    __DMB();
+
+    // Okno 0 - stan jeszcze nie zainicjalizowany
+    if (st->reset_pending || stats->window == 0) {
+        st->reset_pending = 0;
+        stats_reset(st, requested_window);
+    }
+
+    uint16_t window = stats->window;
+    uint16_t slot = st->sample_no % window;
+    uint8_t full = (stats->count >= window);
+
+    for (uint8_t ch = 0; ch < STATS_CHANNELS; ch++) {
+        uint16_t value = channel_value(data, ch);
+
+        if (full) {
+            uint16_t oldest = st->window_values[ch][slot];
+            stats->sum[ch] -= oldest;
+            stats->sum_sq[ch] -= (uint32_t)oldest * oldest;
+        }
+        st->window_values[ch][slot] = value;
+        stats->sum[ch] += value;
+        stats->sum_sq[ch] += (uint32_t)value * value;
+
+        stats->min[ch] = deque_push(st->min_deque[ch], &st->min_head[ch], &st->min_len[ch],
+                                    st->window_values[ch], window, st->sample_no, value, 1);
+        stats->max[ch] = deque_push(st->max_deque[ch], &st->max_head[ch], &st->max_len[ch],
+                                    st->window_values[ch], window, st->sample_no, value, 0);
+    }
+
+    if (!full) {
+        stats->count++;
+    }
+    st->sample_no++;
+
+    __DMB();
+    st->seq++;
+}
+
+// Zmiana okna jest wykonywana przy nastepnej probce w kontekscie zapisujacego
+uint8_t ColorStats_SetWindow(uint16_t window) {
+    if (window == 0 || window > STATS_WINDOW_MAX) {
+        return 0;
+    }
+    requested_window = window;
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        sensor_stats[i].reset_pending = 1;
+    }
+    return 1;
+}
+
+uint16_t ColorStats_GetWindow(void) {
+    return requested_window;
+}
+
+// Kopia stanu statystyk, ponawiana jesli w trakcie nastapila aktualizacja
+uint8_t ColorStats_Read(uint8_t sensor, ColorStats_Snapshot_t *snapshot) {
+    ColorStats_State_t *st = &sensor_stats[sensor];
+    uint32_t seq;
+
+    do {
+        seq = st->seq;
+        __DMB();
+        *snapshot = st->stats;
+        __DMB();
+    } while ((seq & 1) || seq != st->seq);
+
+    return snapshot->count > 0;
+}
+
+uint16_t ColorStats_Mean(const ColorStats_Snapshot_t *snapshot, uint8_t ch) {
+    if (snapshot->count == 0) {
+        return 0;
+    }
+    return (uint16_t)((snapshot->sum[ch] + snapshot->count / 2) / snapshot->count);
+}
+
+// Wariancja z proby: (n*sum(x^2) - sum(x)^2) / (n*(n-1))
+uint32_t ColorStats_Variance(const ColorStats_Snapshot_t *snapshot, uint8_t ch) {
+    uint32_t n = snapshot->count;
+    if (n < 2) {
+        return 0;
+    }
+    uint64_t sum = snapshot->sum[ch];
+    uint64_t numerator = n * snapshot->sum_sq[ch] - sum * sum;
+    return (uint32_t)(numerator / ((uint64_t)n * (n - 1)));
+}
@@ -0,0 +1,167 @@
+#include "main.h"
+#include "color_trigger.h"
+#include "protocol.h"
+#include "scheduler.h"
+#include <string.h>
+
+// Regula spakowana w jedno slowo (typ | kanal | prog), zapis atomowy z petli glownej
+#define RULE_PACK(type, ch, thr)  (((uint32_t)(type) << 24) | ((uint32_t)(ch) << 16) | (thr))
+#define RULE_TYPE(rule)           ((char)((rule) >> 24))
+#define RULE_CHANNEL(rule)        ((char)(((rule) >> 16) & 0xFF))
+#define RULE_THRESHOLD(rule)      ((uint16_t)((rule) & 0xFFFF))
+
+static volatile uint32_t rule_config[TRIGGER_RULES_MAX];
+
+// Stan uzywany tylko w kontekscie przerwania - reguly wspolne, odniesienie osobne dla czujnika
+static uint32_t rule_applied[TCS_SENSOR_COUNT][TRIGGER_RULES_MAX];
+static uint8_t reference_valid[TCS_SENSOR_COUNT][TRIGGER_RULES_MAX];
+static TCS34725_Data_t reference[TCS_SENSOR_COUNT][TRIGGER_RULES_MAX];
+
+// Kolejka zdarzen: zapis w przerwaniach I2C (rowny priorytet, bez wywlaszczania),
+// odczyt w petli glownej
+static TriggerEvent_t events[TRIGGER_EVENTS_MAX];
+static volatile uint8_t events_head = 0;
+static volatile uint8_t events_tail = 0;
+
+// Adres hosta, do ktorego wysylane sa zdarzenia
+static char trigger_host[FIELD_ADDR_LEN + 1] = "";
+
+
+static uint16_t channel_value(const TCS34725_Data_t *data, char channel) {
+    switch (channel) {
+        case 'R': return data->r;
+        case 'G': return data->g;
+        case 'B': return data->b;
+        default:  return data->c;
+    }
+}
+
+// Odleglosc^2 we wspolrzednych r = R/(R+G+B), g = G/(R+G+B) skalowanych x10000
+static uint32_t chroma_distance_sq(const TCS34725_Data_t *a, const TCS34725_Data_t *b) {
+    uint32_t sum_a = (uint32_t)a->r + a->g + a->b;
+    uint32_t sum_b = (uint32_t)b->r + b->g + b->b;
+    if (sum_a == 0 || sum_b == 0) {
+        return 0;
+    }
+    int32_t dr = (int32_t)(a->r * 10000UL / sum_a) - (int32_t)(b->r * 10000UL / sum_b);
+    int32_t dg = (int32_t)(a->g * 10000UL / sum_a) - (int32_t)(b->g * 10000UL / sum_b);
+    return (uint32_t)(dr * dr + dg * dg);
+}
+
+static uint8_t rule_matches(uint32_t rule, const TCS34725_Data_t *ref, const TCS34725_Data_t *data) {
+    uint16_t threshold = RULE_THRESHOLD(rule);
+    uint16_t now = channel_value(data, RULE_CHANNEL(rule));
+    uint16_t before = channel_value(ref, RULE_CHANNEL(rule));
+    uint32_t delta = (now > before) ? (now - before) : (before - now);
+
+    switch (RULE_TYPE(rule)) {
+        case TRIGGER_TYPE_ABS:
+            return delta >= threshold;
+        case TRIGGER_TYPE_REL:
+            return delta * 1000UL >= (uint32_t)threshold * (before ? before : 1);
+        case TRIGGER_TYPE_CHROMA:
+            return chroma_distance_sq(data, ref) >= (uint32_t)threshold * threshold;
+        default:
+            return 0;
+    }
+}
+
+static void push_event(uint8_t sensor, uint8_t rule, const TCS34725_Data_t *data, uint32_t timestamp) {
+    uint8_t next = (events_head + 1) % TRIGGER_EVENTS_MAX;
+    if (next == events_tail) {
+        return; // Kolejka pelna, zdarzenie pominiete
+    }
+    events[events_head].sensor = sensor;
+    events[events_head].rule = rule;
+    events[events_head].data = *data;
+    events[events_head].timestamp = timestamp;
+    __DMB();
+    events_head = next;
+    Sched_Signal(SCHED_EVT_TRIGGER);
+}
+
+// Wywolywane z kontekstu przerwania dla kazdej nowej probki
+void ColorTrigger_Evaluate(uint8_t sensor, const TCS34725_Data_t *data, uint32_t timestamp) {
+    uint32_t *applied = rule_applied[sensor];
+    uint8_t *valid = reference_valid[sensor];
+    TCS34725_Data_t *ref = reference[sensor];
+
+    for (uint8_t i = 0; i < TRIGGER_RULES_MAX; i++) {
+        uint32_t rule = rule_config[i];
+
+        // Nowa konfiguracja - probka staje sie punktem odniesienia
+        if (rule != applied[i]) {
+            applied[i] = rule;
+            valid[i] = 0;
+        }
+
+        if (RULE_TYPE(rule) == TRIGGER_TYPE_OFF || RULE_THRESHOLD(rule) == 0) {
+            continue;
+        }
+
+        if (!valid[i]) {
+            ref[i] = *data;
+            valid[i] = 1;
+            continue;
+        }
+
+        if (rule_matches(rule, &ref[i], data)) {
+            push_event(sensor, i, data, timestamp);
+            ref[i] = *data;
+        }
+    }
+}
+
+uint8_t ColorTrigger_SetRule(uint8_t index, char type, char channel,
+                             uint32_t threshold, const char *host) {
+    if (index >= TRIGGER_RULES_MAX || threshold > TRIGGER_THRESHOLD_MAX) {
+        return 0;
+    }
+    if (type != TRIGGER_TYPE_OFF && type != TRIGGER_TYPE_ABS &&
+        type != TRIGGER_TYPE_REL && type != TRIGGER_TYPE_CHROMA) {
+        return 0;
+    }
+    if (channel != 'R' && channel != 'G' && channel != 'B' && channel != 'C') {
+        return 0;
+    }
+
+    if (host) {
+        memcpy(trigger_host, host, FIELD_ADDR_LEN);
+        trigger_host[FIELD_ADDR_LEN] = '\0';
+    }
+    rule_config[index] = RULE_PACK(type, channel, threshold);
+    return 1;
+}
+
+uint8_t ColorTrigger_GetRule(uint8_t index, char *type, char *channel, uint16_t *threshold) {
+    if (index >= TRIGGER_RULES_MAX) {
+        return 0;
+    }
+    uint32_t rule = rule_config[index];
+    if (rule == 0) {
+        rule = RULE_PACK(TRIGGER_TYPE_OFF, 'C', 0);
+    }
+    *type = RULE_TYPE(rule);
+    *channel = RULE_CHANNEL(rule);
+    *threshold = RULE_THRESHOLD(rule);
+    return 1;
+}
+
+uint8_t ColorTrigger_HasEvents(void) {
+    return events_tail != events_head;
+}
+
+uint8_t ColorTrigger_PopEvent(TriggerEvent_t *event) {
+    if (events_tail == events_head) {
+        return 0;
+    }
+    __DMB();
+    *event = events[events_tail];
+    __DMB();
+    events_tail = (events_tail + 1) % TRIGGER_EVENTS_MAX;
+    return 1;
+}
+
+const char* ColorTrigger_GetHost(void) {
+    return trigger_host;
+}
@@ -0,0 +1,3 @@
+#include "counters.h"
+
+volatile uint32_t counters[CNT_COUNT];
@@ -1,4 +1,5 @@
 #include "crc16.h"
+#include "profile.h"
 
 static const uint16_t ccitt_hash[] = {
     0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
@@ -27,10 +28,12 @@ static const uint16_t ccitt_hash[] = {
  */
 uint16_t crc16_ccitt(const uint8_t* buffer, size_t size)
 {
+    PROF_BEGIN(PROF_SITE_CRC16);
     uint16_t crc = 0;  // Wartość początkowa: 0x0000
     while (size-- > 0)
     {
     	crc = (crc << 8) ^ ccitt_hash[((crc >> 8) ^ *(buffer++)) & 0x00FF];
     }
+    PROF_END(PROF_SITE_CRC16);
     return crc;
 }
@@ -22,6 +22,27 @@
 
 /* USER CODE BEGIN 0 */
 
+// Liczba impulsow SCL przy odblokowaniu magistrali (bajt + ACK)
+#define I2C_RECOVERY_CLOCKS 9
+
+// Opoznienie ~5us - polowa okresu zegara 100 kHz przy bit-bangingu
+static void i2c_recovery_delay(void)
+{
+  uint32_t loops = SystemCoreClock / 1000000U * 5U / 4U;
+  while (loops--)
+  {
+    __NOP();
+  }
+}
+
+// Najwieksza predkosc Fast mode nie wieksza od 400 kHz osiagalna z PCLK1. HAL zaokragla
+// CCR w dol, wiec dla PCLK1 niepodzielnego przez 1.2 MHz (16, 45 MHz) SCL przekroczyloby 400 kHz.
+static uint32_t i2c_fast_speed(uint32_t pclk1)
+{
+  uint32_t ccr = (pclk1 + 3U * 400000U - 1U) / (3U * 400000U);
+  return pclk1 / (3U * ccr);
+}
+
 /* USER CODE END 0 */
 
 I2C_HandleTypeDef hi2c1;
@@ -40,7 +61,7 @@ void MX_I2C1_Init(void)
 
   /* USER CODE END I2C1_Init 1 */
   hi2c1.Instance = I2C1;
-  hi2c1.Init.ClockSpeed = 100000;
+  hi2c1.Init.ClockSpeed = 400000;
   hi2c1.Init.DutyCycle = I2C_DUTYCYCLE_2;
   hi2c1.Init.OwnAddress1 = 0;
   hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
@@ -121,9 +142,9 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* i2cHandle)
     __HAL_LINKDMA(i2cHandle,hdmatx,hdma_i2c1_tx);
 
     /* I2C1 interrupt Init */
-    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 1, 0);
     HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
-    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 1, 0);
     HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
   /* USER CODE BEGIN I2C1_MspInit 1 */
 
@@ -165,4 +186,58 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief Odblokowanie magistrali I2C1 i ponowna inicjalizacja peryferium.
+  *        Slave trzymajacy SDA w stanie niskim dostaje do 9 impulsow SCL,
+  *        po czym generowany jest warunek STOP.
+  */
+void I2C1_BusRecovery(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  HAL_I2C_DeInit(&hi2c1);
+
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6|GPIO_PIN_7, GPIO_PIN_SET);
+  GPIO_InitStruct.Pin = GPIO_PIN_6|GPIO_PIN_7;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+  HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+  i2c_recovery_delay();
+
+  for (uint8_t i = 0; i < I2C_RECOVERY_CLOCKS; i++)
+  {
+    if (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_7) == GPIO_PIN_SET)
+    {
+      break;
+    }
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_RESET);
+    i2c_recovery_delay();
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_SET);
+    i2c_recovery_delay();
+  }
+
+  /* STOP: SDA z niskiego na wysoki przy wysokim SCL */
+  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, GPIO_PIN_RESET);
+  i2c_recovery_delay();
+  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, GPIO_PIN_SET);
+  i2c_recovery_delay();
+
+  HAL_GPIO_DeInit(GPIOB, GPIO_PIN_6|GPIO_PIN_7);
+
+  MX_I2C1_Init();
+  I2C1_UpdateClock();
+}
+
+// Po zmianie zegara systemowego (magistrala wolna): FREQ, CCR i TRISE od nowa z PCLK1
+void I2C1_UpdateClock(void)
+{
+  hi2c1.Init.ClockSpeed = i2c_fast_speed(HAL_RCC_GetPCLK1Freq());
+  if (HAL_I2C_Init(&hi2c1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,113 @@
+#include "irq_prio.h"
+#include "profile.h"
+
+// Poziom kazdego mierzonego przerwania - jak w HAL_NVIC_SetPriority
+static const uint8_t irq_prio[IRQ_ID_COUNT] = {
+    [IRQ_ID_EXTI2]   = IRQ_PRIO_SENSOR,
+    [IRQ_ID_DMA1_S0] = IRQ_PRIO_SENSOR,
+    [IRQ_ID_DMA1_S6] = IRQ_PRIO_SENSOR,
+    [IRQ_ID_I2C1_EV] = IRQ_PRIO_SENSOR,
+    [IRQ_ID_I2C1_ER] = IRQ_PRIO_SENSOR,
+    [IRQ_ID_TIM2]    = IRQ_PRIO_SAMPLING,
+    [IRQ_ID_TIM5]    = IRQ_PRIO_TIMEBASE,
+    [IRQ_ID_USART2]  = IRQ_PRIO_UART,
+    [IRQ_ID_SYSTICK] = IRQ_PRIO_TICK,
+};
+
+#if PROFILE_ENABLE
+// Histogramy czasu obslugi - ten sam pomiar trafia do sond profilu
+static const uint8_t irq_prof_site[IRQ_ID_COUNT] = {
+    [IRQ_ID_EXTI2]   = PROF_SITE_ISR_SENSOR,
+    [IRQ_ID_DMA1_S0] = PROF_SITE_ISR_SENSOR,
+    [IRQ_ID_DMA1_S6] = PROF_SITE_ISR_SENSOR,
+    [IRQ_ID_I2C1_EV] = PROF_SITE_ISR_SENSOR,
+    [IRQ_ID_I2C1_ER] = PROF_SITE_ISR_SENSOR,
+    [IRQ_ID_TIM2]    = PROF_SITE_ISR_SAMPLING,
+    [IRQ_ID_TIM5]    = PROF_SITE_COUNT,
+    [IRQ_ID_USART2]  = PROF_SITE_ISR_UART,
+    [IRQ_ID_SYSTICK] = PROF_SITE_COUNT,
+};
+#endif
+
+static volatile uint32_t irq_count[IRQ_ID_COUNT];
+static volatile uint32_t irq_exec_max[IRQ_ID_COUNT];     // Cykle, z wywlaszczeniami
+
+// Najdluzsza sekcja krytyczna na danym poziomie BASEPRI (maskuje ten poziom i nizsze)
+static volatile uint32_t lock_max[IRQ_PRIO_LEVELS];
+static uint32_t lock_start[IRQ_PRIO_LEVELS];
+
+
+static uint32_t cycles_to_x10us(uint32_t cycles) {
+    return (uint32_t)((uint64_t)cycles * 10U / (SystemCoreClock / 1000000U));
+}
+
+void IrqStats_Exit(IrqId_t id, uint32_t start_cycles) {
+    uint32_t cycles = DWT->CYCCNT - start_cycles;
+    irq_count[id]++;
+    if (cycles > irq_exec_max[id]) {
+        irq_exec_max[id] = cycles;
+    }
+#if PROFILE_ENABLE
+    if (irq_prof_site[id] != PROF_SITE_COUNT) {
+        Profile_Record((ProfileSite_t) irq_prof_site[id], cycles);
+    }
+#endif
+}
+
+// Opoznienie wejscia na poziomie p: blokada = najdluzsza sekcja krytyczna maskujaca p
+// lub najdluzsza obsluga innego przerwania poziomu p; do tego po jednym wywlaszczeniu
+// przez kazde przerwanie wyzszego poziomu.
+void IrqStats_Get(IrqId_t id, IrqStats_t *stats) {
+    uint8_t prio = irq_prio[id];
+    uint32_t blocking = 0;
+    uint32_t preemption = 0;
+
+    for (uint8_t level = 1; level <= prio; level++) {
+        if (lock_max[level] > blocking) {
+            blocking = lock_max[level];
+        }
+    }
+    for (uint8_t i = 0; i < IRQ_ID_COUNT; i++) {
+        if (i == id) {
+            continue;
+        }
+        if (irq_prio[i] == prio && irq_exec_max[i] > blocking) {
+            blocking = irq_exec_max[i];
+        } else if (irq_prio[i] < prio) {
+            preemption += irq_exec_max[i];
+        }
+    }
+
+    stats->prio = prio;
+    stats->count = irq_count[id];
+    stats->exec_max_x10 = cycles_to_x10us(irq_exec_max[id]);
+    stats->latency_max_x10 = cycles_to_x10us(blocking + preemption);
+}
+
+// Sekcja krytyczna przez BASEPRI: maskuje tylko przerwania od poziomu prio w dol,
+// wazniejsze (np. TIM5) obsluguja sie dalej. prio = 0 nie maskuje niczego.
+// Zwraca poprzedni BASEPRI; zagniezdzenie tylko podnosi maske.
+uint32_t Irq_Lock(uint32_t prio) {
+    uint32_t prev = __get_BASEPRI();
+    uint32_t level = prio << (8U - __NVIC_PRIO_BITS);
+
+    if (prev == 0 || prev > level) {
+        __set_BASEPRI(level);
+        __ISB();
+        lock_start[prio] = DWT->CYCCNT;
+    }
+    return prev;
+}
+
+void Irq_Unlock(uint32_t key) {
+    uint32_t cur = __get_BASEPRI();
+
+    if (cur != key) {
+        uint32_t prio = cur >> (8U - __NVIC_PRIO_BITS);
+        uint32_t cycles = DWT->CYCCNT - lock_start[prio];
+        if (cycles > lock_max[prio]) {
+            lock_max[prio] = cycles;
+        }
+    }
+    __set_BASEPRI(key);
+}
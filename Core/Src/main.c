@@ -29,7 +29,15 @@
 #include "circular_buffer.h"
 #include "protocol.h"
 #include "tcs34725.h"
+#include "power.h"
 #include "i2c.h"
+#include "timebase.h"
+#include "timesync.h"
+#include "clock_profile.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "counters.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -52,7 +60,6 @@
 /* USER CODE BEGIN PV */
 
 volatile uint32_t timer_interval = 1000;
-volatile uint32_t timer_counter = 0;
 
 /* USER CODE END PV */
 
@@ -67,6 +74,7 @@ void SystemClock_Config(void);
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
    if(huart==&huart2){
+	   Counter_Inc(CNT_TX_BYTES);
 	   if(UART_TX_Empty!=UART_TX_Busy){
 		   uint8_t tmp=UART_TxBuf[UART_TX_Busy];
 		   UART_TX_Busy++;
@@ -78,9 +86,18 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart){
 	 if(huart==&huart2){
+		 // Odbior znaku startu ramki - T2 dla TIMESYNC
+		 if(UART_RxBuf[UART_RX_Empty]==PROTOCOL_START_BYTE){
+			 UART_RX_StampStart(UART_RX_Empty,Timebase_NowUs());
+			 Trace_Event(TRC_FRAME_START,0,(UART_RX_Empty-UART_RX_Busy+UART_RXBUF_LEN)%UART_RXBUF_LEN);
+		 }
 		 UART_RX_Empty++;
 		 if(UART_RX_Empty>=UART_RXBUF_LEN)UART_RX_Empty=0;
+		 Counter_Inc(CNT_RX_BYTES);
+		 // Dogonienie czytelnika - zawartosc bufora przepada
+		 if(UART_RX_Empty==UART_RX_Busy)Counter_Inc(CNT_RX_OVERRUNS);
 		 HAL_UART_Receive_IT(&huart2,&UART_RxBuf[UART_RX_Empty],1);
+		 Sched_Signal(SCHED_EVT_UART_RX);
 
 	 }
 }
@@ -119,10 +136,21 @@ int main(void)
   MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_I2C1_Init();
-  MX_TIM3_Init();
+  MX_TIM2_Init();
+  MX_TIM5_Init();
   
   /* USER CODE BEGIN 2 */
-  TCS34725_Init(&hi2c1);
+  Timebase_Init();
+  TimeSync_Init();
+  Clock_Init();
+  Power_Init();
+  Profile_Init();
+  Sched_Init();
+  // Kolejnosc = priorytet: obsluga czujnikow, protokol, zdarzenia wyzwalaczy
+  Sched_AddTask(TCS34725_HandleLoop, SCHED_EVT_SENSOR);
+  Sched_AddTask(process_protocol_data, SCHED_EVT_UART_RX);
+  Sched_AddTask(process_trigger_events, SCHED_EVT_TRIGGER);
+  TCS34725_Init();
   HAL_UART_Receive_IT(&huart2,&UART_RxBuf[0],1);
   UART_TX_FSend("STM INIT\n");
 
@@ -132,8 +160,7 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    process_protocol_data();
-    TCS34725_HandleLoop(&hi2c1);
+    Sched_Run();
 
     /* USER CODE END WHILE */
 
@@ -192,15 +219,17 @@ void SystemClock_Config(void)
 /* USER CODE BEGIN 4 */
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
-	if(htim->Instance == TIM3){
-		timer_counter++;
-		if (timer_counter >= timer_interval) {
-			TCS34725_Start_DMA_Read(&hi2c1);
-			timer_counter=0;
-		}
+	if(htim->Instance == TIM2){
+		TCS34725_OnTimerTick();
+	} else if(htim->Instance == TIM5){
+		Timebase_OnOverflow();
 	}
 }
 
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+	TCS34725_OnInterrupt(GPIO_Pin);
+}
+
 /* USER CODE END 4 */
 
 /**
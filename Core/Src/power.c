@@ -0,0 +1,77 @@
+#include "main.h"
+#include "power.h"
+#include "circular_buffer.h"
+#include "color_trigger.h"
+#include "scheduler.h"
+
+// Cykle rdzenia w stanie aktywnym w biezacym oknie
+static uint32_t active_cycles = 0;
+static uint32_t wake_cycle = 0;
+static uint32_t window_start_tick = 0;
+static uint32_t window_wakeups = 0;
+
+// Wyniki ostatniego pelnego okna
+static volatile uint16_t duty_x100 = 10000;   // Wypelnienie w 0.01%
+static volatile uint32_t wakeups = 0;         // Wybudzenia w oknie
+
+
+// Licznik cykli DWT do pomiaru czasu pracy rdzenia
+void Power_Init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    wake_cycle = DWT->CYCCNT;
+    window_start_tick = HAL_GetTick();
+}
+
+// Czy petla glowna ma cos do zrobienia bez czekania na przerwanie
+static uint8_t work_pending(void) {
+    return Sched_HasPending();
+}
+
+static void close_window(uint32_t now_tick) {
+    uint32_t elapsed_ms = now_tick - window_start_tick;
+    uint64_t window_cycles = (uint64_t)elapsed_ms * (SystemCoreClock / 1000);
+    uint64_t duty = (uint64_t)active_cycles * 10000 / window_cycles;
+
+    duty_x100 = duty > 10000 ? 10000 : (uint16_t)duty;
+    wakeups = window_wakeups;
+
+    active_cycles = 0;
+    window_wakeups = 0;
+    window_start_tick = now_tick;
+}
+
+// Koniec iteracji petli glownej - uspienie rdzenia (Sleep) do nastepnego przerwania.
+// Sprawdzenie i WFI przy zablokowanych przerwaniach, aby nie zgubic zdarzenia
+// zgloszonego miedzy sprawdzeniem a uspieniem - WFI budzi sie takze przy PRIMASK=1.
+void Power_Idle(void) {
+    __disable_irq();
+
+    uint32_t now_cycle = DWT->CYCCNT;
+    active_cycles += now_cycle - wake_cycle;
+
+    if (!work_pending()) {
+        __DSB();
+        __WFI();
+        window_wakeups++;
+    }
+
+    // Czas snu nie jest liczony niezaleznie od tego, czy DWT pracuje w Sleep
+    wake_cycle = DWT->CYCCNT;
+    __enable_irq();
+
+    uint32_t now_tick = HAL_GetTick();
+    if (now_tick - window_start_tick >= POWER_DUTY_WINDOW_MS) {
+        close_window(now_tick);
+    }
+}
+
+uint16_t Power_GetDuty(void) {
+    return duty_x100;
+}
+
+uint32_t Power_GetWakeups(void) {
+    return wakeups;
+}
@@ -0,0 +1,83 @@
+#include "profile.h"
+#include "irq_prio.h"
+#include <string.h>
+
+#if PROFILE_ENABLE
+
+static ProfileStats_t prof_sites[PROF_SITE_COUNT];
+
+// Koszt samej pary odczytow CYCCNT, odejmowany od kazdego pomiaru
+static uint32_t prof_overhead = 0;
+
+
+// Wywolac po Power_Init (wlaczenie DWT)
+void Profile_Init(void) {
+    uint32_t best = UINT32_MAX;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        uint32_t start = DWT->CYCCNT;
+        uint32_t cycles = DWT->CYCCNT - start;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    prof_overhead = best;
+
+    for (uint8_t i = 0; i < PROF_SITE_COUNT; i++) {
+        Profile_Read((ProfileSite_t) i, NULL, 1);
+    }
+}
+
+static uint8_t hist_bin(uint32_t cycles) {
+    uint8_t bin = cycles > 1 ? (uint8_t) (31 - __builtin_clz(cycles)) : 0;
+    return bin < PROF_HIST_BINS ? bin : PROF_HIST_BINS - 1;
+}
+
+// Kazde miejsce jest mierzone tylko z jednego poziomu przerwan, wiec zapis
+// nie potrzebuje blokady - chroniony jest jedynie odczyt z resetem.
+void Profile_Record(ProfileSite_t site, uint32_t cycles) {
+    ProfileStats_t *p = &prof_sites[site];
+
+    cycles = cycles > prof_overhead ? cycles - prof_overhead : 0;
+    p->count++;
+    p->sum += cycles;
+    if (cycles < p->min) {
+        p->min = cycles;
+    }
+    if (cycles > p->max) {
+        p->max = cycles;
+    }
+    p->hist[hist_bin(cycles)]++;
+}
+
+void Profile_Read(ProfileSite_t site, ProfileStats_t *stats, uint8_t reset) {
+    uint32_t key = Irq_Lock(IRQ_PRIO_SENSOR);
+    if (stats) {
+        *stats = prof_sites[site];
+    }
+    if (reset) {
+        memset(&prof_sites[site], 0, sizeof(prof_sites[site]));
+        prof_sites[site].min = UINT32_MAX;
+    }
+    Irq_Unlock(key);
+}
+
+#else
+
+void Profile_Init(void) {
+}
+
+void Profile_Record(ProfileSite_t site, uint32_t cycles) {
+    (void) site;
+    (void) cycles;
+}
+
+void Profile_Read(ProfileSite_t site, ProfileStats_t *stats, uint8_t reset) {
+    (void) site;
+    (void) reset;
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+#endif
@@ -5,12 +5,27 @@
 #include "tim.h"
 #include "i2c.h"
 #include "tcs34725.h"
+#include "color_stats.h"
+#include "color_trigger.h"
+#include "auto_gain.h"
+#include "color_calc.h"
+#include "power.h"
+#include "timebase.h"
+#include "timesync.h"
+#include "scheduler.h"
+#include "irq_prio.h"
+#include "profile.h"
+#include "counters.h"
+#include "trace.h"
+#include "clock_profile.h"
 #include <string.h>
 #include <stdio.h>
 
-volatile uint8_t current_gain_index = 0;      // Default: 1x gain
-volatile uint8_t current_time_index = 3;      // Default: 154ms integration
 volatile uint8_t led_state = 0;               // Default: LED OFF
+volatile uint8_t ans_format = ANS_FMT_RAW;    // Default: tylko surowe RGBC
+
+// Odbior znaku startu biezacej ramki (znacznik z przerwania USART2 dla jej pozycji w buforze RX)
+static uint64_t frame_rx_us = 0;
 
 extern volatile uint32_t timer_interval;
 
@@ -22,6 +37,8 @@ const uint8_t GAIN_TABLE[GAIN_VALUES_COUNT] = {
     TCS34725_GAIN_60X
 };
 
+const uint8_t GAIN_MULTIPLIER[GAIN_VALUES_COUNT] = { 1, 4, 16, 60 };
+
 const uint16_t TIME_TABLE[TIME_VALUES_COUNT] = {
     TCS34725_INTEGRATIONTIME_2_4MS,
     TCS34725_INTEGRATIONTIME_24MS,
@@ -45,12 +62,75 @@ static uint8_t is_valid_sender(const char *sender) {
 }
 
 static int format_ans_data(char *buffer, size_t buffer_size,
-		TCS34725_Data_t *data) {
-	return snprintf(buffer, buffer_size, "ANS"
-			"R%05u"
-			"G%05u"
-			"B%05u"
-			"C%05u", data->r, data->g, data->b, data->c);
+		const ColorBufferEntry_t *entry) {
+	const TCS34725_Data_t *data = &entry->data;
+	uint8_t format = ans_format;
+	int len = snprintf(buffer, buffer_size, "ANS");
+
+	if (format & ANS_FMT_RAW) {
+		len += snprintf(&buffer[len], buffer_size - len,
+				"R%05u"
+				"G%05u"
+				"B%05u"
+				"C%05u", data->r, data->g, data->b, data->c);
+		// Rozrzut kanalu C, gdy probka jest srednia z kilku integracji
+		if (entry->spread != TCS_SPREAD_NONE) {
+			len += snprintf(&buffer[len], buffer_size - len, "V%05u", entry->spread);
+		}
+	}
+	if (format & (ANS_FMT_LUX | ANS_FMT_CCT)) {
+		ColorCalc_Result_t result;
+		ColorCalc_Compute(data, entry->gain_index, entry->time_index, &result);
+		if (format & ANS_FMT_LUX) {
+			len += snprintf(&buffer[len], buffer_size - len, "L%08lu",
+					(unsigned long) result.lux_x100);
+		}
+		if (format & ANS_FMT_CCT) {
+			len += snprintf(&buffer[len], buffer_size - len, "K%05lu",
+					(unsigned long) result.cct);
+		}
+	}
+	// Srodek integracji w czasie hosta: sekundy od 1970 i us, tylko gdy zegar jest ustawiony
+	if ((format & ANS_FMT_TIME) && TimeSync_GetSource() != TIMESYNC_NONE) {
+		uint64_t epoch_us = TimeSync_ToEpochUs(entry->timestamp_us);
+		len += snprintf(&buffer[len], buffer_size - len, "E%010lu%06lu",
+				(unsigned long) (epoch_us / 1000000),
+				(unsigned long) (epoch_us % 1000000));
+	}
+	return len;
+}
+
+
+// TIM2 pracuje tylko gdy probkowanie jest wlaczone i ktorys czujnik nie taktuje sie sam.
+// Uruchomiony timer nie jest restartowany, aby nie przesuwac fazy probkowania.
+static uint8_t sampling_timer_running = 0;
+
+static void update_sampling_timer(void) {
+	if (sampling_active && TCS34725_NeedsTimer()) {
+		if (!sampling_timer_running) {
+			TIM2_StartSampling(timer_interval);
+			sampling_timer_running = 1;
+		}
+	} else {
+		HAL_TIM_Base_Stop_IT(&htim2);
+		sampling_timer_running = 0;
+	}
+}
+
+
+static int format_stats_data(char *buffer, size_t buffer_size,
+		const ColorStats_Snapshot_t *stats) {
+	static const char channel_names[STATS_CHANNELS] = { 'R', 'G', 'B', 'C' };
+	int len = snprintf(buffer, buffer_size, STATS_PREFIX "W%03uN%03u",
+			stats->window, stats->count);
+
+	for (uint8_t ch = 0; ch < STATS_CHANNELS && len > 0 && (size_t) len < buffer_size; ch++) {
+		len += snprintf(&buffer[len], buffer_size - len, "%c%05uV%010luL%05uH%05u",
+				channel_names[ch], ColorStats_Mean(stats, ch),
+				(unsigned long) ColorStats_Variance(stats, ch),
+				stats->min[ch], stats->max[ch]);
+	}
+	return len;
 }
 
 
@@ -67,6 +147,20 @@ static int convert_char_to_int(char *str) {
 }
 
 
+// Wersja 64-bitowa dla przesuniec w us, ktore nie mieszcza sie w int
+static int64_t convert_char_to_u64(const char *str) {
+	int64_t result = 0;
+	size_t len = strlen(str);
+	for (size_t i = 0; i < len; i++) {
+		if (str[i] < '0' || str[i] > '9') {
+			return -1; // Nie cyfra
+		}
+		result = result * 10 + (str[i] - '0');
+	}
+	return result;
+}
+
+
 static uint16_t convert_hex_to_int(const char *hex_str, size_t len) {
 	uint16_t result = 0;
 	for (size_t i = 0; i < len; i++) {
@@ -83,18 +177,7 @@ static uint16_t convert_hex_to_int(const char *hex_str, size_t len) {
 }
 
 
-static uint16_t get_integration_time_ms(uint8_t index) {
-    switch (index) {
-        case 0: return 3;   // 2.4ms
-        case 1: return 24;  // 24ms
-        case 2: return 101; // 101ms
-        case 3: return 154; // 154ms
-        case 4: return 700; // 700ms
-        default: return 0;
-    }
-}
-
-static int hex_decode_string(const char *hex_str, char *output, size_t output_size) {
+int hex_decode_string(const char *hex_str, char *output, size_t output_size) {
 	if (!hex_str || !output || output_size == 0) {
 		return -1;
 	}
@@ -123,7 +206,7 @@ static int hex_decode_string(const char *hex_str, char *output, size_t output_si
 }
 
 
-static int hex_encode_string(const char *input, char *output, size_t output_size) {
+int hex_encode_string(const char *input, char *output, size_t output_size) {
 	if (!input || !output || output_size == 0) {
 		return -1;
 	}
@@ -179,12 +262,90 @@ Command parse_command(const char *command_str) {
 	if (strcmp(command_str, CMD_STR_RDARC) == 0) {
 		return RDARC_CMD;
 	}
+	if (strcmp(command_str, CMD_STR_RDARCU) == 0) {
+		return RDARCU_CMD;
+	}
 	if (strcmp(command_str, CMD_STR_SETLED) == 0) {
 		return SETLED_CMD;
 	}
 	if (strcmp(command_str, CMD_STR_GETLED) == 0) {
 		return GETLED_CMD;
 	}
+	if (strcmp(command_str, CMD_STR_STATS) == 0) {
+		return STATS_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETWIN) == 0) {
+		return SETWIN_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETWIN) == 0) {
+		return GETWIN_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETTRG) == 0) {
+		return SETTRG_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETTRG) == 0) {
+		return GETTRG_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETSRC) == 0) {
+		return SETSRC_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETSRC) == 0) {
+		return GETSRC_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETAUTO) == 0) {
+		return SETAUTO_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETAUTO) == 0) {
+		return GETAUTO_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_RDLUX) == 0) {
+		return RDLUX_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETFMT) == 0) {
+		return SETFMT_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETFMT) == 0) {
+		return GETFMT_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETSNS) == 0) {
+		return GETSNS_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETDUTY) == 0) {
+		return GETDUTY_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETOVS) == 0) {
+		return SETOVS_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETOVS) == 0) {
+		return GETOVS_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_TIMESYNC) == 0) {
+		return TIMESYNC_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETTASK) == 0) {
+		return GETTASK_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETIRQ) == 0) {
+		return GETIRQ_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_PROFILE) == 0) {
+		return PROFILE_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_RDCNT) == 0) {
+		return RDCNT_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETTRC) == 0) {
+		return SETTRC_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_RDTRC) == 0) {
+		return RDTRC_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_SETCLK) == 0) {
+		return SETCLK_CMD;
+	}
+	if (strcmp(command_str, CMD_STR_GETCLK) == 0) {
+		return GETCLK_CMD;
+	}
 
 	return CMD_INVALID;
 }
@@ -200,8 +361,34 @@ uint8_t get_command_param_len(Command cmd) {
 		return PARAM_LEN_SETTIME;
 	case RDARC_CMD:
 		return PARAM_LEN_RDARC;
+	case RDARCU_CMD:
+		return PARAM_LEN_RDARCU;
 	case SETLED_CMD:
 		return PARAM_LEN_SETLED;
+	case SETWIN_CMD:
+		return PARAM_LEN_SETWIN;
+	case SETTRG_CMD:
+		return PARAM_LEN_SETTRG;
+	case GETTRG_CMD:
+		return PARAM_LEN_GETTRG;
+	case SETSRC_CMD:
+		return PARAM_LEN_SETSRC;
+	case SETAUTO_CMD:
+		return PARAM_LEN_SETAUTO;
+	case SETFMT_CMD:
+		return PARAM_LEN_SETFMT;
+	case SETOVS_CMD:
+		return PARAM_LEN_SETOVS;
+	case TIMESYNC_CMD:
+		return PARAM_LEN_TIMESYNC;
+	case PROFILE_CMD:
+		return PARAM_LEN_PROFILE;
+	case SETTRC_CMD:
+		return PARAM_LEN_SETTRC;
+	case RDTRC_CMD:
+		return PARAM_LEN_RDTRC;
+	case SETCLK_CMD:
+		return PARAM_LEN_SETCLK;
 	case START_CMD:
 	case STOP_CMD:
 	case GETINT_CMD:
@@ -209,6 +396,19 @@ uint8_t get_command_param_len(Command cmd) {
 	case GETTIME_CMD:
 	case GETLED_CMD:
 	case RDRAW_CMD:
+	case STATS_CMD:
+	case GETWIN_CMD:
+	case GETSRC_CMD:
+	case GETAUTO_CMD:
+	case RDLUX_CMD:
+	case GETFMT_CMD:
+	case GETSNS_CMD:
+	case GETDUTY_CMD:
+	case GETOVS_CMD:
+	case GETTASK_CMD:
+	case GETIRQ_CMD:
+	case RDCNT_CMD:
+	case GETCLK_CMD:
 	default:
 		return 0;
 	}
@@ -287,10 +487,12 @@ ParseResult parse_frame(const char *buffer, size_t len, Frame *frame,
 	char len_str[FIELD_DATA_LEN + 1];
 	memcpy(len_str, &buffer[pos], FIELD_DATA_LEN);
 	len_str[FIELD_DATA_LEN] = '\0';
-	frame->data_len = convert_char_to_int(len_str);
-	if (frame->data_len < 0 || frame->data_len > MAX_PAYLOAD_LEN) {
+	// Pola liczbowe przez int - w polach ramki bez znaku blad konwersji (-1) nie bylby widoczny
+	int data_len = convert_char_to_int(len_str);
+	if (data_len < 0 || data_len > MAX_PAYLOAD_LEN) {
 		return PARSE_INVALID_FORMAT;
 	}
+	frame->data_len = (uint16_t) data_len;
 	pos += FIELD_DATA_LEN;
 
 	//Sprwdzanie czy długość ramki jest poprawna
@@ -301,8 +503,9 @@ ParseResult parse_frame(const char *buffer, size_t len, Frame *frame,
 	char id_str[FIELD_ID_LEN + 1];
 	memcpy(id_str, &buffer[pos], FIELD_ID_LEN);
 	id_str[FIELD_ID_LEN] = '\0';
-	frame->frame_id = convert_char_to_int(id_str);
-	if(frame->frame_id < 0) return PARSE_INVALID_FORMAT;
+	int frame_id = convert_char_to_int(id_str);
+	if (frame_id < 0) return PARSE_INVALID_FORMAT;
+	frame->frame_id = (uint8_t) frame_id;
 	pos += FIELD_ID_LEN;
 
 	//Sprwdzanie czy długość ramki jest poprawna
@@ -369,6 +572,24 @@ ParseResult parse_frame(const char *buffer, size_t len, Frame *frame,
 		return PARSE_CRC_ERROR;
 	}
 
+	// Przyrostek @n wybiera czujnik - usuwany przed dalszym parsowaniem
+	frame->sensor = 0;
+	if (frame->data_len >= SENSOR_SUFFIX_LEN
+			&& frame->data[frame->data_len - SENSOR_SUFFIX_LEN] == SENSOR_SUFFIX_CHAR) {
+		char sensor_char = frame->data[frame->data_len - 1];
+		if (sensor_char < '0' || sensor_char >= '0' + TCS_SENSOR_COUNT) {
+			if (response_buffer && response_size >= MAX_PAYLOAD_LEN
+					&& is_valid_sender(frame->sender)) {
+				build_response_frame(response_buffer, response_size, DEVICE_ID,
+						frame->sender, frame->frame_id, NULL, WRSENS);
+			}
+			return PARSE_CMD_ERROR;
+		}
+		frame->sensor = sensor_char - '0';
+		frame->data_len -= SENSOR_SUFFIX_LEN;
+		frame->data[frame->data_len] = '\0';
+	}
+
 	// Znajdywanie długości nazwy komendy
 	size_t cmd_name_len = 0;
 	for (size_t i = 0; i < frame->data_len && i < MAX_PAYLOAD_LEN; i++) {
@@ -400,6 +621,12 @@ ParseResult parse_frame(const char *buffer, size_t len, Frame *frame,
 
 	//Parsowanie komendy
 	Command cmd = parse_command(cmd_name);
+	// Parametr szesnastkowy zaczynajacy sie litera (SETFMTF) sklejony z nazwa - skracanie
+	while (cmd == CMD_INVALID && cmd_name_len > 1
+			&& cmd_name[cmd_name_len - 1] >= 'A' && cmd_name[cmd_name_len - 1] <= 'F') {
+		cmd_name[--cmd_name_len] = '\0';
+		cmd = parse_command(cmd_name);
+	}
 	if (cmd == CMD_INVALID) {
 		//Nieznana komenda
 		if (response_buffer && response_size >= MAX_PAYLOAD_LEN
@@ -496,6 +723,7 @@ uint8_t build_response_frame(char *buffer, size_t buffer_size, const char *sende
 	if (!buffer || !sender || buffer_size < MIN_FRAME_LEN) {
 		return 0;
 	}
+	PROF_BEGIN(PROF_SITE_BUILD_RESPONSE);
 
 	char raw_data[MAX_PAYLOAD_LEN];
 
@@ -522,6 +750,12 @@ uint8_t build_response_frame(char *buffer, size_t buffer_size, const char *sende
 		case WRTIME:
 			strncpy(raw_data, WRTIME_STR, sizeof(raw_data) - 1);
 			break;
+		case WRBUSY:
+			strncpy(raw_data, WRBUSY_STR, sizeof(raw_data) - 1);
+			break;
+		case WRSENS:
+			strncpy(raw_data, WRSENS_STR, sizeof(raw_data) - 1);
+			break;
 		default:
 			strncpy(raw_data, WRFRM_STR, sizeof(raw_data) - 1);
 			break;
@@ -592,6 +826,7 @@ uint8_t build_response_frame(char *buffer, size_t buffer_size, const char *sende
 
 	buffer[pos] = '\0';
 
+	PROF_END(PROF_SITE_BUILD_RESPONSE);
 	return 1;
 }
 
@@ -599,15 +834,29 @@ uint8_t build_response_frame(char *buffer, size_t buffer_size, const char *sende
 void process_received_frame(const char *buffer, uint16_t len) {
 	Frame frame;
 	char response[MAX_FRAME_LEN];
+	Counter_Inc(CNT_RX_FRAMES);
+	Trace_Event(TRC_FRAME_END, 0, len);
+	PROF_BEGIN(PROF_SITE_PARSE_FRAME);
 	ParseResult result = parse_frame(buffer, len, &frame, response,
 			sizeof(response));
+	PROF_END(PROF_SITE_PARSE_FRAME);
+	Trace_Event(TRC_PARSE, result, 0);
 	if (result == PARSE_OK) {
+		frame.rx_us = frame_rx_us;
+		Trace_Event(TRC_CMD_START, frame.command, frame.frame_id);
+		PROF_BEGIN(PROF_SITE_PROCESS_CMD);
 		process_command(&frame, response, sizeof(response));
+		PROF_END(PROF_SITE_PROCESS_CMD);
+		Trace_Event(TRC_CMD_END, frame.command, frame.frame_id);
+		// Komenda mogla zmienic konfiguracje czujnikow (START, SETSRC, SETOVS...)
+		Sched_Signal(SCHED_EVT_SENSOR);
 	} else if (result == PARSE_CRC_ERROR) {
+		Counter_Inc(CNT_CRC_ERRORS);
 		if (strlen(response) > 0) {
 			UART_TX_FSend("%s", response);
 		}
 	} else if (result == PARSE_LENGTH_MISMATCH) {
+		Counter_Inc(CNT_BAD_FRAMES);
 		if (is_valid_sender(frame.sender)) {
 			if (build_response_frame(response, sizeof(response), DEVICE_ID,
 					frame.sender, frame.frame_id, NULL, WRLEN)) {
@@ -615,18 +864,22 @@ void process_received_frame(const char *buffer, uint16_t len) {
 			}
 		}
 	} else if (result == PARSE_CMD_ERROR) {
+		Counter_Inc(CNT_BAD_FRAMES);
 		if (strlen(response) > 0) {
 			UART_TX_FSend("%s", response);
 		}
 	} else if (result == PARSE_INVALID_FORMAT) {
+		Counter_Inc(CNT_BAD_FRAMES);
 		if (is_valid_sender(frame.sender)) {
 			if (build_response_frame(response, sizeof(response), DEVICE_ID,
 					frame.sender, 0, NULL, WRFRM)) {
 				UART_TX_FSend("%s", response);
 			}
 		}
+	} else {
+		//PARSE_TOO_SHORT, PARSE_WRONG_RECIPIENT, PARSE_FORBIDDEN_CHARS ingorowanie bez odpowiedzi
+		Counter_Inc(CNT_IGNORED_FRAMES);
 	}
-	//PARSE_TOO_SHORT, PARSE_WRONG_RECIPIENT, PARSE_FORBIDDEN_CHARS ingorowanie bez odpowiedzi
 }
 
 
@@ -641,6 +894,7 @@ void process_protocol_data(void) {
 
 	// Przetwarza wszystkie dostępne znaki z bufora
 	while (!UART_RX_IsEmpty()) {
+		int rx_pos = UART_RX_Busy;
 		int16_t received_char = UART_RX_GetChar();
 		if (received_char == -1) {
 			break; // Brak danych
@@ -648,6 +902,10 @@ void process_protocol_data(void) {
 
 		char c = (char) received_char;
 
+		if (c == PROTOCOL_START_BYTE) {
+			frame_rx_us = UART_RX_StartTimeUs(rx_pos);
+		}
+
 		switch (state) {
 		case STATE_IDLE:
 			// Czekanie na znak startu &
@@ -793,7 +1051,8 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 	case START_CMD:
 		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 				frame->sender, frame->frame_id, RESP_OK, 0)) {
-			HAL_TIM_Base_Start_IT(&htim3);
+			sampling_active = 1;
+			update_sampling_timer();
 			UART_TX_FSend("%s", response_buffer);
 		}
 		break;
@@ -801,16 +1060,17 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 	case STOP_CMD:
 		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 				frame->sender, frame->frame_id, RESP_OK, 0)) {
-			HAL_TIM_Base_Stop_IT(&htim3);
+			sampling_active = 0;
+			update_sampling_timer();
 			UART_TX_FSend("%s", response_buffer);
 		}
 		break;
 
 	case RDRAW_CMD:
 	{
-		ColorBufferEntry_t *latest = ColorBuffer_GetLatest();
-		if (latest != NULL) {
-			format_ans_data(data_buffer, sizeof(data_buffer), &latest->data);
+		ColorBufferEntry_t latest;
+		if (ColorBuffer_ReadLatest(frame->sensor, &latest)) {
+			format_ans_data(data_buffer, sizeof(data_buffer), &latest);
 			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 					frame->sender, frame->frame_id, data_buffer, 0)) {
 				UART_TX_FSend("%s", response_buffer);
@@ -838,11 +1098,10 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 				if (time_offset == 0 || time_offset > max_offset) {
 					error = WRPOS;
 				} else {
-					ColorBufferEntry_t *entry = ColorBuffer_GetByTimeOffset(
-							time_offset);
-					if (entry != NULL) {
+					ColorBufferEntry_t entry;
+					if (ColorBuffer_ReadByTimeOffset(frame->sensor, time_offset, &entry)) {
 						format_ans_data(data_buffer, sizeof(data_buffer),
-								&entry->data);
+								&entry);
 						if (build_response_frame(response_buffer, response_size,
 						DEVICE_ID, frame->sender, frame->frame_id, data_buffer,
 								0)) {
@@ -870,6 +1129,52 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 		break;
 
 
+	case RDARCU_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_RDARCU) {
+			error = WRLEN;
+		} else {
+			int64_t time_offset = convert_char_to_u64(frame->params);
+			if (time_offset < 0) {
+				error = WRCMD;
+			} else {
+				uint64_t max_offset = (uint64_t)COLOR_BUFFER_SIZE * timer_interval * 1000;
+				if (time_offset == 0 || (uint64_t)time_offset > max_offset) {
+					error = WRPOS;
+				} else {
+					ColorBufferEntry_t entry;
+					if (ColorBuffer_ReadByTimeOffsetUs(frame->sensor, time_offset, &entry)) {
+						int len = format_ans_data(data_buffer, sizeof(data_buffer), &entry);
+						// Srodek integracji: sekundy i us osobno (newlib-nano nie ma %llu)
+						snprintf(&data_buffer[len], sizeof(data_buffer) - len, "T%010lu%06lu",
+								(unsigned long) (entry.timestamp_us / 1000000),
+								(unsigned long) (entry.timestamp_us % 1000000));
+						if (build_response_frame(response_buffer, response_size,
+						DEVICE_ID, frame->sender, frame->frame_id, data_buffer,
+								0)) {
+							UART_TX_FSend("%s", response_buffer);
+						}
+					} else {
+						sprintf(data_buffer, NODATA_STR);
+						if (build_response_frame(response_buffer, response_size,
+						DEVICE_ID, frame->sender, frame->frame_id, data_buffer,
+								0)) {
+							UART_TX_FSend("%s", response_buffer);
+						}
+					}
+				}
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
 	case SETINT_CMD:
 	{
 		if (frame->params_len != PARAM_LEN_SETINT) {
@@ -879,11 +1184,25 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 			if (new_interval <= 0) {
 				error = WRCMD;
 			} else {
-				uint16_t integration_time = get_integration_time_ms(current_time_index);
-				if ((uint32_t)new_interval <= integration_time) {
+				uint32_t integration_time = TCS34725_GetMaxSampleTimeMs();
+				if (auto_gain_enabled && (uint32_t)new_interval > TCS34725_GetIntegrationTimeMs(0)) {
+					// W trybie AUTO czas integracji jest skracany do nowego interwalu
+					AutoGain_ClampToInterval(new_interval);
+					timer_interval = new_interval;
+					TIM2_SetSampleInterval(new_interval);
+					TCS34725_ApplyPacingAll();
+					update_sampling_timer();
+					if (build_response_frame(response_buffer, response_size,
+					DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+						UART_TX_FSend("%s", response_buffer);
+					}
+				} else if ((uint32_t)new_interval <= integration_time) {
 					error = WRTIME;
 				} else {
 					timer_interval = new_interval;
+					TIM2_SetSampleInterval(new_interval);
+					TCS34725_ApplyPacingAll();
+					update_sampling_timer();
 					if (build_response_frame(response_buffer, response_size,
 					DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
 						UART_TX_FSend("%s", response_buffer);
@@ -918,11 +1237,14 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 		} else {
 			char gain_char = frame->params[0];
 			if (gain_char >= '0' && gain_char <= '3') {
-				current_gain_index = gain_char - '0';
-				TCS34725_WriteReg(&hi2c1, TCS34725_CONTROL, GAIN_TABLE[current_gain_index]);
-				if (build_response_frame(response_buffer, response_size,
-				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
-					UART_TX_FSend("%s", response_buffer);
+				uint8_t new_gain_index = gain_char - '0';
+				if (TCS34725_SetGain(frame->sensor, new_gain_index) != HAL_OK) {
+					error = WRBUSY;
+				} else {
+					if (build_response_frame(response_buffer, response_size,
+					DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+						UART_TX_FSend("%s", response_buffer);
+					}
 				}
 			} else {
 				error = WRCMD;
@@ -940,7 +1262,7 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 
 	case GETGAIN_CMD:
 	{
-		sprintf(data_buffer, GAIN_PREFIX "%01u", current_gain_index);
+		sprintf(data_buffer, GAIN_PREFIX "%01u", tcs_sensors[frame->sensor].gain_index);
 		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 				frame->sender, frame->frame_id, data_buffer, 0)) {
 			UART_TX_FSend("%s", response_buffer);
@@ -956,12 +1278,13 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 			char time_char = frame->params[0];
 			if (time_char >= '0' && time_char <= '4') {
 				uint8_t new_time_index = time_char - '0';
-				uint16_t new_integration_time = get_integration_time_ms(new_time_index);
-				if (timer_interval <= new_integration_time) {
+				uint32_t new_sample_time = TCS34725_GetSampleTimeMs(frame->sensor, new_time_index);
+				if (timer_interval <= new_sample_time) {
 					error = WRTIME;
+				} else if (TCS34725_SetTime(frame->sensor, new_time_index) != HAL_OK) {
+					error = WRBUSY;
 				} else {
-					current_time_index = new_time_index;
-					TCS34725_WriteReg(&hi2c1, TCS34725_ATIME, TIME_TABLE[new_time_index]);
+					TCS34725_ApplyPacing(frame->sensor);
 					if (build_response_frame(response_buffer, response_size,
 					DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
 						UART_TX_FSend("%s", response_buffer);
@@ -983,7 +1306,7 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 
 	case GETTIME_CMD:
 	{
-		sprintf(data_buffer, TIME_PREFIX "%01u", current_time_index);
+		sprintf(data_buffer, TIME_PREFIX "%01u", tcs_sensors[frame->sensor].time_index);
 		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 				frame->sender, frame->frame_id, data_buffer, 0)) {
 			UART_TX_FSend("%s", response_buffer);
@@ -1031,6 +1354,561 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 	}
 	break;
 
+	case STATS_CMD:
+	{
+		ColorStats_Snapshot_t stats;
+		if (ColorStats_Read(frame->sensor, &stats)) {
+			format_stats_data(data_buffer, sizeof(data_buffer), &stats);
+		} else {
+			sprintf(data_buffer, NODATA_STR);
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETWIN_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETWIN) {
+			error = WRLEN;
+		} else {
+			int new_window = convert_char_to_int(frame->params);
+			if (new_window <= 0 || !ColorStats_SetWindow(new_window)) {
+				error = WRCMD;
+			} else {
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETWIN_CMD:
+	{
+		sprintf(data_buffer, WIN_PREFIX "%03u", ColorStats_GetWindow());
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETTRG_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETTRG) {
+			error = WRLEN;
+		} else {
+			int threshold = convert_char_to_int(&frame->params[3]);
+			char index_char = frame->params[0];
+			if (index_char < '0' || index_char > '9'
+					|| threshold < 0 || threshold > (int)TRIGGER_THRESHOLD_MAX
+					|| !ColorTrigger_SetRule(index_char - '0', frame->params[1],
+							frame->params[2], threshold, frame->sender)) {
+				error = WRCMD;
+			} else {
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETTRG_CMD:
+	{
+		char type, channel;
+		uint16_t threshold;
+		char index_char = frame->params[0];
+		if (frame->params_len != PARAM_LEN_GETTRG) {
+			error = WRLEN;
+		} else if (index_char < '0' || index_char > '9'
+				|| !ColorTrigger_GetRule(index_char - '0', &type, &channel, &threshold)) {
+			error = WRCMD;
+		} else {
+			sprintf(data_buffer, TRG_PREFIX "%c%c%c%05u", index_char, type,
+					channel, threshold);
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, data_buffer, 0)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case SETSRC_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETSRC) {
+			error = WRLEN;
+		} else {
+			char src_char = frame->params[0];
+			if (src_char == '0' || src_char == '1') {
+				TCS34725_SetSampleSource(src_char == '1' ? TCS_SOURCE_INT : TCS_SOURCE_TIMER);
+				update_sampling_timer();
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			} else {
+				error = WRCMD;
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETSRC_CMD:
+	{
+		sprintf(data_buffer, SRC_PREFIX "%01u", sample_source == TCS_SOURCE_INT ? 1 : 0);
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETAUTO_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETAUTO) {
+			error = WRLEN;
+		} else {
+			char auto_char = frame->params[0];
+			if (auto_char == '0' || auto_char == '1') {
+				AutoGain_SetEnabled(auto_char == '1');
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			} else {
+				error = WRCMD;
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETAUTO_CMD:
+	{
+		sprintf(data_buffer, AUTO_PREFIX "%01uG%01uT%01u", auto_gain_enabled ? 1 : 0,
+				tcs_sensors[frame->sensor].gain_index, tcs_sensors[frame->sensor].time_index);
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case RDLUX_CMD:
+	{
+		ColorBufferEntry_t latest;
+		if (ColorBuffer_ReadLatest(frame->sensor, &latest)) {
+			ColorCalc_Result_t result;
+			uint8_t valid = ColorCalc_Compute(&latest.data, latest.gain_index,
+					latest.time_index, &result);
+			sprintf(data_buffer, LUX_PREFIX "%08luK%05luS%01u",
+					(unsigned long) result.lux_x100, (unsigned long) result.cct,
+					valid ? 0 : 1);
+		} else {
+			sprintf(data_buffer, NODATA_STR);
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETFMT_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETFMT) {
+			error = WRLEN;
+		} else {
+			// Maska pol jako jedna cyfra szesnastkowa 1-F
+			uint16_t fmt = convert_hex_to_int(frame->params, PARAM_LEN_SETFMT);
+			if (fmt >= 1 && fmt <= ANS_FMT_ALL) {
+				ans_format = (uint8_t) fmt;
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			} else {
+				error = WRCMD;
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETFMT_CMD:
+	{
+		sprintf(data_buffer, FMT_PREFIX "%01X", ans_format);
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case GETSNS_CMD:
+	{
+		// Liczba czujnikow i stan maszyny stanow kazdego z nich
+		int len = sprintf(data_buffer, SNS_PREFIX "N%01u", TCS_SENSOR_COUNT);
+		for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+			len += sprintf(&data_buffer[len], "S%01u", (unsigned) tcs_sensors[i].state);
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case GETDUTY_CMD:
+	{
+		// Wypelnienie pracy rdzenia w 0.01% i liczba wybudzen w ostatnim oknie
+		sprintf(data_buffer, DUTY_PREFIX "%05uW%05lu", Power_GetDuty(),
+				(unsigned long) Power_GetWakeups());
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETOVS_CMD:
+	{
+		// NN - liczba usrednianych integracji (01-16), S - zapis rozrzutu (0/1)
+		if (frame->params_len != PARAM_LEN_SETOVS) {
+			error = WRLEN;
+		} else {
+			char count_str[3] = { frame->params[0], frame->params[1], '\0' };
+			int count = convert_char_to_int(count_str);
+			char spread_char = frame->params[2];
+			if (count < 1 || count > TCS_OVERSAMPLE_MAX
+					|| (spread_char != '0' && spread_char != '1')) {
+				error = WRCMD;
+			} else if ((uint32_t)count * TCS34725_GetIntegrationTimeMs(
+					tcs_sensors[frame->sensor].time_index) >= timer_interval) {
+				error = WRTIME;
+			} else {
+				TCS34725_SetOversample(frame->sensor, (uint8_t)count, spread_char - '0');
+				update_sampling_timer();
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETOVS_CMD:
+	{
+		TCS34725_Sensor_t *s = &tcs_sensors[frame->sensor];
+		sprintf(data_buffer, OVS_PREFIX "%02uS%01u", s->oversample, s->keep_spread);
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case GETTASK_CMD:
+	{
+		// Zadania harmonogramu wg priorytetu: uruchomienia, opoznienie srednie
+		// i maksymalne od zgloszenia zdarzenia oraz najdluzszy czas wykonania w us
+		int len = sprintf(data_buffer, TASK_PREFIX "N%01u", Sched_TaskCount());
+		for (uint8_t i = 0; i < Sched_TaskCount(); i++) {
+			Sched_TaskStats_t stats;
+			Sched_GetStats(i, &stats);
+			len += sprintf(&data_buffer[len], "T%01uC%08luL%06luM%06luX%06lu", i,
+					(unsigned long) (stats.runs % 100000000),
+					(unsigned long) (stats.latency_avg_us > 999999 ? 999999 : stats.latency_avg_us),
+					(unsigned long) (stats.latency_max_us > 999999 ? 999999 : stats.latency_max_us),
+					(unsigned long) (stats.exec_max_us > 999999 ? 999999 : stats.exec_max_us));
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case GETIRQ_CMD:
+	{
+		// Przerwania w kolejnosci IrqId_t: poziom NVIC, liczba obsluzen, najdluzsza
+		// obsluga i najgorsze opoznienie wejscia w 0.1 us
+		int len = sprintf(data_buffer, IRQ_PREFIX);
+		for (uint8_t i = 0; i < IRQ_ID_COUNT; i++) {
+			IrqStats_t stats;
+			IrqStats_Get((IrqId_t) i, &stats);
+			len += sprintf(&data_buffer[len], "I%01uP%02uC%06luX%05luL%05lu", i,
+					(unsigned) stats.prio,
+					(unsigned long) (stats.count % 1000000),
+					(unsigned long) (stats.exec_max_x10 > 99999 ? 99999 : stats.exec_max_x10),
+					(unsigned long) (stats.latency_max_x10 > 99999 ? 99999 : stats.latency_max_x10));
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case SETTRC_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_SETTRC) {
+			error = WRLEN;
+		} else {
+			char trace_char = frame->params[0];
+			if (trace_char == '0' || trace_char == '1') {
+				Trace_Enable(trace_char == '1');
+				if (build_response_frame(response_buffer, response_size,
+				DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+					UART_TX_FSend("%s", response_buffer);
+				}
+			} else {
+				error = WRCMD;
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case RDTRC_CMD:
+	{
+		// Strona sladu od numeru wpisu: numer pierwszego zwroconego (Q), nastepny
+		// wolny numer (H), liczba wpisow i wpisy po 16 znakow hex: czas us,
+		// zdarzenie, a8, a16. Q wiekszy od zadanego = wpisy nadpisane.
+		int64_t start = -1;
+		if (frame->params_len == PARAM_LEN_RDTRC) {
+			start = convert_char_to_u64(frame->params);
+		}
+		if (start < 0 || start > UINT32_MAX) {
+			error = (frame->params_len != PARAM_LEN_RDTRC) ? WRLEN : WRCMD;
+		} else {
+			TraceEntry_t entries[TRACE_PAGE_LEN];
+			uint32_t seq = (uint32_t) start;
+			uint8_t count = Trace_Read(&seq, entries, TRACE_PAGE_LEN);
+			int len = sprintf(data_buffer, TRC_PREFIX "Q%010luH%010luN%02u",
+					(unsigned long) seq, (unsigned long) trace_head, count);
+			for (uint8_t i = 0; i < count; i++) {
+				len += sprintf(&data_buffer[len], "%08lX%02X%02X%04X",
+						(unsigned long) entries[i].time_us, entries[i].event,
+						entries[i].a8, entries[i].a16);
+			}
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, data_buffer, 0)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case SETCLK_CMD:
+	{
+		// Profil zegara (0 - oszczedny, 1 - domyslny, 2 - maksymalny) i zapamietanie
+		// go jako profilu po starcie (0/1). OK wysylane juz z nowym taktem.
+		if (frame->params_len != PARAM_LEN_SETCLK) {
+			error = WRLEN;
+		} else if (frame->params[0] < '0' || frame->params[0] >= '0' + CLOCK_PROFILE_COUNT
+				|| (frame->params[1] != '0' && frame->params[1] != '1')) {
+			error = WRCMD;
+		} else if (Clock_SetProfile((ClockProfile_t) (frame->params[0] - '0'),
+				frame->params[1] == '1') != HAL_OK) {
+			error = WRBUSY;
+		} else {
+			if (build_response_frame(response_buffer, response_size,
+			DEVICE_ID, frame->sender, frame->frame_id, RESP_OK, 0)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case GETCLK_CMD:
+	{
+		ClockProfile_t profile = Clock_GetProfile();
+		sprintf(data_buffer, CLK_PREFIX "P%01uB%01uF%03lu", profile, Clock_GetBootProfile(),
+				(unsigned long) (Clock_GetProfileHz(profile) / 1000000));
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case RDCNT_CMD:
+	{
+		// Czas pracy w s i liczniki w kolejnosci Counter_t - bez zerowania,
+		// przeplywnosc i czestosc bledow liczy host z roznicy dwoch odczytow
+		int len = sprintf(data_buffer, CNT_PREFIX "U%010lu",
+				(unsigned long) (Timebase_NowUs() / 1000000));
+		for (uint8_t i = 0; i < CNT_COUNT; i++) {
+			len += sprintf(&data_buffer[len], "C%02u%010lu", i,
+					(unsigned long) Counter_Get((Counter_t) i));
+		}
+		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+				frame->sender, frame->frame_id, data_buffer, 0)) {
+			UART_TX_FSend("%s", response_buffer);
+		}
+	}
+		break;
+
+	case PROFILE_CMD:
+	{
+		// Statystyki jednego miejsca w cyklach rdzenia, odczyt zeruje je:
+		// liczba, min, srednia, max i histogram log2 (przedzial b = [2^b, 2^(b+1)))
+		if (frame->params_len != PARAM_LEN_PROFILE) {
+			error = WRLEN;
+		} else if (frame->params[0] < '0' || frame->params[0] >= '0' + PROF_SITE_COUNT) {
+			error = WRCMD;
+		} else {
+			uint8_t site = frame->params[0] - '0';
+			ProfileStats_t stats;
+			Profile_Read((ProfileSite_t) site, &stats, 1);
+			uint32_t avg = stats.count ? (uint32_t) (stats.sum / stats.count) : 0;
+			int len = sprintf(data_buffer, PRF_PREFIX "S%01uC%08luN%08luA%08luX%08luH", site,
+					(unsigned long) (stats.count % 100000000),
+					(unsigned long) (stats.count ? (stats.min > 99999999 ? 99999999 : stats.min) : 0),
+					(unsigned long) (avg > 99999999 ? 99999999 : avg),
+					(unsigned long) (stats.max > 99999999 ? 99999999 : stats.max));
+			for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+				len += sprintf(&data_buffer[len], "%06lu",
+						(unsigned long) (stats.hist[b] > 999999 ? 999999 : stats.hist[b]));
+			}
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, data_buffer, 0)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
+	case TIMESYNC_CMD:
+	{
+		if (frame->params_len != PARAM_LEN_TIMESYNC) {
+			error = WRLEN;
+		} else {
+			// T1 tej wymiany i T4 poprzedniej - po 16 cyfr, us od 1970-01-01 UTC
+			char t1_str[PARAM_LEN_TIMESYNC / 2 + 1];
+			char t4_str[PARAM_LEN_TIMESYNC / 2 + 1];
+			memcpy(t1_str, frame->params, PARAM_LEN_TIMESYNC / 2);
+			t1_str[PARAM_LEN_TIMESYNC / 2] = '\0';
+			memcpy(t4_str, &frame->params[PARAM_LEN_TIMESYNC / 2], PARAM_LEN_TIMESYNC / 2);
+			t4_str[PARAM_LEN_TIMESYNC / 2] = '\0';
+
+			int64_t t1 = convert_char_to_u64(t1_str);
+			int64_t t4 = convert_char_to_u64(t4_str);
+			if (t1 < 0 || t4 < 0) {
+				error = WRCMD;
+			} else {
+				TimeSync_Exchange(t1, t4, frame->rx_us);
+
+				// Ostatnia korekta: przesuniecie (ograniczone do 9 cyfr), opoznienie, dryf
+				int64_t offset = TimeSync_GetLastOffsetUs();
+				uint64_t offset_abs = offset < 0 ? -offset : offset;
+				int32_t drift = TimeSync_GetDriftPpb();
+				sprintf(data_buffer, TSY_PREFIX "S%01uO%c%09luD%06luP%c%06lu",
+						(unsigned) TimeSync_GetSource(), offset < 0 ? '-' : '+',
+						(unsigned long) (offset_abs > 999999999 ? 999999999 : offset_abs),
+						(unsigned long) TimeSync_GetLastDelayUs(),
+						drift < 0 ? '-' : '+', (unsigned long) (drift < 0 ? -drift : drift));
+				if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+						frame->sender, frame->frame_id, data_buffer, 0)) {
+					// T3 - tuz przed przekazaniem odpowiedzi do nadajnika
+					TimeSync_SetTransmitTime(Timebase_NowUs());
+					UART_TX_FSend("%s", response_buffer);
+				}
+			}
+		}
+
+		if (error) {
+			if (build_response_frame(response_buffer, response_size, DEVICE_ID,
+					frame->sender, frame->frame_id, NULL, error)) {
+				UART_TX_FSend("%s", response_buffer);
+			}
+		}
+	}
+		break;
+
 	default:
 		if (build_response_frame(response_buffer, response_size, DEVICE_ID,
 				frame->sender, frame->frame_id, NULL, WRCMD)) {
@@ -1039,3 +1917,31 @@ void process_command(Frame *frame, char *response_buffer, size_t response_size)
 		break;
 	}
 }
+
+
+// Wysyla niezamowione ramki zdarzen wyzwolonych w sciezce probkowania
+void process_trigger_events(void) {
+	TriggerEvent_t event;
+	char data_buffer[MAX_PAYLOAD_LEN];
+	char response[MAX_FRAME_LEN];
+
+	while (ColorTrigger_PopEvent(&event)) {
+		const char *host = ColorTrigger_GetHost();
+		if (!is_valid_sender(host)) {
+			continue;
+		}
+		snprintf(data_buffer, sizeof(data_buffer), EVT_PREFIX "%01u"
+				"R%05u"
+				"G%05u"
+				"B%05u"
+				"C%05u"
+				"T%010lu"
+				"@%01u", event.rule, event.data.r, event.data.g,
+				event.data.b, event.data.c, (unsigned long) event.timestamp,
+				event.sensor);
+		if (build_response_frame(response, sizeof(response), DEVICE_ID, host,
+				0, data_buffer, 0)) {
+			UART_TX_FSend("%s", response);
+		}
+	}
+}
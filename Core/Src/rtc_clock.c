@@ -0,0 +1,192 @@
+#include "main.h"
+#include "rtc_clock.h"
+
+// 32768 Hz / (127 + 1) / (255 + 1) = 1 Hz, podsekundy co 1/256 s
+#define RTC_PREDIV_A        127U
+#define RTC_PREDIV_S        255U
+
+#define LSE_STARTUP_MS      5000U
+#define RTC_INIT_TIMEOUT_MS 100U
+
+// Zakres kalendarza RTC (rok dwucyfrowy)
+#define RTC_YEAR_MIN        2000U
+#define RTC_YEAR_MAX        2099U
+
+static uint8_t rtc_ready = 0;
+
+
+static uint8_t bcd_to_bin(uint32_t bcd) {
+    return (uint8_t)(((bcd >> 4) & 0x0F) * 10 + (bcd & 0x0F));
+}
+
+static uint32_t bin_to_bcd(uint32_t bin) {
+    return ((bin / 10) << 4) | (bin % 10);
+}
+
+// Dni od 1970-01-01 dla daty kalendarza gregorianskiego i odwrotnie
+static uint32_t days_from_civil(uint32_t y, uint32_t m, uint32_t d) {
+    y -= m <= 2;
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(uint32_t days, uint32_t *y, uint32_t *m, uint32_t *d) {
+    days += 719468;
+    uint32_t era = days / 146097;
+    uint32_t doe = days - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = era * 400 + yoe + (*m <= 2);
+}
+
+static uint8_t wait_flag(volatile uint32_t *reg, uint32_t flag, uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    while (!(*reg & flag)) {
+        if (HAL_GetTick() - start > timeout_ms) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Tryb inicjalizacji - zatrzymuje kalendarz na czas zapisu TR/DR/PRER
+static uint8_t rtc_enter_init(void) {
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->ISR = 0xFFFFFFFFU;
+    if (!wait_flag(&RTC->ISR, RTC_ISR_INITF, RTC_INIT_TIMEOUT_MS)) {
+        RTC->WPR = 0xFF;
+        return 0;
+    }
+    return 1;
+}
+
+static void rtc_exit_init(void) {
+    RTC->ISR &= ~RTC_ISR_INIT;
+    RTC->WPR = 0xFF;
+}
+
+// Rejestry cienia TR/DR/SSR sa aktualne dopiero po synchronizacji (RSF) po resecie
+static uint8_t rtc_wait_sync(void) {
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->ISR &= ~RTC_ISR_RSF;
+    RTC->WPR = 0xFF;
+    return wait_flag(&RTC->ISR, RTC_ISR_RSF, RTC_INIT_TIMEOUT_MS);
+}
+
+
+// Zwraca 1, gdy kalendarz ustawiony wczesniej przez TIMESYNC pracuje dalej po resecie.
+// W przeciwnym razie domena zapasowa jest resetowana i RTC startuje od nowa z LSE.
+uint8_t RtcClock_Init(void) {
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    if ((RCC->BDCR & RCC_BDCR_RTCEN) && (RCC->BDCR & RCC_BDCR_LSERDY)
+            && (RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_0
+            && (RTC->ISR & RTC_ISR_INITS)) {
+        rtc_ready = rtc_wait_sync();
+        return rtc_ready && RtcClock_BackupRead(RTC_CLOCK_BKP_MAGIC) == RTC_CLOCK_MAGIC;
+    }
+
+    // Zmiana zrodla zegara RTC wymaga resetu domeny zapasowej
+    __HAL_RCC_BACKUPRESET_FORCE();
+    __HAL_RCC_BACKUPRESET_RELEASE();
+
+    RCC->BDCR |= RCC_BDCR_LSEON;
+    if (!wait_flag(&RCC->BDCR, RCC_BDCR_LSERDY, LSE_STARTUP_MS)) {
+        rtc_ready = 0;
+        return 0;
+    }
+    MODIFY_REG(RCC->BDCR, RCC_BDCR_RTCSEL, RCC_BDCR_RTCSEL_0);
+    RCC->BDCR |= RCC_BDCR_RTCEN;
+
+    if (rtc_enter_init()) {
+        RTC->CR &= ~RTC_CR_FMT;
+        // Dwa osobne zapisy PRER wymagane przez RM0390
+        RTC->PRER = RTC_PREDIV_S;
+        RTC->PRER |= RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+        rtc_exit_init();
+        rtc_ready = 1;
+    }
+    return 0;
+}
+
+// Czas z kalendarza w us od 1970-01-01 UTC (rozdzielczosc 1/256 s)
+uint8_t RtcClock_Read(uint64_t *epoch_us) {
+    if (!rtc_ready || RtcClock_BackupRead(RTC_CLOCK_BKP_MAGIC) != RTC_CLOCK_MAGIC) {
+        return 0;
+    }
+
+    // Odczyt SSR blokuje TR i DR az do odczytu DR - spojny znacznik czasu
+    uint32_t ssr = RTC->SSR;
+    uint32_t tr = RTC->TR;
+    uint32_t dr = RTC->DR;
+
+    uint32_t year = RTC_YEAR_MIN + bcd_to_bin((dr >> RTC_DR_YU_Pos) & 0xFF);
+    uint32_t month = bcd_to_bin((dr >> RTC_DR_MU_Pos) & 0x1F);
+    uint32_t day = bcd_to_bin(dr & (RTC_DR_DT | RTC_DR_DU));
+    uint32_t hours = bcd_to_bin((tr >> RTC_TR_HU_Pos) & 0x3F);
+    uint32_t minutes = bcd_to_bin((tr >> RTC_TR_MNU_Pos) & 0x7F);
+    uint32_t seconds = bcd_to_bin(tr & (RTC_TR_ST | RTC_TR_SU));
+
+    uint64_t total_s = (uint64_t)days_from_civil(year, month, day) * 86400
+                       + hours * 3600 + minutes * 60 + seconds;
+    uint32_t frac_us = (RTC_PREDIV_S - ssr) * 1000000U / (RTC_PREDIV_S + 1);
+
+    *epoch_us = total_s * 1000000U + frac_us + RtcClock_BackupRead(RTC_CLOCK_BKP_SUBUS);
+    return 1;
+}
+
+// Kalendarz rusza od pelnej sekundy w chwili wyjscia z trybu inicjalizacji,
+// czesc ulamkowa jest zapamietywana w rejestrze zapasowym
+void RtcClock_Write(uint64_t epoch_us) {
+    uint32_t total_s = (uint32_t)(epoch_us / 1000000U);
+    uint32_t days = total_s / 86400;
+    uint32_t rem = total_s % 86400;
+    uint32_t year, month, day;
+
+    civil_from_days(days, &year, &month, &day);
+    if (!rtc_ready || year < RTC_YEAR_MIN || year > RTC_YEAR_MAX) {
+        return;
+    }
+
+    // Dzien tygodnia 1 = poniedzialek; 1970-01-01 byl czwartkiem
+    uint32_t weekday = (days + 3) % 7 + 1;
+
+    uint32_t tr = (bin_to_bcd(rem / 3600) << RTC_TR_HU_Pos)
+                | (bin_to_bcd(rem / 60 % 60) << RTC_TR_MNU_Pos)
+                | bin_to_bcd(rem % 60);
+    uint32_t dr = (bin_to_bcd(year - RTC_YEAR_MIN) << RTC_DR_YU_Pos)
+                | (weekday << RTC_DR_WDU_Pos)
+                | (bin_to_bcd(month) << RTC_DR_MU_Pos)
+                | bin_to_bcd(day);
+
+    if (rtc_enter_init()) {
+        RTC->TR = tr;
+        RTC->DR = dr;
+        rtc_exit_init();
+        RtcClock_BackupWrite(RTC_CLOCK_BKP_SUBUS, (uint32_t)(epoch_us % 1000000U));
+        RtcClock_BackupWrite(RTC_CLOCK_BKP_MAGIC, RTC_CLOCK_MAGIC);
+        rtc_wait_sync();
+    }
+}
+
+uint32_t RtcClock_BackupRead(uint8_t reg) {
+    if (reg >= RTC_BKP_NUMBER) {
+        return 0;
+    }
+    return (&RTC->BKP0R)[reg];
+}
+
+void RtcClock_BackupWrite(uint8_t reg, uint32_t value) {
+    if (reg < RTC_BKP_NUMBER) {
+        (&RTC->BKP0R)[reg] = value;
+    }
+}
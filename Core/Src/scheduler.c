@@ -0,0 +1,187 @@
+#include "main.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "power.h"
+#include "irq_prio.h"
+
+// Zadanie uruchamiane do konca, gdy ustawiona jest ktoras z jego flag.
+// Kolejnosc dodania wyznacza priorytet - pierwsze dodane jest najwazniejsze.
+typedef struct {
+    Sched_TaskFn_t fn;
+    uint32_t events;
+    uint32_t runs;
+    uint64_t latency_sum_us;
+    uint32_t latency_max_us;
+    uint32_t exec_max_us;
+} Sched_Task_t;
+
+static Sched_Task_t tasks[SCHED_TASKS_MAX];
+static uint8_t task_count = 0;
+
+static volatile uint32_t pending = 0;
+static uint64_t signal_us[SCHED_EVT_COUNT];      // Ustawienie flagi z 0 na 1
+
+// Zdarzenia odlozone w czasie - sprawdzane w przerwaniu SysTick
+static volatile uint32_t armed = 0;
+static uint32_t deadline_tick[SCHED_EVT_COUNT];
+
+
+// Flagi ustawiane sa najwyzej z poziomu czujnikow - TIM5 nie jest maskowany
+static inline uint32_t sched_lock(void) {
+    return Irq_Lock(IRQ_PRIO_SENSOR);
+}
+
+static inline void sched_unlock(uint32_t key) {
+    Irq_Unlock(key);
+}
+
+// Pierwszy przebieg wszystkich zadan po starcie
+void Sched_Init(void) {
+    task_count = 0;
+    armed = 0;
+    pending = SCHED_EVT_ALL;
+    uint64_t now = Timebase_NowUs();
+    for (uint8_t i = 0; i < SCHED_EVT_COUNT; i++) {
+        signal_us[i] = now;
+    }
+}
+
+uint8_t Sched_AddTask(Sched_TaskFn_t fn, uint32_t events) {
+    if (task_count >= SCHED_TASKS_MAX || fn == NULL) {
+        return 0;
+    }
+    Sched_Task_t *t = &tasks[task_count];
+    t->fn = fn;
+    t->events = events;
+    t->runs = 0;
+    t->latency_sum_us = 0;
+    t->latency_max_us = 0;
+    t->exec_max_us = 0;
+    task_count++;
+    return 1;
+}
+
+// Wywolywane z przerwan i z petli glownej
+void Sched_Signal(uint32_t events) {
+    uint32_t key = sched_lock();
+    uint32_t fresh = events & ~pending;
+    if (fresh) {
+        uint64_t now = Timebase_NowUs();
+        for (uint8_t i = 0; i < SCHED_EVT_COUNT; i++) {
+            if (fresh & (1U << i)) {
+                signal_us[i] = now;
+            }
+        }
+        pending |= fresh;
+    }
+    sched_unlock(key);
+}
+
+// Praca zalezna od czasu (odstep, ponowienie) - zamiast odpytywania w kazdej petli.
+// Przy kilku terminach tej samej flagi obowiazuje najblizszy.
+void Sched_SignalAfter(uint32_t events, uint32_t delay_ms) {
+    uint32_t key = sched_lock();
+    uint32_t due = HAL_GetTick() + delay_ms;
+    for (uint8_t i = 0; i < SCHED_EVT_COUNT; i++) {
+        uint32_t bit = 1U << i;
+        if (events & bit) {
+            if (!(armed & bit) || (int32_t)(due - deadline_tick[i]) < 0) {
+                deadline_tick[i] = due;
+            }
+            armed |= bit;
+        }
+    }
+    sched_unlock(key);
+}
+
+// Z przerwania SysTick po HAL_IncTick
+void Sched_OnTick(void) {
+    if (!armed) {
+        return;
+    }
+    uint32_t now = HAL_GetTick();
+    uint32_t due = 0;
+    for (uint8_t i = 0; i < SCHED_EVT_COUNT; i++) {
+        uint32_t bit = 1U << i;
+        if ((armed & bit) && (int32_t)(now - deadline_tick[i]) >= 0) {
+            due |= bit;
+        }
+    }
+    if (due) {
+        armed &= ~due;
+        Sched_Signal(due);
+    }
+}
+
+// Najblizszy termin zdarzenia odlozonego (tick HAL) lub SCHED_NO_DEADLINE
+uint32_t Sched_NextDeadline(void) {
+    uint32_t now = HAL_GetTick();
+    int32_t nearest = INT32_MAX;
+    for (uint8_t i = 0; i < SCHED_EVT_COUNT; i++) {
+        int32_t left = (int32_t)(deadline_tick[i] - now);
+        if ((armed & (1U << i)) && left < nearest) {
+            nearest = left;
+        }
+    }
+    if (nearest == INT32_MAX) {
+        return SCHED_NO_DEADLINE;
+    }
+    return nearest > 0 ? now + (uint32_t)nearest : now;
+}
+
+uint8_t Sched_HasPending(void) {
+    return pending != 0;
+}
+
+// Jedno zadanie o najwyzszym priorytecie z ustawiona flaga; bez pracy - uspienie
+// w Power_Idle do nastepnego przerwania
+void Sched_Run(void) {
+    for (uint8_t i = 0; i < task_count; i++) {
+        Sched_Task_t *t = &tasks[i];
+        if (!(pending & t->events)) {
+            continue;
+        }
+
+        // Flagi kasowane przed zadaniem - zgloszenia w trakcie uruchomia je ponownie
+        uint32_t key = sched_lock();
+        uint32_t taken = pending & t->events;
+        pending &= ~taken;
+        uint64_t first_us = UINT64_MAX;
+        for (uint8_t e = 0; e < SCHED_EVT_COUNT; e++) {
+            if ((taken & (1U << e)) && signal_us[e] < first_us) {
+                first_us = signal_us[e];
+            }
+        }
+        sched_unlock(key);
+
+        uint64_t start_us = Timebase_NowUs();
+        t->fn();
+        uint64_t end_us = Timebase_NowUs();
+
+        uint32_t latency = (uint32_t)(start_us - first_us);
+        uint32_t exec = (uint32_t)(end_us - start_us);
+        t->runs++;
+        t->latency_sum_us += latency;
+        if (latency > t->latency_max_us) {
+            t->latency_max_us = latency;
+        }
+        if (exec > t->exec_max_us) {
+            t->exec_max_us = exec;
+        }
+        return;
+    }
+
+    Power_Idle();
+}
+
+uint8_t Sched_TaskCount(void) {
+    return task_count;
+}
+
+void Sched_GetStats(uint8_t task, Sched_TaskStats_t *stats) {
+    Sched_Task_t *t = &tasks[task];
+    stats->runs = t->runs;
+    stats->latency_max_us = t->latency_max_us;
+    stats->latency_avg_us = t->runs ? (uint32_t)(t->latency_sum_us / t->runs) : 0;
+    stats->exec_max_us = t->exec_max_us;
+}
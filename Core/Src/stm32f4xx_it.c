@@ -22,6 +22,8 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "scheduler.h"
+#include "irq_prio.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -59,7 +61,8 @@ extern DMA_HandleTypeDef hdma_i2c1_rx;
 extern DMA_HandleTypeDef hdma_i2c1_tx;
 extern I2C_HandleTypeDef hi2c1;
 extern UART_HandleTypeDef huart2;
-extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim5;
 /* USER CODE BEGIN EV */
 
 /* USER CODE END EV */
@@ -187,11 +190,12 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  Sched_OnTick();
+  IrqStats_Exit(IRQ_ID_SYSTICK, irq_start);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -202,17 +206,31 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles EXTI line2 interrupt.
+  */
+void EXTI2_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI2_IRQn 0 */
+  uint32_t irq_start = IrqStats_Enter();
+  /* USER CODE END EXTI2_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(TCS_INT_Pin);
+  /* USER CODE BEGIN EXTI2_IRQn 1 */
+  IrqStats_Exit(IRQ_ID_EXTI2, irq_start);
+  /* USER CODE END EXTI2_IRQn 1 */
+}
+
 /**
   * @brief This function handles DMA1 stream0 global interrupt.
   */
 void DMA1_Stream0_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream0_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END DMA1_Stream0_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_i2c1_rx);
   /* USER CODE BEGIN DMA1_Stream0_IRQn 1 */
-
+  IrqStats_Exit(IRQ_ID_DMA1_S0, irq_start);
   /* USER CODE END DMA1_Stream0_IRQn 1 */
 }
 
@@ -222,11 +240,11 @@ void DMA1_Stream0_IRQHandler(void)
 void DMA1_Stream6_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream6_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END DMA1_Stream6_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_i2c1_tx);
   /* USER CODE BEGIN DMA1_Stream6_IRQn 1 */
-
+  IrqStats_Exit(IRQ_ID_DMA1_S6, irq_start);
   /* USER CODE END DMA1_Stream6_IRQn 1 */
 }
 
@@ -236,11 +254,11 @@ void DMA1_Stream6_IRQHandler(void)
 void I2C1_EV_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_EV_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END I2C1_EV_IRQn 0 */
   HAL_I2C_EV_IRQHandler(&hi2c1);
   /* USER CODE BEGIN I2C1_EV_IRQn 1 */
-
+  IrqStats_Exit(IRQ_ID_I2C1_EV, irq_start);
   /* USER CODE END I2C1_EV_IRQn 1 */
 }
 
@@ -250,11 +268,11 @@ void I2C1_EV_IRQHandler(void)
 void I2C1_ER_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_ER_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END I2C1_ER_IRQn 0 */
   HAL_I2C_ER_IRQHandler(&hi2c1);
   /* USER CODE BEGIN I2C1_ER_IRQn 1 */
-
+  IrqStats_Exit(IRQ_ID_I2C1_ER, irq_start);
   /* USER CODE END I2C1_ER_IRQn 1 */
 }
 
@@ -264,26 +282,40 @@ void I2C1_ER_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  uint32_t irq_start = IrqStats_Enter();
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
-
+  IrqStats_Exit(IRQ_ID_USART2, irq_start);
   /* USER CODE END USART2_IRQn 1 */
 }
 
 /**
-  * @brief This function handles TIM3 global interrupt.
+  * @brief This function handles TIM2 global interrupt.
   */
-void TIM3_IRQHandler(void)
+void TIM2_IRQHandler(void)
 {
-  /* USER CODE BEGIN TIM3_IRQn 0 */
-
-  /* USER CODE END TIM3_IRQn 0 */
-  HAL_TIM_IRQHandler(&htim3);
-  /* USER CODE BEGIN TIM3_IRQn 1 */
+  /* USER CODE BEGIN TIM2_IRQn 0 */
+  uint32_t irq_start = IrqStats_Enter();
+  /* USER CODE END TIM2_IRQn 0 */
+  HAL_TIM_IRQHandler(&htim2);
+  /* USER CODE BEGIN TIM2_IRQn 1 */
+  IrqStats_Exit(IRQ_ID_TIM2, irq_start);
+  /* USER CODE END TIM2_IRQn 1 */
+}
 
-  /* USER CODE END TIM3_IRQn 1 */
+/**
+  * @brief This function handles TIM5 global interrupt.
+  */
+void TIM5_IRQHandler(void)
+{
+  /* USER CODE BEGIN TIM5_IRQn 0 */
+  uint32_t irq_start = IrqStats_Enter();
+  /* USER CODE END TIM5_IRQn 0 */
+  HAL_TIM_IRQHandler(&htim5);
+  /* USER CODE BEGIN TIM5_IRQn 1 */
+  IrqStats_Exit(IRQ_ID_TIM5, irq_start);
+  /* USER CODE END TIM5_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
@@ -1,129 +1,681 @@
 #include "tcs34725.h"
 #include "circular_buffer.h"
 #include "protocol.h"
-#include "i2c.h"
+#include "auto_gain.h"
+#include "color_calc.h"
+#include "timebase.h"
+#include "scheduler.h"
+#include "irq_prio.h"
+#include "profile.h"
+#include "counters.h"
+#include "trace.h"
 #include <stdint.h>
+#include <string.h>
 
-volatile TCS_State_t sensor_state = TCS_STATE_INIT_READ_ID;
+volatile TCS_Source_t sample_source = TCS_SOURCE_TIMER;
+volatile uint8_t sampling_active = 0;
+volatile uint32_t tcs_recovery_count = 0;    // Liczba odblokowan magistrali
 
-uint8_t dma_buffer[8];
+// Wstrzymanie startu nowych transakcji (np. na czas zmiany zegara) - kolejki rosna dalej
+static volatile uint8_t buses_held = 0;
 
-static uint32_t tcs_poweron_tick = 0;
-static uint8_t config_step = 0;
+// Tablice tcs_buses i tcs_sensors (konfiguracja stanowiska) sa zdefiniowane
+// razem z operacjami magistrali w tcs34725_hal.c
 
-void TCS34725_WriteReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t value) {
-    static uint8_t data[2];
-    data[0] = TCS34725_COMMAND_BIT | reg;
-    data[1] = value;
 
-    if (HAL_I2C_GetState(hi2c) != HAL_I2C_STATE_READY) {
-        return;
-    }
+// Krotka sekcja krytyczna dla kolejki (zapis z petli glownej i z przerwan EXTI, TIM2,
+// I2C i DMA) - maskuje poziom czujnikow i nizsze, TIM5 dziala dalej
+static inline uint32_t xfer_lock(void) {
+    return Irq_Lock(IRQ_PRIO_SENSOR);
+}
 
-    HAL_I2C_Master_Transmit_DMA(hi2c, TCS34725_ADDRESS, data, 2);
+static inline void xfer_unlock(uint32_t key) {
+    Irq_Unlock(key);
 }
 
+static TCS34725_Bus_t* bus_of(uint8_t sensor) {
+    return &tcs_buses[tcs_sensors[sensor].bus];
+}
 
-void TCS34725_Init(I2C_HandleTypeDef *hi2c) {
-    (void)hi2c;
-    config_step = 0;
-    sensor_state = TCS_STATE_INIT_READ_ID;
+static void set_state(uint8_t sensor, TCS_State_t state) {
+    tcs_sensors[sensor].state = state;
+    Trace_Event(TRC_STATE, sensor, state);
 }
 
-// Glowna petla obslugi czujnika
-void TCS34725_HandleLoop(I2C_HandleTypeDef *hi2c) {
-    
-    //Oczyt id
-    if (sensor_state == TCS_STATE_INIT_READ_ID) {
-        if (HAL_I2C_GetState(hi2c) == HAL_I2C_STATE_READY) {
-            uint8_t reg_addr = TCS34725_COMMAND_BIT | TCS34725_ID;
-            HAL_StatusTypeDef status = HAL_I2C_Mem_Read_DMA(hi2c,
-                                                           TCS34725_ADDRESS,
-                                                           reg_addr,
-                                                           I2C_MEMADD_SIZE_8BIT,
-                                                           dma_buffer,
-                                                           1);
+// Start transakcji z poczatku kolejki, jesli magistrala jest wolna.
+// Przed transakcja czujnika za multiplekserem wybierany jest jego kanal.
+static void xfer_kick(TCS34725_Bus_t *bus) {
+    uint32_t key = xfer_lock();
+
+    if (!bus->active && !bus->error && !buses_held && bus->count > 0) {
+        TCS34725_Xfer_t *xfer = &bus->queue[bus->head];
+        uint8_t mux_channel = tcs_sensors[xfer->sensor].mux_channel;
+        HAL_StatusTypeDef status;
+
+        if (mux_channel != TCS_NO_MUX && mux_channel != bus->mux_channel) {
+            bus->mux_mask = (uint8_t)(1U << mux_channel);
+            status = bus->ops->write(bus->ctx, TCA9548A_ADDRESS, &bus->mux_mask, 1);
             if (status == HAL_OK) {
-                sensor_state = TCS_STATE_BUSY;
+                bus->mux_switching = 1;
             }
+        } else if (xfer->type == TCS_XFER_READ) {
+            status = bus->ops->mem_read(bus->ctx, TCS34725_ADDRESS, xfer->reg, xfer->data, xfer->len);
+        } else {
+            status = bus->ops->write(bus->ctx, TCS34725_ADDRESS, xfer->data, xfer->len);
+        }
+
+        // Przy HAL_BUSY transakcja zostaje w kolejce - ponowienie w TCS34725_HandleLoop
+        if (status == HAL_OK) {
+            bus->active = 1;
+            Trace_Event(TRC_XFER_START, (uint8_t)(bus - tcs_buses),
+                        (uint16_t)(xfer->sensor << 8) | xfer->reg);
+        } else {
+            Sched_SignalAfter(SCHED_EVT_SENSOR, 1);
         }
     }
-   //Konfiguracja czujnika
-    else if (sensor_state == TCS_STATE_CONFIGURING) {
-        if (HAL_I2C_GetState(hi2c) == HAL_I2C_STATE_READY) {
-            switch (config_step) {
-                case 0:
-                    TCS34725_WriteReg(hi2c, TCS34725_ATIME, TIME_TABLE[current_time_index]);
-                    config_step = 1;
-                    break;
-
-                case 1:
-                    TCS34725_WriteReg(hi2c, TCS34725_CONTROL, GAIN_TABLE[current_gain_index]);
-                    config_step = 2;
-                    break;
-
-                case 2:
-                    TCS34725_WriteReg(hi2c, TCS34725_ENABLE, TCS34725_ENABLE_PON);
-                    tcs_poweron_tick = HAL_GetTick();
-                    sensor_state = TCS_STATE_POWERUP_WAIT;
-                    break;
-            }
+
+    xfer_unlock(key);
+}
+
+static HAL_StatusTypeDef xfer_submit(uint8_t sensor, TCS_XferType_t type,
+                                     uint8_t reg, const uint8_t *data, uint8_t len,
+                                     TCS34725_XferCallback_t callback) {
+    TCS34725_Bus_t *bus = bus_of(sensor);
+    uint32_t key = xfer_lock();
+
+    if (bus->count >= TCS_XFER_QUEUE_LEN) {
+        xfer_unlock(key);
+        return HAL_BUSY;
+    }
+
+    TCS34725_Xfer_t *xfer = &bus->queue[(bus->head + bus->count) % TCS_XFER_QUEUE_LEN];
+    xfer->type = type;
+    xfer->sensor = sensor;
+    xfer->reg = reg;
+    xfer->len = len;
+    xfer->callback = callback;
+    if (data != NULL) {
+        memcpy(xfer->data, data, len);
+    }
+    bus->count++;
+
+    xfer_unlock(key);
+
+    xfer_kick(bus);
+    return HAL_OK;
+}
+
+// Porzucenie wszystkich transakcji po bledzie magistrali (bez callbackow)
+static void xfer_flush(TCS34725_Bus_t *bus) {
+    uint32_t key = xfer_lock();
+    bus->head = 0;
+    bus->count = 0;
+    bus->active = 0;
+    bus->mux_switching = 0;
+    bus->mux_channel = TCS_NO_MUX;
+    bus->error = 0;
+    xfer_unlock(key);
+}
+
+// Zakonczenie transakcji z poczatku kolejki i start kolejnej (z przerwania magistrali)
+void TCS34725_BusComplete(TCS34725_Bus_t *bus) {
+    TCS34725_Xfer_t *xfer = &bus->queue[bus->head];
+
+    // Wybrano kanal multipleksera - wlasciwa transakcja nadal czeka na poczatku kolejki
+    if (bus->mux_switching) {
+        bus->mux_switching = 0;
+        bus->mux_channel = tcs_sensors[xfer->sensor].mux_channel;
+        bus->active = 0;
+        xfer_kick(bus);
+        return;
+    }
+
+    Trace_Event(TRC_XFER_DONE, (uint8_t)(bus - tcs_buses), xfer->sensor);
+    if (xfer->callback != NULL) {
+        xfer->callback(xfer->sensor, xfer);
+    }
+
+    uint32_t key = xfer_lock();
+    bus->head = (bus->head + 1) % TCS_XFER_QUEUE_LEN;
+    bus->count--;
+    bus->active = 0;
+    xfer_unlock(key);
+
+    xfer_kick(bus);
+    Sched_Signal(SCHED_EVT_SENSOR);
+}
+
+// Wstrzymanie / wznowienie magistral; biezace transakcje koncza sie normalnie
+void TCS34725_HoldBuses(uint8_t hold) {
+    buses_held = hold;
+    if (!hold) {
+        for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+            xfer_kick(&tcs_buses[b]);
         }
     }
-    //Czekanie 3ms na rozruch oscylatora
-    else if (sensor_state == TCS_STATE_POWERUP_WAIT) {
-        if ((HAL_GetTick() - tcs_poweron_tick) >= 3) {
-            if (HAL_I2C_GetState(hi2c) == HAL_I2C_STATE_READY) {
-                TCS34725_WriteReg(hi2c, TCS34725_ENABLE, TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
-                sensor_state = TCS_STATE_READY;
-            }
+}
+
+uint8_t TCS34725_BusesIdle(void) {
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        if (tcs_buses[b].active) {
+            return 0;
         }
     }
+    return 1;
 }
 
-// Rozpoczecie odczytu danych kolorow przez DMA
-void TCS34725_Start_DMA_Read(I2C_HandleTypeDef *hi2c) {
-    if (sensor_state != TCS_STATE_READY) {
-        return;
+HAL_StatusTypeDef TCS34725_QueueRead(uint8_t sensor, uint8_t reg, uint8_t len,
+                                     TCS34725_XferCallback_t callback) {
+    if (sensor >= TCS_SENSOR_COUNT || len == 0 || len > TCS_XFER_DATA_LEN) {
+        return HAL_ERROR;
     }
+    return xfer_submit(sensor, TCS_XFER_READ, TCS34725_COMMAND_BIT | reg, NULL, len, callback);
+}
+
+HAL_StatusTypeDef TCS34725_QueueWrite(uint8_t sensor, uint8_t reg, uint8_t value,
+                                      TCS34725_XferCallback_t callback) {
+    if (sensor >= TCS_SENSOR_COUNT) {
+        return HAL_ERROR;
+    }
+    uint8_t data[2] = { TCS34725_COMMAND_BIT | reg, value };
+    return xfer_submit(sensor, TCS_XFER_WRITE, data[0], data, 2, callback);
+}
 
-    sensor_state = TCS_STATE_BUSY;
+HAL_StatusTypeDef TCS34725_WriteReg(uint8_t sensor, uint8_t reg, uint8_t value) {
+    return TCS34725_QueueWrite(sensor, reg, value, NULL);
+}
 
-    uint8_t reg_addr = TCS34725_COMMAND_BIT | 0x20 | TCS34725_CDATAL;
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Read_DMA(hi2c,
-                                                   TCS34725_ADDRESS,
-                                                   reg_addr,
-                                                   I2C_MEMADD_SIZE_8BIT,
-                                                   dma_buffer,
-                                                   8);
-    if (status != HAL_OK) {
-        sensor_state = TCS_STATE_READY;
+// Probki odczytane przed zakonczeniem zapisu (wczesniej w kolejce) pochodza z integracji
+// na poprzednich ustawieniach - archiwum dostaje nowy indeks dopiero od tej chwili
+static void on_control_written(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    for (uint8_t i = 0; i < GAIN_VALUES_COUNT; i++) {
+        if (GAIN_TABLE[i] == xfer->data[1]) {
+            tcs_sensors[sensor].gain_applied = i;
+        }
     }
 }
 
-// Callback po zakonczeniu odczytu DMA
-void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
-    if (hi2c->Instance != hi2c1.Instance) {
-        return;
+static void on_atime_written(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    for (uint8_t i = 0; i < TIME_VALUES_COUNT; i++) {
+        if ((TIME_TABLE[i] & 0xFF) == xfer->data[1]) {
+            tcs_sensors[sensor].time_applied = i;
+        }
     }
+}
 
-    // Jesli bylismy w trakcie odczytu ID (inicjalizacja)
-    if (sensor_state == TCS_STATE_BUSY && config_step == 0) {
-        if (dma_buffer[0] == TCS34725_EXPECTED_ID) {
-            sensor_state = TCS_STATE_CONFIGURING;
-        } else {
-            sensor_state = TCS_STATE_ERROR;
+// Zmiana wzmocnienia: gain_index od razu (GETGAIN, auto-gain), gain_applied po zapisie
+HAL_StatusTypeDef TCS34725_SetGain(uint8_t sensor, uint8_t gain_index) {
+    if (gain_index >= GAIN_VALUES_COUNT) {
+        return HAL_ERROR;
+    }
+    HAL_StatusTypeDef status = TCS34725_QueueWrite(sensor, TCS34725_CONTROL, GAIN_TABLE[gain_index],
+                                                   on_control_written);
+    if (status == HAL_OK) {
+        tcs_sensors[sensor].gain_index = gain_index;
+    }
+    return status;
+}
+
+HAL_StatusTypeDef TCS34725_SetTime(uint8_t sensor, uint8_t time_index) {
+    if (time_index >= TIME_VALUES_COUNT) {
+        return HAL_ERROR;
+    }
+    HAL_StatusTypeDef status = TCS34725_QueueWrite(sensor, TCS34725_ATIME, TIME_TABLE[time_index],
+                                                   on_atime_written);
+    if (status == HAL_OK) {
+        tcs_sensors[sensor].time_index = time_index;
+    }
+    return status;
+}
+
+// Czas integracji w ms dla indeksu TIME_TABLE (zaokraglony w gore)
+uint16_t TCS34725_GetIntegrationTimeMs(uint8_t index) {
+    switch (index) {
+        case 0: return 3;   // 2.4ms
+        case 1: return 24;  // 24ms
+        case 2: return 101; // 101ms
+        case 3: return 154; // 154ms
+        case 4: return 700; // 700ms
+        default: return 0;
+    }
+}
+
+static uint8_t oversample_count(uint8_t sensor) {
+    uint8_t count = tcs_sensors[sensor].oversample;
+    return count > 1 ? count : 1;
+}
+
+// Czas zebrania jednej probki: integracja razy liczba usrednianych integracji
+uint32_t TCS34725_GetSampleTimeMs(uint8_t sensor, uint8_t time_index) {
+    return (uint32_t)TCS34725_GetIntegrationTimeMs(time_index) * oversample_count(sensor);
+}
+
+// Najdluzszy czas probki sposrod czujnikow - ogranicza wspolny interwal timera
+uint32_t TCS34725_GetMaxSampleTimeMs(void) {
+    uint32_t max_ms = 0;
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        uint32_t ms = TCS34725_GetSampleTimeMs(i, tcs_sensors[i].time_index);
+        if (ms > max_ms) {
+            max_ms = ms;
         }
+    }
+    return max_ms;
+}
+
+// Odstep miedzy integracjami w 0.1ms (przy nadprobkowaniu - czesc timer_interval)
+static uint32_t integration_interval_01ms(uint8_t sensor) {
+    return timer_interval * 10 / oversample_count(sensor);
+}
+
+// Czy czujnik jest wyzwalany linia INT. Bez linii INT, albo gdy odstepu nie da sie
+// odmierzyc oczekiwaniem WTIME/WLONG, odczyty wyzwala timer. Granica nie zalezy od ATIME,
+// wiec zmiana czasu integracji (auto-gain) nie przelacza zrodla w trakcie pracy.
+static uint8_t uses_interrupt(uint8_t sensor) {
+    return sample_source == TCS_SOURCE_INT && tcs_sensors[sensor].int_port != NULL
+            && integration_interval_01ms(sensor) <= TCS34725_WAIT_MAX_01MS;
+}
+
+// Kasowanie przerwania RGBC - czujnik zwalnia linie INT
+static HAL_StatusTypeDef TCS34725_ClearInterrupt(uint8_t sensor,
+                                                 TCS34725_XferCallback_t callback) {
+    uint8_t cmd = TCS34725_COMMAND_BIT | TCS34725_SPECIAL_FN | TCS34725_SF_CLEAR_INT;
+    return xfer_submit(sensor, TCS_XFER_WRITE, cmd, &cmd, 1, callback);
+}
+
+// Czy czujnik zakonczyl inicjalizacje (zapisy konfiguracji maja sens)
+static uint8_t is_configured(uint8_t sensor) {
+    TCS_State_t state = tcs_sensors[sensor].state;
+    return state == TCS_STATE_READY || state == TCS_STATE_BUSY
+            || state == TCS_STATE_CLEARING;
+}
+
+// Liczba krokow oczekiwania, aby cykl ATIME + WTIME trwal timer_interval
+// (przy nadprobkowaniu - jego czesc przypadajaca na jedna integracje).
+// Zwraca 0 gdy oczekiwanie nie jest potrzebne; *wlong ustawiane dla dlugich przerw.
+static uint16_t wait_steps(uint8_t sensor, uint8_t *wlong) {
+    uint32_t atime_01ms = (uint32_t)(256 - (TIME_TABLE[tcs_sensors[sensor].time_index] & 0xFF))
+                          * TCS34725_WTIME_STEP_01MS;
+    uint32_t interval_01ms = integration_interval_01ms(sensor);
+
+    *wlong = 0;
+    if (!uses_interrupt(sensor) || interval_01ms <= atime_01ms + TCS34725_WTIME_STEP_01MS) {
+        return 0;
+    }
+
+    uint32_t wait_01ms = interval_01ms - atime_01ms;
+    uint32_t steps = (wait_01ms + TCS34725_WTIME_STEP_01MS / 2) / TCS34725_WTIME_STEP_01MS;
+    if (steps > TCS34725_WTIME_MAX_STEPS) {
+        uint32_t long_step = TCS34725_WTIME_STEP_01MS * TCS34725_WLONG_FACTOR;
+        *wlong = 1;
+        steps = (wait_01ms + long_step / 2) / long_step;
+        if (steps > TCS34725_WTIME_MAX_STEPS) {
+            steps = TCS34725_WTIME_MAX_STEPS;
+        }
+    }
+    return (uint16_t)steps;
+}
+
+// Stan oczekiwania czujnika (WEN/WTIME/WLONG) - w trybie INT czujnik sam odmierza
+// interwal i usypia sie miedzy integracjami, a MCU budzi dopiero przerwanie.
+void TCS34725_ApplyPacing(uint8_t sensor) {
+    if (!is_configured(sensor)) {
+        return; // Konfiguracje wykona apply_source_config po rozruchu
+    }
+
+    uint8_t wlong;
+    uint16_t steps = wait_steps(sensor, &wlong);
+    uint8_t enable = TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN;
+
+    if (uses_interrupt(sensor)) {
+        enable |= TCS34725_ENABLE_AIEN;
+    }
+    if (steps > 0) {
+        enable |= TCS34725_ENABLE_WEN;
+        TCS34725_WriteReg(sensor, TCS34725_WTIME, (uint8_t)(256 - steps));
+        TCS34725_WriteReg(sensor, TCS34725_CONFIG, wlong ? TCS34725_CONFIG_WLONG : 0);
+    }
+    TCS34725_WriteReg(sensor, TCS34725_ENABLE, enable);
+}
+
+void TCS34725_ApplyPacingAll(void) {
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TCS34725_ApplyPacing(i);
+    }
+}
+
+// Timer probkowania jest potrzebny tylko czujnikom bez samodzielnego taktowania
+uint8_t TCS34725_NeedsTimer(void) {
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (!uses_interrupt(i)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Konfiguracja zrodla wyzwalania: PERS, taktowanie i skasowanie przerwania
+static void apply_source_config(uint8_t sensor) {
+    TCS34725_WriteReg(sensor, TCS34725_PERS, TCS34725_PERS_EVERY_CYCLE);
+    TCS34725_ApplyPacing(sensor);
+    TCS34725_ClearInterrupt(sensor, NULL);
+}
+
+// Zmiana zrodla wyzwalania; przed zakonczeniem inicjalizacji zrobi to TCS34725_HandleLoop
+void TCS34725_SetSampleSource(TCS_Source_t source) {
+    sample_source = source;
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (is_configured(i)) {
+            apply_source_config(i);
+        }
+    }
+}
+
+static void on_poweron_written(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    (void)xfer;
+    tcs_sensors[sensor].poweron_tick = HAL_GetTick();
+    set_state(sensor, TCS_STATE_POWERUP_WAIT);
+}
+
+static void on_id_read(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+
+    if (xfer->data[0] != TCS34725_EXPECTED_ID) {
+        set_state(sensor, TCS_STATE_ERROR);
         return;
     }
 
-    // Normalny odczyt danych kolorow
+    // Konfiguracja czujnika - zapisy wykonywane jeden po drugim z kolejki
+    set_state(sensor, TCS_STATE_CONFIGURING);
+    TCS34725_SetTime(sensor, s->time_index);
+    TCS34725_SetGain(sensor, s->gain_index);
+    TCS34725_QueueWrite(sensor, TCS34725_ENABLE, TCS34725_ENABLE_PON, on_poweron_written);
+}
+
+static void on_interrupt_cleared(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    (void)xfer;
+    set_state(sensor, TCS_STATE_READY);
+}
+
+// Zmiana nadprobkowania; rozpoczeta probka jest porzucana
+void TCS34725_SetOversample(uint8_t sensor, uint8_t count, uint8_t keep_spread) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+    uint32_t key = xfer_lock();
+    s->oversample = count;
+    s->keep_spread = keep_spread;
+    s->ovs_count = 0;
+    xfer_unlock(key);
+
+    TCS34725_ApplyPacing(sensor);
+}
+
+// Srodek integracji, z ktorej pochodza odczytane dane. W trybie INT koniec integracji
+// wyznacza zbocze linii INT; bez niego faza czujnika jest nieznana i koniec integracji
+// przypada srednio pol cyklu przed odczytem rejestrow (blad do +-ATIME/2).
+static uint64_t integration_midpoint_us(uint8_t sensor) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+    uint32_t atime_us = (uint32_t)ColorCalc_AtimeCycles(s->time_applied)
+                        * TCS34725_WTIME_STEP_01MS * 100;
+    uint64_t end_us;
+
+    if (uses_interrupt(sensor) && s->int_us != 0 && s->int_us <= s->read_start_us) {
+        end_us = s->int_us;
+    } else {
+        end_us = s->read_done_us - atime_us / 2;
+    }
+    return end_us > atime_us / 2 ? end_us - atime_us / 2 : 0;
+}
+
+// Dodanie integracji do probki. Zwraca 1, gdy probka jest kompletna - wtedy
+// *data zawiera srednia, *spread rozrzut kanalu C (lub TCS_SPREAD_NONE),
+// a *timestamp_us srodek przedzialu od pierwszej do ostatniej integracji.
+static uint8_t oversample_add(uint8_t sensor, TCS34725_Data_t *data, uint16_t *spread,
+                              uint64_t *timestamp_us) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+    uint8_t count = oversample_count(sensor);
+
+    if (count == 1) {
+        *spread = TCS_SPREAD_NONE;
+        return 1;
+    }
+
+    if (s->ovs_count == 0) {
+        s->ovs_first_us = *timestamp_us;
+        memset(s->ovs_sum, 0, sizeof(s->ovs_sum));
+        s->ovs_min = 0xFFFF;
+        s->ovs_max = 0;
+        s->ovs_saturated = 0;
+    }
+    s->ovs_sum[0] += data->c;
+    s->ovs_sum[1] += data->r;
+    s->ovs_sum[2] += data->g;
+    s->ovs_sum[3] += data->b;
+    if (data->c < s->ovs_min) s->ovs_min = data->c;
+    if (data->c > s->ovs_max) s->ovs_max = data->c;
+    if (data->c >= ColorCalc_FullScale(s->time_applied)) {
+        s->ovs_saturated = 1;
+    }
+    s->ovs_read_tick = HAL_GetTick();
+
+    if (++s->ovs_count < count) {
+        return 0;
+    }
+    s->ovs_count = 0;
+
+    // Srednia z zaokragleniem; nasycenie ktorejkolwiek integracji pozostaje widoczne
+    data->c = (uint16_t)((s->ovs_sum[0] + count / 2) / count);
+    data->r = (uint16_t)((s->ovs_sum[1] + count / 2) / count);
+    data->g = (uint16_t)((s->ovs_sum[2] + count / 2) / count);
+    data->b = (uint16_t)((s->ovs_sum[3] + count / 2) / count);
+    if (s->ovs_saturated) {
+        data->c = (uint16_t)ColorCalc_FullScale(s->time_applied);
+    }
+    *spread = s->keep_spread ? (uint16_t)(s->ovs_max - s->ovs_min) : TCS_SPREAD_NONE;
+    *timestamp_us = s->ovs_first_us + (*timestamp_us - s->ovs_first_us) / 2;
+    return 1;
+}
+
+static void on_color_read(uint8_t sensor, TCS34725_Xfer_t *xfer) {
+    uint8_t *buf = xfer->data;
     TCS34725_Data_t sensor_data;
-    sensor_data.c = (uint16_t)(dma_buffer[1] << 8) | dma_buffer[0];
-    sensor_data.r = (uint16_t)(dma_buffer[3] << 8) | dma_buffer[2];
-    sensor_data.g = (uint16_t)(dma_buffer[5] << 8) | dma_buffer[4];
-    sensor_data.b = (uint16_t)(dma_buffer[7] << 8) | dma_buffer[6];
+    uint16_t spread;
+    uint64_t timestamp_us;
+
+    tcs_sensors[sensor].read_done_us = Timebase_NowUs();
+    timestamp_us = integration_midpoint_us(sensor);
+
+    sensor_data.c = (uint16_t)(buf[1] << 8) | buf[0];
+    sensor_data.r = (uint16_t)(buf[3] << 8) | buf[2];
+    sensor_data.g = (uint16_t)(buf[5] << 8) | buf[4];
+    sensor_data.b = (uint16_t)(buf[7] << 8) | buf[6];
+
+    if (oversample_add(sensor, &sensor_data, &spread, &timestamp_us)) {
+        ColorBuffer_Put(sensor, &sensor_data, spread, timestamp_us);
+        AutoGain_Process(sensor, &sensor_data);
+    }
+
+    // Tryb INT - skasowanie przerwania, aby czujnik mogl zglosic kolejna integracje
+    if (uses_interrupt(sensor)) {
+        set_state(sensor, TCS_STATE_CLEARING);
+        if (TCS34725_ClearInterrupt(sensor, on_interrupt_cleared) == HAL_OK) {
+            return;
+        }
+    }
+
+    set_state(sensor, TCS_STATE_READY);
+}
+
+
+void TCS34725_InitSensor(uint8_t sensor) {
+    set_state(sensor, TCS_STATE_INIT_READ_ID);
+    if (TCS34725_QueueRead(sensor, TCS34725_ID, 1, on_id_read) != HAL_OK) {
+        set_state(sensor, TCS_STATE_ERROR);
+    }
+}
+
+void TCS34725_Init(void) {
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TCS34725_InitSensor(i);
+    }
+}
+
+// Przerwanie DMA, odblokowanie magistrali i ponowna konfiguracja jej czujnikow
+static void TCS34725_Recover(TCS34725_Bus_t *bus) {
+    bus->ops->abort(bus->ctx);
+
+    xfer_flush(bus);
+    bus->ops->recover(bus->ctx);
+
+    tcs_recovery_count++;
+    bus->recovery_tick = HAL_GetTick();
+
+    // Pelna inicjalizacja odtwarza GAIN, ATIME i zrodlo wyzwalania
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (bus_of(i) == bus) {
+            TCS34725_InitSensor(i);
+        }
+    }
+}
+
+// Czas do zadanego odstepu od tick lub 0, gdy minal
+static uint32_t ms_left(uint32_t tick, uint32_t interval_ms) {
+    uint32_t elapsed = HAL_GetTick() - tick;
+    return elapsed >= interval_ms ? 0 : interval_ms - elapsed;
+}
+
+static void wake_min(uint32_t *wake_ms, uint32_t ms) {
+    if (*wake_ms == 0 || ms < *wake_ms) {
+        *wake_ms = ms;
+    }
+}
+
+// Glowna petla obslugi czujnikow - odliczanie rozruchu i ponowienie startu kolejek.
+// Zadanie harmonogramu (SCHED_EVT_SENSOR): oczekiwanie na odstep czasu zamawia
+// ponowne uruchomienie zamiast odpytywania w kazdej petli.
+void TCS34725_HandleLoop(void) {
+    PROF_BEGIN(PROF_SITE_SENSOR_LOOP);
+    uint32_t wake_ms = 0;
 
-    ColorBuffer_Put(&sensor_data, HAL_GetTick());
-    sensor_state = TCS_STATE_READY;
+    //Odblokowanie magistrali po bledzie zgloszonym przez TCS34725_BusError
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        TCS34725_Bus_t *bus = &tcs_buses[b];
+        if (bus->error) {
+            uint32_t left = tcs_recovery_count == 0 ? 0
+                            : ms_left(bus->recovery_tick, TCS_RECOVERY_BACKOFF_MS);
+            if (left == 0) {
+                TCS34725_Recover(bus);
+            } else {
+                wake_min(&wake_ms, left);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TCS34725_Sensor_t *s = &tcs_sensors[i];
+
+        //Czekanie 3ms na rozruch oscylatora
+        if (s->state == TCS_STATE_POWERUP_WAIT) {
+            uint32_t left = ms_left(s->poweron_tick, 3);
+            if (left == 0) {
+                set_state(i, TCS_STATE_READY);
+                apply_source_config(i);
+            } else {
+                wake_min(&wake_ms, left);
+            }
+        }
+        //Zbocze INT zgubione w trakcie zajetosci magistrali - linia nadal w stanie niskim
+        else if (s->state == TCS_STATE_READY && uses_interrupt(i) && sampling_active) {
+            if (HAL_GPIO_ReadPin(s->int_port, s->int_pin) == GPIO_PIN_RESET) {
+                s->int_us = 0;
+                TCS34725_Start_DMA_Read(i);
+            }
+        }
+        //Nadprobkowanie z timera - kolejny odczyt po zakonczeniu nastepnej integracji
+        else if (s->state == TCS_STATE_READY && !uses_interrupt(i) && s->ovs_count > 0
+                && sampling_active) {
+            uint32_t left = ms_left(s->ovs_read_tick, TCS34725_GetIntegrationTimeMs(s->time_index));
+            if (left == 0) {
+                TCS34725_Start_DMA_Read(i);
+            } else {
+                wake_min(&wake_ms, left);
+            }
+        }
+    }
+
+    // Transakcja odrzucona przez HAL (HAL_BUSY) czeka w kolejce
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        if (!tcs_buses[b].active && tcs_buses[b].count > 0) {
+            xfer_kick(&tcs_buses[b]);
+        }
+    }
+
+    if (wake_ms) {
+        Sched_SignalAfter(SCHED_EVT_SENSOR, wake_ms);
+    }
+    PROF_END(PROF_SITE_SENSOR_LOOP);
+}
+
+// Wywolywane z przerwania timera po uplywie timer_interval.
+// Odczyty wszystkich czujnikow trafiaja do kolejek ich magistral i sa
+// wykonywane jeden za drugim, a rozne magistrale pracuja rownolegle.
+// Przy nadprobkowaniu tick rozpoczyna nowa probke, a kolejne integracje
+// odczytuje TCS34725_HandleLoop.
+void TCS34725_OnTimerTick(void) {
+    Trace_Event(TRC_TIMER_TICK, 0, 0);
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (!uses_interrupt(i)) {
+            if (tcs_sensors[i].state == TCS_STATE_READY) {
+                tcs_sensors[i].ovs_count = 0;
+            }
+            TCS34725_Start_DMA_Read(i);
+        }
+    }
+    Sched_Signal(SCHED_EVT_SENSOR);
+}
+
+// Wywolywane z przerwania EXTI - czujnik zakonczyl integracje
+void TCS34725_OnInterrupt(uint16_t pin) {
+    if (!sampling_active) {
+        return;
+    }
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (uses_interrupt(i) && tcs_sensors[i].int_pin == pin) {
+            if (tcs_sensors[i].state == TCS_STATE_READY) {
+                tcs_sensors[i].int_us = Timebase_NowUs();
+            }
+            TCS34725_Start_DMA_Read(i);
+        }
+    }
+    Sched_Signal(SCHED_EVT_SENSOR);
+}
+
+// Rozpoczecie odczytu danych kolorow przez DMA
+void TCS34725_Start_DMA_Read(uint8_t sensor) {
+    TCS34725_Sensor_t *s = &tcs_sensors[sensor];
+
+    if (s->state != TCS_STATE_READY) {
+        Counter_Inc(CNT_SAMPLES_SKIPPED);
+        return;
+    }
+
+    set_state(sensor, TCS_STATE_BUSY);
+    s->read_start_us = Timebase_NowUs();
+
+    // Bit auto-inkrementacji - odczyt CDATAL..BDATAH jedna transakcja
+    if (TCS34725_QueueRead(sensor, 0x20 | TCS34725_CDATAL, 8, on_color_read) != HAL_OK) {
+        set_state(sensor, TCS_STATE_READY);
+    }
+}
+
+// Blad transferu (NACK, utrata arbitrazu, blad magistrali, blad DMA)
+void TCS34725_BusError(TCS34725_Bus_t *bus) {
+    // Odblokowanie wymaga bit-bangingu SCL - wykonywane w petli glownej
+    Counter_Inc(CNT_I2C_ERRORS);
+    Trace_Event(TRC_BUS_ERROR, (uint8_t)(bus - tcs_buses), 0);
+    bus->error = 1;
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        if (bus_of(i) == bus) {
+            set_state(i, TCS_STATE_RECOVERY);
+        }
+    }
+    Sched_Signal(SCHED_EVT_SENSOR);
 }
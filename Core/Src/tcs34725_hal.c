@@ -0,0 +1,86 @@
+#include "tcs34725.h"
+#include "i2c.h"
+
+// Operacje magistrali TCS34725 na HAL I2C z DMA oraz konfiguracja stanowiska
+
+
+static HAL_StatusTypeDef hal_mem_read(void *ctx, uint16_t addr, uint8_t reg, uint8_t *data, uint16_t len) {
+    return HAL_I2C_Mem_Read_DMA((I2C_HandleTypeDef *)ctx, addr, reg, I2C_MEMADD_SIZE_8BIT, data, len);
+}
+
+static HAL_StatusTypeDef hal_write(void *ctx, uint16_t addr, uint8_t *data, uint16_t len) {
+    return HAL_I2C_Master_Transmit_DMA((I2C_HandleTypeDef *)ctx, addr, data, len);
+}
+
+static void hal_abort(void *ctx) {
+    I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)ctx;
+    if (hi2c->hdmarx != NULL) {
+        HAL_DMA_Abort(hi2c->hdmarx);
+    }
+    if (hi2c->hdmatx != NULL) {
+        HAL_DMA_Abort(hi2c->hdmatx);
+    }
+}
+
+static void hal_recover_i2c1(void *ctx) {
+    (void)ctx;
+    I2C1_BusRecovery();
+}
+
+static const TCS34725_BusOps_t i2c1_ops = {
+    .mem_read = hal_mem_read,
+    .write = hal_write,
+    .abort = hal_abort,
+    .recover = hal_recover_i2c1,
+};
+
+// Konfiguracja stanowiska - magistrale I2C
+TCS34725_Bus_t tcs_buses[TCS_BUS_COUNT] = {
+    { .ops = &i2c1_ops, .ctx = &hi2c1, .mux_channel = TCS_NO_MUX },
+};
+
+// Konfiguracja stanowiska - czujniki (magistrala, kanal multipleksera, linia INT)
+TCS34725_Sensor_t tcs_sensors[TCS_SENSOR_COUNT] = {
+    { .bus = 0, .mux_channel = TCS_NO_MUX, .int_port = TCS_INT_GPIO_Port, .int_pin = TCS_INT_Pin,
+      .gain_index = TCS_DEFAULT_GAIN_INDEX, .time_index = TCS_DEFAULT_TIME_INDEX,
+      .gain_applied = TCS_DEFAULT_GAIN_INDEX, .time_applied = TCS_DEFAULT_TIME_INDEX,
+      .oversample = 1 },
+};
+
+
+static TCS34725_Bus_t* bus_from_handle(I2C_HandleTypeDef *hi2c) {
+    for (uint8_t i = 0; i < TCS_BUS_COUNT; i++) {
+        I2C_HandleTypeDef *bus_hi2c = (I2C_HandleTypeDef *)tcs_buses[i].ctx;
+        if (bus_hi2c != NULL && bus_hi2c->Instance == hi2c->Instance) {
+            return &tcs_buses[i];
+        }
+    }
+    return NULL;
+}
+
+// Callback po zakonczeniu odczytu DMA
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    TCS34725_Bus_t *bus = bus_from_handle(hi2c);
+    if (bus == NULL) {
+        return;
+    }
+    TCS34725_BusComplete(bus);
+}
+
+// Callback po zakonczeniu zapisu DMA
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    TCS34725_Bus_t *bus = bus_from_handle(hi2c);
+    if (bus == NULL) {
+        return;
+    }
+    TCS34725_BusComplete(bus);
+}
+
+// Callback bledu (NACK, utrata arbitrazu, blad magistrali, blad DMA)
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    TCS34725_Bus_t *bus = bus_from_handle(hi2c);
+    if (bus == NULL) {
+        return;
+    }
+    TCS34725_BusError(bus);
+}
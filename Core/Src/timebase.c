@@ -0,0 +1,37 @@
+#include "main.h"
+#include "tim.h"
+#include "timebase.h"
+
+// Starsze 32 bity czasu - liczba przepelnien TIM5 (co ~71.6 min)
+static volatile uint32_t overflow_count = 0;
+
+
+void Timebase_Init(void) {
+    overflow_count = 0;
+    __HAL_TIM_SET_COUNTER(&htim5, 0);
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+    HAL_TIM_Base_Start_IT(&htim5);
+}
+
+// Wywolywane z HAL_TIM_PeriodElapsedCallback dla TIM5
+void Timebase_OnOverflow(void) {
+    overflow_count++;
+}
+
+// Odczyt bez blokowania przerwan (TIM5 ma najwyzszy priorytet): obsluga przepelnienia
+// w trakcie odczytu zmienia overflow_count i odczyt jest powtarzany. Przepelnienie
+// zgloszone, ale jeszcze nieobsluzone (UIF ustawione) jest doliczane, gdy licznik juz zawinal.
+uint64_t Timebase_NowUs(void) {
+    uint32_t high, low, sr;
+
+    do {
+        high = overflow_count;
+        low = htim5.Instance->CNT;
+        sr = htim5.Instance->SR;
+    } while (high != overflow_count);
+
+    if ((sr & TIM_SR_UIF) && low < 0x80000000U) {
+        high++;
+    }
+    return ((uint64_t)high << 32) | low;
+}
@@ -0,0 +1,124 @@
+#include "main.h"
+#include "timesync.h"
+#include "timebase.h"
+#include "rtc_clock.h"
+
+// Odwzorowanie czasu lokalnego (Timebase_NowUs) na czas hosta w us od 1970-01-01 UTC:
+// epoch = base_epoch + dt + dt * drift / 1e9, gdzie dt = local - base_local
+static uint64_t base_local_us = 0;
+static uint64_t base_epoch_us = 0;
+static int32_t drift_ppb = 0;
+static TimeSync_Source_t source = TIMESYNC_NONE;
+
+// Niedokonczona wymiana: T1 hosta oraz lokalne T2 (odbior) i T3 (nadanie odpowiedzi).
+// T4 (odbior odpowiedzi przez hosta) przychodzi w nastepnej komendzie TIMESYNC.
+static uint64_t pending_t1_us = 0;
+static uint64_t pending_t2_local = 0;
+static uint64_t pending_t3_local = 0;
+static uint8_t pending = 0;
+
+static uint64_t last_sync_local = 0;   // Ostatnia korekta - poczatek pomiaru dryfu
+static int64_t last_offset_us = 0;
+static uint32_t last_delay_us = 0;
+
+
+// Czas sprzed resetu z RTC; dryf TIM5 z rejestru zapasowego (ten sam oscylator)
+void TimeSync_Init(void) {
+    uint64_t epoch_us;
+
+    if (RtcClock_Init() && RtcClock_Read(&epoch_us)) {
+        base_local_us = Timebase_NowUs();
+        base_epoch_us = epoch_us;
+        drift_ppb = (int32_t)RtcClock_BackupRead(RTC_CLOCK_BKP_DRIFT);
+        if (drift_ppb > TIMESYNC_DRIFT_MAX_PPB || drift_ppb < -TIMESYNC_DRIFT_MAX_PPB) {
+            drift_ppb = 0;
+        }
+        source = TIMESYNC_RTC;
+    }
+}
+
+uint64_t TimeSync_ToEpochUs(uint64_t local_us) {
+    int64_t dt = (int64_t)(local_us - base_local_us);
+    return base_epoch_us + dt + dt * drift_ppb / 1000000000LL;
+}
+
+// Korekta o przesuniecie offset_us (czas urzadzenia - czas hosta) zmierzone w chwili at_local.
+// Reszta przesuniecia od poprzedniej korekty to blad dryfu - korygowany w polowie,
+// aby pojedyncza zaklocona wymiana nie rozstrajala zegara.
+static void apply_offset(int64_t offset_us, uint64_t at_local) {
+    int32_t new_drift = drift_ppb;
+
+    if (source == TIMESYNC_HOST) {
+        uint64_t interval = at_local - last_sync_local;
+        if (interval >= TIMESYNC_DRIFT_MIN_US) {
+            int64_t error_ppb = offset_us * 1000000000LL / (int64_t)interval;
+            int64_t drift = (int64_t)drift_ppb - error_ppb / 2;
+            if (drift > TIMESYNC_DRIFT_MAX_PPB) {
+                drift = TIMESYNC_DRIFT_MAX_PPB;
+            } else if (drift < -TIMESYNC_DRIFT_MAX_PPB) {
+                drift = -TIMESYNC_DRIFT_MAX_PPB;
+            }
+            new_drift = (int32_t)drift;
+        }
+    }
+
+    base_epoch_us = TimeSync_ToEpochUs(at_local) - offset_us;
+    base_local_us = at_local;
+    drift_ppb = new_drift;
+    last_sync_local = at_local;
+    source = TIMESYNC_HOST;
+
+    RtcClock_Write(TimeSync_ToEpochUs(Timebase_NowUs()));
+    RtcClock_BackupWrite(RTC_CLOCK_BKP_DRIFT, (uint32_t)drift_ppb);
+}
+
+// Wymiana w stylu NTP. Komenda niesie T1 biezacej wymiany i T4 poprzedniej - wtedy
+// poprzednia wymiana jest kompletna: przesuniecie ((T2-T1)+(T3-T4))/2, opoznienie
+// (T4-T1)-(T3-T2). T1 = 0 tylko odczytuje stan. Zwraca 1, gdy zegar zostal skorygowany.
+uint8_t TimeSync_Exchange(uint64_t t1_us, uint64_t t4_us, uint64_t rx_local_us) {
+    uint8_t applied = 0;
+
+    if (pending && t4_us != 0 && t4_us >= pending_t1_us) {
+        int64_t t1 = (int64_t)pending_t1_us;
+        int64_t t2 = (int64_t)TimeSync_ToEpochUs(pending_t2_local);
+        int64_t t3 = (int64_t)TimeSync_ToEpochUs(pending_t3_local);
+        int64_t t4 = (int64_t)t4_us;
+        int64_t delay = (t4 - t1) - (t3 - t2);
+
+        if (delay >= 0 && delay <= TIMESYNC_MAX_DELAY_US) {
+            last_offset_us = ((t2 - t1) + (t3 - t4)) / 2;
+            last_delay_us = (uint32_t)delay;
+            apply_offset(last_offset_us, pending_t3_local);
+            applied = 1;
+        }
+    }
+
+    pending = 0;
+    pending_t1_us = t1_us;
+    pending_t2_local = rx_local_us;
+    return applied;
+}
+
+// Chwila przekazania odpowiedzi TIMESYNC do UART (T3)
+void TimeSync_SetTransmitTime(uint64_t tx_local_us) {
+    if (pending_t1_us != 0) {
+        pending_t3_local = tx_local_us;
+        pending = 1;
+    }
+}
+
+TimeSync_Source_t TimeSync_GetSource(void) {
+    return source;
+}
+
+int64_t TimeSync_GetLastOffsetUs(void) {
+    return last_offset_us;
+}
+
+uint32_t TimeSync_GetLastDelayUs(void) {
+    return last_delay_us;
+}
+
+int32_t TimeSync_GetDriftPpb(void) {
+    return drift_ppb;
+}
@@ -0,0 +1,49 @@
+#include "trace.h"
+
+TraceEntry_t trace_ring[TRACE_LEN];
+volatile uint32_t trace_head = 0;
+volatile uint8_t trace_enabled = 1;
+
+
+// Zatrzymanie zapisu pozwala odczytac zamrozony przebieg bez zdarzen samego odczytu
+void Trace_Enable(uint8_t enable) {
+    trace_enabled = enable ? 1 : 0;
+}
+
+// Czytane z petli glownej. Przerwanie, ktore zarezerwowalo wpis, zawsze konczy zapis
+// przed powrotem do watku, wiec niepelne wpisy zdarzaja sie tylko przy nadpisaniu
+// w trakcie kopiowania - takie sa odrzucane po ponownym odczycie trace_head.
+uint8_t Trace_Read(uint32_t *seq, TraceEntry_t *entries, uint8_t max) {
+    uint32_t head = trace_head;
+    uint32_t first = *seq;
+
+    if (head - first > head) {
+        // Numer z przyszlosci (np. po restarcie urzadzenia) - od najstarszego
+        first = head > TRACE_LEN ? head - TRACE_LEN : 0;
+    }
+    if (head - first > TRACE_LEN) {
+        first = head - TRACE_LEN;
+    }
+
+    uint8_t count = 0;
+    while (count < max && first + count != head) {
+        entries[count] = trace_ring[(first + count) & (TRACE_LEN - 1)];
+        count++;
+    }
+
+    // Wpisy nadpisane w trakcie kopiowania
+    uint32_t now = trace_head;
+    uint32_t oldest = now - TRACE_LEN;
+    uint8_t skip = 0;
+    if (now > TRACE_LEN) {
+        while (skip < count && (int32_t) (first + skip - oldest) < 0) {
+            skip++;
+        }
+    }
+    for (uint8_t i = skip; i < count; i++) {
+        entries[i - skip] = entries[i];
+    }
+
+    *seq = first + skip;
+    return count - skip;
+}
@@ -5,54 +5,99 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Core/Src/auto_gain.c \
 ../Core/Src/circular_buffer.c \
+../Core/Src/clock_profile.c \
+../Core/Src/color_calc.c \
+../Core/Src/color_stats.c \
+../Core/Src/color_trigger.c \
+../Core/Src/counters.c \
 ../Core/Src/crc16.c \
 ../Core/Src/dma.c \
 ../Core/Src/gpio.c \
 ../Core/Src/i2c.c \
+../Core/Src/irq_prio.c \
 ../Core/Src/main.c \
+../Core/Src/power.c \
+../Core/Src/profile.c \
 ../Core/Src/protocol.c \
+../Core/Src/rtc_clock.c \
+../Core/Src/scheduler.c \
 ../Core/Src/stm32f4xx_hal_msp.c \
 ../Core/Src/stm32f4xx_it.c \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
 ../Core/Src/system_stm32f4xx.c \
 ../Core/Src/tcs34725.c \
+../Core/Src/tcs34725_hal.c \
 ../Core/Src/tim.c \
+../Core/Src/timebase.c \
+../Core/Src/timesync.c \
+../Core/Src/trace.c \
 ../Core/Src/usart.c 
 
 OBJS += \
+./Core/Src/auto_gain.o \
 ./Core/Src/circular_buffer.o \
+./Core/Src/clock_profile.o \
+./Core/Src/color_calc.o \
+./Core/Src/color_stats.o \
+./Core/Src/color_trigger.o \
+./Core/Src/counters.o \
 ./Core/Src/crc16.o \
 ./Core/Src/dma.o \
 ./Core/Src/gpio.o \
 ./Core/Src/i2c.o \
+./Core/Src/irq_prio.o \
 ./Core/Src/main.o \
+./Core/Src/power.o \
+./Core/Src/profile.o \
 ./Core/Src/protocol.o \
+./Core/Src/rtc_clock.o \
+./Core/Src/scheduler.o \
 ./Core/Src/stm32f4xx_hal_msp.o \
 ./Core/Src/stm32f4xx_it.o \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
 ./Core/Src/system_stm32f4xx.o \
 ./Core/Src/tcs34725.o \
+./Core/Src/tcs34725_hal.o \
 ./Core/Src/tim.o \
+./Core/Src/timebase.o \
+./Core/Src/timesync.o \
+./Core/Src/trace.o \
 ./Core/Src/usart.o 
 
 C_DEPS += \
+./Core/Src/auto_gain.d \
 ./Core/Src/circular_buffer.d \
+./Core/Src/clock_profile.d \
+./Core/Src/color_calc.d \
+./Core/Src/color_stats.d \
+./Core/Src/color_trigger.d \
+./Core/Src/counters.d \
 ./Core/Src/crc16.d \
 ./Core/Src/dma.d \
 ./Core/Src/gpio.d \
 ./Core/Src/i2c.d \
+./Core/Src/irq_prio.d \
 ./Core/Src/main.d \
+./Core/Src/power.d \
+./Core/Src/profile.d \
 ./Core/Src/protocol.d \
+./Core/Src/rtc_clock.d \
+./Core/Src/scheduler.d \
 ./Core/Src/stm32f4xx_hal_msp.d \
 ./Core/Src/stm32f4xx_it.d \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
 ./Core/Src/system_stm32f4xx.d \
 ./Core/Src/tcs34725.d \
+./Core/Src/tcs34725_hal.d \
 ./Core/Src/tim.d \
+./Core/Src/timebase.d \
+./Core/Src/timesync.d \
+./Core/Src/trace.d \
 ./Core/Src/usart.d 
 
 
@@ -63,7 +108,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/circular_buffer.cyclo ./Core/Src/circular_buffer.d ./Core/Src/circular_buffer.o ./Core/Src/circular_buffer.su ./Core/Src/crc16.cyclo ./Core/Src/crc16.d ./Core/Src/crc16.o ./Core/Src/crc16.su ./Core/Src/dma.cyclo ./Core/Src/dma.d ./Core/Src/dma.o ./Core/Src/dma.su ./Core/Src/gpio.cyclo ./Core/Src/gpio.d ./Core/Src/gpio.o ./Core/Src/gpio.su ./Core/Src/i2c.cyclo ./Core/Src/i2c.d ./Core/Src/i2c.o ./Core/Src/i2c.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/protocol.cyclo ./Core/Src/protocol.d ./Core/Src/protocol.o ./Core/Src/protocol.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su ./Core/Src/tcs34725.cyclo ./Core/Src/tcs34725.d ./Core/Src/tcs34725.o ./Core/Src/tcs34725.su ./Core/Src/tim.cyclo ./Core/Src/tim.d ./Core/Src/tim.o ./Core/Src/tim.su ./Core/Src/usart.cyclo ./Core/Src/usart.d ./Core/Src/usart.o ./Core/Src/usart.su
+	-$(RM) ./Core/Src/auto_gain.cyclo ./Core/Src/auto_gain.d ./Core/Src/auto_gain.o ./Core/Src/auto_gain.su ./Core/Src/circular_buffer.cyclo ./Core/Src/circular_buffer.d ./Core/Src/circular_buffer.o ./Core/Src/circular_buffer.su ./Core/Src/clock_profile.cyclo ./Core/Src/clock_profile.d ./Core/Src/clock_profile.o ./Core/Src/clock_profile.su ./Core/Src/color_calc.cyclo ./Core/Src/color_calc.d ./Core/Src/color_calc.o ./Core/Src/color_calc.su ./Core/Src/color_stats.cyclo ./Core/Src/color_stats.d ./Core/Src/color_stats.o ./Core/Src/color_stats.su ./Core/Src/color_trigger.cyclo ./Core/Src/color_trigger.d ./Core/Src/color_trigger.o ./Core/Src/color_trigger.su ./Core/Src/counters.cyclo ./Core/Src/counters.d ./Core/Src/counters.o ./Core/Src/counters.su ./Core/Src/crc16.cyclo ./Core/Src/crc16.d ./Core/Src/crc16.o ./Core/Src/crc16.su ./Core/Src/dma.cyclo ./Core/Src/dma.d ./Core/Src/dma.o ./Core/Src/dma.su ./Core/Src/gpio.cyclo ./Core/Src/gpio.d ./Core/Src/gpio.o ./Core/Src/gpio.su ./Core/Src/i2c.cyclo ./Core/Src/i2c.d ./Core/Src/i2c.o ./Core/Src/i2c.su ./Core/Src/irq_prio.cyclo ./Core/Src/irq_prio.d ./Core/Src/irq_prio.o ./Core/Src/irq_prio.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/power.cyclo ./Core/Src/power.d ./Core/Src/power.o ./Core/Src/power.su ./Core/Src/profile.cyclo ./Core/Src/profile.d ./Core/Src/profile.o ./Core/Src/profile.su ./Core/Src/protocol.cyclo ./Core/Src/protocol.d ./Core/Src/protocol.o ./Core/Src/protocol.su ./Core/Src/rtc_clock.cyclo ./Core/Src/rtc_clock.d ./Core/Src/rtc_clock.o ./Core/Src/rtc_clock.su ./Core/Src/scheduler.cyclo ./Core/Src/scheduler.d ./Core/Src/scheduler.o ./Core/Src/scheduler.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su ./Core/Src/tcs34725.cyclo ./Core/Src/tcs34725.d ./Core/Src/tcs34725.o ./Core/Src/tcs34725.su ./Core/Src/tcs34725_hal.cyclo ./Core/Src/tcs34725_hal.d ./Core/Src/tcs34725_hal.o ./Core/Src/tcs34725_hal.su ./Core/Src/tim.cyclo ./Core/Src/tim.d ./Core/Src/tim.o ./Core/Src/tim.su ./Core/Src/timebase.cyclo ./Core/Src/timebase.d ./Core/Src/timebase.o ./Core/Src/timebase.su ./Core/Src/timesync.cyclo ./Core/Src/timesync.d ./Core/Src/timesync.o ./Core/Src/timesync.su ./Core/Src/trace.cyclo ./Core/Src/trace.d ./Core/Src/trace.o ./Core/Src/trace.su ./Core/Src/usart.cyclo ./Core/Src/usart.d ./Core/Src/usart.o ./Core/Src/usart.su
 
 .PHONY: clean-Core-2f-Src
 
@@ -0,0 +1,295 @@
+#include "tcs_client.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+namespace tcs {
+
+Client::Client(int fd, ClientOptions options) : fd_(fd), options_(std::move(options)) {
+    if (options_.max_in_flight == 0) {
+        options_.max_in_flight = 1;
+    }
+    // Identyfikator 0 zostaje dla niezamowionych ramek EVT
+    if (options_.max_in_flight > kFrameIdCount - 1) {
+        options_.max_in_flight = kFrameIdCount - 1;
+    }
+}
+
+void Client::request(const std::string &payload, ReplyHandler handler, bool retryable) {
+    Request req;
+    req.payload = payload;
+    req.handler = std::move(handler);
+    req.retryable = retryable;
+    queue_.push_back(std::move(req));
+}
+
+Reply Client::call(const std::string &payload, bool retryable) {
+    Reply result;
+    bool done = false;
+    request(payload, [&](const Reply &reply) {
+        result = reply;
+        done = true;
+    }, retryable);
+    while (!done && poll(50)) {
+    }
+    return result;
+}
+
+void Client::run_until_idle() {
+    while (poll(50)) {
+    }
+}
+
+// Kolejny wolny identyfikator 1-99 po ostatnio uzytym - spozniona odpowiedz na
+// zakonczone zapytanie trafi na nowe dopiero po pelnym obiegu numerow
+int Client::next_id() {
+    for (int i = 1; i < kFrameIdCount; i++) {
+        int id = (last_id_ + i) % kFrameIdCount;
+        if (id != 0 && in_flight_.find(static_cast<uint8_t>(id)) == in_flight_.end()) {
+            last_id_ = static_cast<uint8_t>(id);
+            return id;
+        }
+    }
+    return -1;
+}
+
+void Client::send_queued() {
+    while (!closed_ && !queue_.empty() && in_flight_.size() < options_.max_in_flight) {
+        // Dlugosc ramki nie zalezy od identyfikatora - numer jest przydzielany dopiero,
+        // gdy ramka miesci sie w oknie
+        Request &front = queue_.front();
+        front.frame = encode_frame(options_.address, options_.device, 0, front.payload);
+        if (front.frame.empty()) {
+            Request req = std::move(front);
+            queue_.pop_front();
+            Reply reply;
+            reply.status = Status::DeviceError;
+            reply.error = WRLEN;
+            if (req.handler) {
+                req.handler(reply);
+            }
+            continue;
+        }
+        if (!in_flight_.empty() && in_flight_bytes_ + front.frame.size() > options_.max_in_flight_bytes) {
+            return;
+        }
+        int id = next_id();
+        if (id < 0) {
+            return;
+        }
+        front.frame = encode_frame(options_.address, options_.device, static_cast<uint8_t>(id),
+                                   front.payload);
+
+        Request &req = in_flight_[static_cast<uint8_t>(id)] = std::move(front);
+        queue_.pop_front();
+        in_flight_bytes_ += req.frame.size();
+        req.first_sent = Clock::now();
+        transmit(req);
+    }
+}
+
+bool Client::transmit(Request &req) {
+    const std::string *frame = &req.frame;
+    std::string filtered;
+    if (transmit_filter_) {
+        filtered = req.frame;
+        transmit_filter_(filtered, req.attempts);
+        frame = &filtered;
+    }
+
+    size_t done = 0;
+    while (done < frame->size()) {
+        ssize_t n = ::write(fd_, frame->data() + done, frame->size() - done);
+        if (n > 0) {
+            done += static_cast<size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            struct pollfd pfd = { fd_, POLLOUT, 0 };
+            ::poll(&pfd, 1, options_.timeout_ms);
+        } else {
+            closed_ = true;
+            return false;
+        }
+    }
+    req.attempts++;
+    req.deadline = Clock::now() + std::chrono::milliseconds(options_.timeout_ms);
+    stats_.sent++;
+    return true;
+}
+
+bool Client::poll(int max_wait_ms) {
+    send_queued();
+    if (closed_) {
+        fail_all(Status::Closed);
+        return false;
+    }
+    if (pending() == 0) {
+        return false;
+    }
+
+    int wait_ms = max_wait_ms;
+    Clock::time_point now = Clock::now();
+    for (const auto &entry : in_flight_) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(entry.second.deadline - now);
+        int left_ms = left.count() < 0 ? 0 : static_cast<int>(left.count()) + 1;
+        if (left_ms < wait_ms) {
+            wait_ms = left_ms;
+        }
+    }
+
+    struct pollfd pfd = { fd_, POLLIN, 0 };
+    int ready = ::poll(&pfd, 1, wait_ms);
+    if (ready > 0 && (pfd.revents & (POLLIN | POLLHUP | POLLERR))) {
+        char buf[512];
+        ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n > 0) {
+            reader_.feed(buf, static_cast<size_t>(n),
+                         [this](const Frame &frame) { handle_frame(frame); },
+                         [this](const std::string &) { stats_.bad_frames++; });
+        } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            closed_ = true;
+        }
+    }
+
+    check_deadlines();
+    send_queued();
+    if (closed_) {
+        fail_all(Status::Closed);
+        return false;
+    }
+    return pending() > 0;
+}
+
+void Client::handle_frame(const Frame &frame) {
+    if (frame.receiver != options_.address || frame.sender != options_.device) {
+        return;
+    }
+    auto it = in_flight_.find(frame.id);
+    if (it == in_flight_.end()) {
+        ErrorCode code;
+        if (frame.id == 0 && error_code_of(frame.data, code)) {
+            stats_.device_errors++;
+            if (error_handler_) {
+                error_handler_(code, frame);
+            }
+        } else if (frame.id == 0) {
+            stats_.events++;
+            if (event_handler_) {
+                event_handler_(frame);
+            }
+        } else {
+            stats_.unmatched++;
+        }
+        return;
+    }
+
+    stats_.replies++;
+    Reply reply;
+    ErrorCode code;
+    if (error_code_of(frame.data, code)) {
+        // Urzadzenie odrzucilo znieksztalcona ramke - komenda nie zostala wykonana
+        if (code == WRCHSUM && it->second.attempts <= options_.max_retries) {
+            stats_.retransmits++;
+            transmit(it->second);
+            return;
+        }
+        reply.status = Status::DeviceError;
+        reply.error = code;
+    } else {
+        reply.status = Status::Ok;
+    }
+    reply.data = frame.data;
+    complete(frame.id, std::move(reply));
+}
+
+void Client::check_deadlines() {
+    Clock::time_point now = Clock::now();
+    std::vector<uint8_t> expired;
+    for (auto &entry : in_flight_) {
+        if (entry.second.deadline <= now) {
+            expired.push_back(entry.first);
+        }
+    }
+    for (uint8_t id : expired) {
+        Request &req = in_flight_[id];
+        if (req.retryable && req.attempts <= options_.max_retries) {
+            stats_.retransmits++;
+            transmit(req);
+        } else {
+            stats_.timeouts++;
+            Reply reply;
+            reply.status = Status::Timeout;
+            complete(id, std::move(reply));
+        }
+    }
+}
+
+void Client::complete(uint8_t id, Reply reply) {
+    auto it = in_flight_.find(id);
+    Request req = std::move(it->second);
+    in_flight_.erase(it);
+    in_flight_bytes_ -= req.frame.size();
+
+    reply.attempts = req.attempts;
+    reply.latency_us = std::chrono::duration<double, std::micro>(Clock::now() - req.first_sent).count();
+    // Handler moze dodac kolejne zapytania - wpis jest juz usuniety
+    if (req.handler) {
+        req.handler(reply);
+    }
+}
+
+void Client::fail_all(Status status) {
+    while (!in_flight_.empty()) {
+        Reply reply;
+        reply.status = status;
+        complete(in_flight_.begin()->first, std::move(reply));
+    }
+    // Zapytania dodane przez handlery zostaja na nastepne wywolanie
+    std::deque<Request> queued;
+    queued.swap(queue_);
+    while (!queued.empty()) {
+        Request req = std::move(queued.front());
+        queued.pop_front();
+        Reply reply;
+        reply.status = status;
+        if (req.handler) {
+            req.handler(reply);
+        }
+    }
+}
+
+int open_serial(const char *path, unsigned baud) {
+    speed_t speed;
+    switch (baud) {
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    case 230400: speed = B230400; break;
+    case 460800: speed = B460800; break;
+    case 921600: speed = B921600; break;
+    default: return -1;
+    }
+
+    int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+    }
+    return fd;
+}
+
+}  // namespace tcs
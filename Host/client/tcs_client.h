@@ -0,0 +1,132 @@
+#ifndef TCS_CLIENT_H
+#define TCS_CLIENT_H
+
+// Klient protokolu po stronie PC: wiele zapytan w locie rozrozniane po frame_id,
+// przekroczenia czasu i retransmisje. Jednowatkowy - cala obsluga (wysylanie z kolejki,
+// odbior, terminy) dzieje sie w poll(), a wyniki trafiaja do funkcji zwrotnych.
+
+#include "tcs_frame.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace tcs {
+
+enum class Status {
+    Ok,             // Odpowiedz z danymi lub OK
+    DeviceError,    // Urzadzenie odpowiedzialo kodem bledu (Reply::error)
+    Timeout,        // Brak odpowiedzi po wszystkich probach
+    Closed,         // Port zamkniety lub blad odczytu/zapisu
+};
+
+struct Reply {
+    Status status = Status::Timeout;
+    ErrorCode error = WRCHSUM;      // Wazne tylko dla Status::DeviceError
+    std::string data;               // Zdekodowane dane odpowiedzi
+    uint8_t attempts = 0;           // Liczba wyslanych ramek (1 - bez retransmisji)
+    double latency_us = 0;          // Od pierwszego wyslania do odpowiedzi
+
+    bool ok() const { return status == Status::Ok; }
+};
+
+using ReplyHandler = std::function<void(const Reply &)>;
+using EventHandler = std::function<void(const Frame &)>;
+// Odpowiedz bledu bez frame_id (np. WRFRM na ramke, z ktorej nie dalo sie odczytac numeru)
+using ErrorHandler = std::function<void(ErrorCode code, const Frame &)>;
+// Zmiana ramki tuz przed zapisem do portu; attempt - numer proby od 0
+using TransmitFilter = std::function<void(std::string &frame, uint8_t attempt)>;
+
+struct ClientOptions {
+    std::string address = "PC1";        // Adres hosta (nadawca)
+    std::string device = DEVICE_ID;     // Adres urzadzenia
+    int timeout_ms = 250;               // Na jedna probe
+    int max_retries = 2;                // Retransmisje po przekroczeniu czasu
+    size_t max_in_flight = 8;           // Zapytania bez odpowiedzi
+    // Bajty ramek w locie - bufor odbiorczy firmware (UART_RXBUF_LEN) to 128 B;
+    // pojedyncza dluzsza ramka jest wysylana, gdy nic innego nie czeka
+    size_t max_in_flight_bytes = 128;
+};
+
+struct ClientStats {
+    uint64_t sent = 0;              // Ramki wyslane (z retransmisjami)
+    uint64_t retransmits = 0;
+    uint64_t replies = 0;
+    uint64_t timeouts = 0;
+    uint64_t unmatched = 0;         // Odpowiedzi z nieznanym frame_id (np. spoznione)
+    uint64_t bad_frames = 0;        // Bledne CRC lub format
+    uint64_t events = 0;            // Niezamowione ramki (EVT)
+    uint64_t device_errors = 0;     // Bledy bez frame_id - nie koncza zadnego zapytania
+};
+
+class Client {
+public:
+    explicit Client(int fd, ClientOptions options = ClientOptions());
+
+    // Zapytanie w kolejce; handler wywolywany z poll(). Komendy niebezpieczne do
+    // powtorzenia (TIMESYNC, PROFILE z zerowaniem) przekazuja retryable = false -
+    // sa wtedy powtarzane tylko po WRCHSUM, gdy urzadzenie odrzucilo ramke.
+    void request(const std::string &payload, ReplyHandler handler, bool retryable = true);
+    // Blokujace - obsluguje tez inne zapytania w locie
+    Reply call(const std::string &payload, bool retryable = true);
+
+    void on_event(EventHandler handler) { event_handler_ = std::move(handler); }
+    // Zapytanie, ktorego dotyczy blad, konczy sie przekroczeniem czasu lub retransmisja
+    void on_error(ErrorHandler handler) { error_handler_ = std::move(handler); }
+    // Testy odpornosci: wstrzykiwanie bledow CRC, uciete ramki itp.
+    void on_transmit(TransmitFilter filter) { transmit_filter_ = std::move(filter); }
+
+    // Jedna runda: wysylanie, oczekiwanie na dane do max_wait_ms, terminy.
+    // Zwraca false, gdy nie ma nic w kolejce ani w locie.
+    bool poll(int max_wait_ms);
+    void run_until_idle();
+
+    size_t pending() const { return queue_.size() + in_flight_.size(); }
+    const ClientStats &stats() const { return stats_; }
+    const ClientOptions &options() const { return options_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        std::string payload;
+        ReplyHandler handler;
+        bool retryable;
+        std::string frame;
+        uint8_t attempts = 0;
+        Clock::time_point first_sent;
+        Clock::time_point deadline;
+    };
+
+    void send_queued();
+    bool transmit(Request &req);
+    void handle_frame(const Frame &frame);
+    void check_deadlines();
+    void complete(uint8_t id, Reply reply);
+    void fail_all(Status status);
+    int next_id();
+
+    int fd_;
+    ClientOptions options_;
+    FrameReader reader_;
+    std::deque<Request> queue_;
+    std::map<uint8_t, Request> in_flight_;
+    size_t in_flight_bytes_ = 0;
+    uint8_t last_id_ = 0;
+    bool closed_ = false;
+    EventHandler event_handler_;
+    ErrorHandler error_handler_;
+    TransmitFilter transmit_filter_;
+    ClientStats stats_;
+};
+
+// Port szeregowy w trybie surowym 8N1 bez kontroli przeplywu; -1 przy bledzie.
+// Dla pseudo-terminala predkosc jest ignorowana.
+int open_serial(const char *path, unsigned baud);
+
+}  // namespace tcs
+
+#endif
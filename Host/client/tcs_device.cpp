@@ -0,0 +1,553 @@
+#include "tcs_device.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace tcs {
+
+namespace {
+
+// Kolejne pola odpowiedzi o stalej szerokosci
+class Cursor {
+public:
+    explicit Cursor(const std::string &s) : s_(s) {}
+
+    bool done() const { return pos_ == s_.size(); }
+    char peek() const { return pos_ < s_.size() ? s_[pos_] : '\0'; }
+
+    bool lit(const char *text) {
+        size_t len = std::strlen(text);
+        if (s_.compare(pos_, len, text) != 0) {
+            return false;
+        }
+        pos_ += len;
+        return true;
+    }
+
+    bool ch(char &out) {
+        if (pos_ >= s_.size()) {
+            return false;
+        }
+        out = s_[pos_++];
+        return true;
+    }
+
+    template <typename T>
+    bool dec(size_t digits, T &out) {
+        if (pos_ + digits > s_.size()) {
+            return false;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < digits; i++, pos_++) {
+            if (s_[pos_] < '0' || s_[pos_] > '9') {
+                return false;
+            }
+            value = value * 10 + (s_[pos_] - '0');
+        }
+        out = static_cast<T>(value);
+        return true;
+    }
+
+    template <typename T>
+    bool hex(size_t digits, T &out) {
+        if (pos_ + digits > s_.size()) {
+            return false;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < digits; i++, pos_++) {
+            char c = s_[pos_];
+            int d;
+            if (c >= '0' && c <= '9') d = c - '0';
+            else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+            else return false;
+            value = (value << 4) | static_cast<uint64_t>(d);
+        }
+        out = static_cast<T>(value);
+        return true;
+    }
+
+    // Znak +/- i liczba
+    template <typename T>
+    bool signed_dec(size_t digits, T &out) {
+        char sign;
+        uint64_t value;
+        if (!ch(sign) || (sign != '+' && sign != '-') || !dec(digits, value)) {
+            return false;
+        }
+        out = sign == '-' ? -static_cast<T>(value) : static_cast<T>(value);
+        return true;
+    }
+
+private:
+    const std::string &s_;
+    size_t pos_ = 0;
+};
+
+// Sekundy i mikrosekundy osobno: %010lu%06lu
+bool dec_us(Cursor &c, uint64_t &out) {
+    uint64_t s, us;
+    if (!c.dec(10, s) || !c.dec(6, us)) {
+        return false;
+    }
+    out = s * 1000000U + us;
+    return true;
+}
+
+std::string with_sensor(std::string payload, uint8_t sensor) {
+    if (sensor != 0) {
+        payload.push_back(SENSOR_SUFFIX_CHAR);
+        payload.push_back(static_cast<char>('0' + sensor));
+    }
+    return payload;
+}
+
+std::string fmt(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+std::string fmt(const char *format, ...) {
+    char buf[MAX_PAYLOAD_LEN];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return buf;
+}
+
+bool parse_done(const std::string &data, Done &) {
+    return data == RESP_OK;
+}
+
+template <size_t Digits>
+bool parse_prefixed(const std::string &data, const char *prefix, uint32_t &out) {
+    Cursor c(data);
+    return c.lit(prefix) && c.dec(Digits, out) && c.done();
+}
+
+bool parse_interval(const std::string &data, uint32_t &out) {
+    return parse_prefixed<5>(data, INT_PREFIX, out);
+}
+
+bool parse_gain(const std::string &data, uint8_t &out) {
+    uint32_t v;
+    return parse_prefixed<1>(data, GAIN_PREFIX, v) && (out = static_cast<uint8_t>(v), true);
+}
+
+bool parse_time(const std::string &data, uint8_t &out) {
+    uint32_t v;
+    return parse_prefixed<1>(data, TIME_PREFIX, v) && (out = static_cast<uint8_t>(v), true);
+}
+
+bool parse_led(const std::string &data, bool &out) {
+    uint32_t v;
+    return parse_prefixed<1>(data, LED_PREFIX, v) && (out = v != 0, true);
+}
+
+bool parse_window(const std::string &data, uint16_t &out) {
+    uint32_t v;
+    return parse_prefixed<3>(data, WIN_PREFIX, v) && (out = static_cast<uint16_t>(v), true);
+}
+
+bool parse_source(const std::string &data, bool &out) {
+    uint32_t v;
+    return parse_prefixed<1>(data, SRC_PREFIX, v) && (out = v != 0, true);
+}
+
+bool parse_format(const std::string &data, uint8_t &out) {
+    Cursor c(data);
+    return c.lit(FMT_PREFIX) && c.hex(1, out) && c.done();
+}
+
+bool parse_stats(const std::string &data, WindowStats &out) {
+    static const char kChannels[] = { 'R', 'G', 'B', 'C' };
+    Cursor c(data);
+    if (!c.lit(STATS_PREFIX "W") || !c.dec(3, out.window) || !c.lit("N") || !c.dec(3, out.count)) {
+        return false;
+    }
+    for (size_t i = 0; i < out.channels.size(); i++) {
+        ChannelStats &ch = out.channels[i];
+        char name[2] = { kChannels[i], '\0' };
+        if (!c.lit(name) || !c.dec(5, ch.mean) || !c.lit("V") || !c.dec(10, ch.variance)
+                || !c.lit("L") || !c.dec(5, ch.min) || !c.lit("H") || !c.dec(5, ch.max)) {
+            return false;
+        }
+    }
+    return c.done();
+}
+
+bool parse_trigger(const std::string &data, Trigger &out) {
+    Cursor c(data);
+    return c.lit(TRG_PREFIX) && c.dec(1, out.index) && c.ch(out.type) && c.ch(out.channel)
+           && c.dec(5, out.threshold) && c.done();
+}
+
+bool parse_auto(const std::string &data, AutoGain &out) {
+    Cursor c(data);
+    uint8_t enabled;
+    if (!c.lit(AUTO_PREFIX) || !c.dec(1, enabled) || !c.lit("G") || !c.dec(1, out.gain_index)
+            || !c.lit("T") || !c.dec(1, out.time_index) || !c.done()) {
+        return false;
+    }
+    out.enabled = enabled != 0;
+    return true;
+}
+
+bool parse_lux(const std::string &data, Lux &out) {
+    Cursor c(data);
+    uint8_t saturated;
+    if (!c.lit(LUX_PREFIX) || !c.dec(8, out.lux_x100) || !c.lit("K") || !c.dec(5, out.cct)
+            || !c.lit("S") || !c.dec(1, saturated) || !c.done()) {
+        return false;
+    }
+    out.saturated = saturated != 0;
+    return true;
+}
+
+bool parse_sensors(const std::string &data, std::vector<uint8_t> &out) {
+    Cursor c(data);
+    uint8_t count;
+    if (!c.lit(SNS_PREFIX "N") || !c.dec(1, count)) {
+        return false;
+    }
+    out.assign(count, 0);
+    for (uint8_t i = 0; i < count; i++) {
+        if (!c.lit("S") || !c.dec(1, out[i])) {
+            return false;
+        }
+    }
+    return c.done();
+}
+
+bool parse_duty(const std::string &data, Duty &out) {
+    Cursor c(data);
+    return c.lit(DUTY_PREFIX) && c.dec(5, out.duty_x100) && c.lit("W") && c.dec(5, out.wakeups)
+           && c.done();
+}
+
+bool parse_oversample(const std::string &data, Oversample &out) {
+    Cursor c(data);
+    uint8_t spread;
+    if (!c.lit(OVS_PREFIX) || !c.dec(2, out.count) || !c.lit("S") || !c.dec(1, spread) || !c.done()) {
+        return false;
+    }
+    out.keep_spread = spread != 0;
+    return true;
+}
+
+bool parse_time_sync(const std::string &data, TimeSyncState &out) {
+    Cursor c(data);
+    return c.lit(TSY_PREFIX "S") && c.dec(1, out.source) && c.lit("O") && c.signed_dec(9, out.offset_us)
+           && c.lit("D") && c.dec(6, out.delay_us) && c.lit("P") && c.signed_dec(6, out.drift_ppb)
+           && c.done();
+}
+
+bool parse_tasks(const std::string &data, std::vector<TaskStats> &out) {
+    Cursor c(data);
+    uint8_t count;
+    if (!c.lit(TASK_PREFIX "N") || !c.dec(1, count)) {
+        return false;
+    }
+    out.assign(count, TaskStats());
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t index;
+        TaskStats &t = out[i];
+        if (!c.lit("T") || !c.dec(1, index) || index != i || !c.lit("C") || !c.dec(8, t.runs)
+                || !c.lit("L") || !c.dec(6, t.latency_avg_us) || !c.lit("M") || !c.dec(6, t.latency_max_us)
+                || !c.lit("X") || !c.dec(6, t.exec_max_us)) {
+            return false;
+        }
+    }
+    return c.done();
+}
+
+bool parse_irqs(const std::string &data, std::vector<IrqStats> &out) {
+    Cursor c(data);
+    if (!c.lit(IRQ_PREFIX)) {
+        return false;
+    }
+    out.clear();
+    while (!c.done()) {
+        uint8_t index;
+        IrqStats s;
+        if (!c.lit("I") || !c.dec(1, index) || index != out.size() || !c.lit("P") || !c.dec(2, s.prio)
+                || !c.lit("C") || !c.dec(6, s.count) || !c.lit("X") || !c.dec(5, s.exec_max_x10)
+                || !c.lit("L") || !c.dec(5, s.latency_max_x10)) {
+            return false;
+        }
+        out.push_back(s);
+    }
+    return true;
+}
+
+bool parse_profile(const std::string &data, SiteProfile &out) {
+    Cursor c(data);
+    if (!c.lit(PRF_PREFIX "S") || !c.dec(1, out.site) || !c.lit("C") || !c.dec(8, out.count)
+            || !c.lit("N") || !c.dec(8, out.min) || !c.lit("A") || !c.dec(8, out.avg)
+            || !c.lit("X") || !c.dec(8, out.max) || !c.lit("H")) {
+        return false;
+    }
+    for (uint32_t &bin : out.hist) {
+        if (!c.dec(6, bin)) {
+            return false;
+        }
+    }
+    return c.done();
+}
+
+bool parse_counters(const std::string &data, CounterSnapshot &out) {
+    Cursor c(data);
+    if (!c.lit(CNT_PREFIX "U") || !c.dec(10, out.uptime_s)) {
+        return false;
+    }
+    out.values.clear();
+    while (!c.done()) {
+        uint8_t index;
+        uint32_t value;
+        if (!c.lit("C") || !c.dec(2, index) || index != out.values.size() || !c.dec(10, value)) {
+            return false;
+        }
+        out.values.push_back(value);
+    }
+    return true;
+}
+
+bool parse_trace(const std::string &data, TracePage &out) {
+    Cursor c(data);
+    uint8_t count;
+    if (!c.lit(TRC_PREFIX "Q") || !c.dec(10, out.first) || !c.lit("H") || !c.dec(10, out.head)
+            || !c.lit("N") || !c.dec(2, count)) {
+        return false;
+    }
+    out.entries.assign(count, TraceRecord());
+    for (TraceRecord &e : out.entries) {
+        if (!c.hex(8, e.time_us) || !c.hex(2, e.event) || !c.hex(2, e.a8) || !c.hex(4, e.a16)) {
+            return false;
+        }
+    }
+    return c.done();
+}
+
+bool parse_clock(const std::string &data, ClockInfo &out) {
+    Cursor c(data);
+    return c.lit(CLK_PREFIX "P") && c.dec(1, out.profile) && c.lit("B") && c.dec(1, out.boot_profile)
+           && c.lit("F") && c.dec(3, out.mhz) && c.done();
+}
+
+}  // namespace
+
+bool Device::parse_sample(const std::string &data, Sample &out) {
+    Cursor c(data);
+    out = Sample();
+    if (!c.lit(RESP_ANS_PREFIX)) {
+        return false;
+    }
+    while (!c.done()) {
+        char tag;
+        c.ch(tag);
+        bool ok;
+        switch (tag) {
+        case 'R':
+            ok = c.dec(5, out.r) && c.lit("G") && c.dec(5, out.g) && c.lit("B") && c.dec(5, out.b)
+                 && c.lit("C") && c.dec(5, out.c);
+            out.has_raw = ok;
+            break;
+        case 'V':
+            ok = out.has_spread = c.dec(5, out.spread);
+            break;
+        case 'L':
+            ok = out.has_lux = c.dec(8, out.lux_x100);
+            break;
+        case 'K':
+            ok = out.has_cct = c.dec(5, out.cct);
+            break;
+        case 'E':
+            ok = out.has_epoch = dec_us(c, out.epoch_us);
+            break;
+        case 'T':
+            ok = out.has_timestamp = dec_us(c, out.timestamp_us);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void Device::query(const std::string &payload, bool (*parse)(const std::string &, T &),
+                   Callback<T> cb, bool retryable) {
+    client_.request(payload, [parse, cb](const Reply &reply) {
+        Result<T> result;
+        result.status = reply.status;
+        result.error = reply.error;
+        result.attempts = reply.attempts;
+        result.latency_us = reply.latency_us;
+        if (reply.status == Status::Ok) {
+            result.bad_reply = !parse(reply.data, result.value);
+        }
+        if (cb) {
+            cb(result);
+        }
+    }, retryable);
+}
+
+void Device::start(Callback<Done> cb) {
+    query<Done>(CMD_STR_START, parse_done, cb);
+}
+
+void Device::stop(Callback<Done> cb) {
+    query<Done>(CMD_STR_STOP, parse_done, cb);
+}
+
+void Device::set_interval(uint32_t ms, Callback<Done> cb) {
+    query<Done>(fmt(CMD_STR_SETINT "%05u", ms), parse_done, cb);
+}
+
+void Device::get_interval(Callback<uint32_t> cb) {
+    query<uint32_t>(CMD_STR_GETINT, parse_interval, cb);
+}
+
+void Device::set_gain(uint8_t sensor, uint8_t gain_index, Callback<Done> cb) {
+    query<Done>(with_sensor(fmt(CMD_STR_SETGAIN "%u", gain_index), sensor), parse_done, cb);
+}
+
+void Device::get_gain(uint8_t sensor, Callback<uint8_t> cb) {
+    query<uint8_t>(with_sensor(CMD_STR_GETGAIN, sensor), parse_gain, cb);
+}
+
+void Device::set_time(uint8_t sensor, uint8_t time_index, Callback<Done> cb) {
+    query<Done>(with_sensor(fmt(CMD_STR_SETTIME "%u", time_index), sensor), parse_done, cb);
+}
+
+void Device::get_time(uint8_t sensor, Callback<uint8_t> cb) {
+    query<uint8_t>(with_sensor(CMD_STR_GETTIME, sensor), parse_time, cb);
+}
+
+void Device::set_led(bool on, Callback<Done> cb) {
+    query<Done>(on ? CMD_STR_SETLED "1" : CMD_STR_SETLED "0", parse_done, cb);
+}
+
+void Device::get_led(Callback<bool> cb) {
+    query<bool>(CMD_STR_GETLED, parse_led, cb);
+}
+
+void Device::read_raw(uint8_t sensor, Callback<Sample> cb) {
+    query<Sample>(with_sensor(CMD_STR_RDRAW, sensor), parse_sample, cb);
+}
+
+void Device::read_archive(uint8_t sensor, uint32_t offset_ms, Callback<Sample> cb) {
+    query<Sample>(with_sensor(fmt(CMD_STR_RDARC "%05u", offset_ms), sensor), parse_sample, cb);
+}
+
+void Device::read_archive_us(uint8_t sensor, uint64_t offset_us, Callback<Sample> cb) {
+    query<Sample>(with_sensor(fmt(CMD_STR_RDARCU "%010llu", (unsigned long long) offset_us), sensor),
+                  parse_sample, cb);
+}
+
+void Device::read_stats(uint8_t sensor, Callback<WindowStats> cb) {
+    query<WindowStats>(with_sensor(CMD_STR_STATS, sensor), parse_stats, cb);
+}
+
+void Device::set_window(uint16_t samples, Callback<Done> cb) {
+    query<Done>(fmt(CMD_STR_SETWIN "%03u", samples), parse_done, cb);
+}
+
+void Device::get_window(Callback<uint16_t> cb) {
+    query<uint16_t>(CMD_STR_GETWIN, parse_window, cb);
+}
+
+void Device::read_lux(uint8_t sensor, Callback<Lux> cb) {
+    query<Lux>(with_sensor(CMD_STR_RDLUX, sensor), parse_lux, cb);
+}
+
+void Device::set_trigger(const Trigger &trigger, Callback<Done> cb) {
+    query<Done>(fmt(CMD_STR_SETTRG "%u%c%c%05u", trigger.index, trigger.type, trigger.channel,
+                    trigger.threshold), parse_done, cb);
+}
+
+void Device::get_trigger(uint8_t index, Callback<Trigger> cb) {
+    query<Trigger>(fmt(CMD_STR_GETTRG "%u", index), parse_trigger, cb);
+}
+
+void Device::set_source(bool int_pin, Callback<Done> cb) {
+    query<Done>(int_pin ? CMD_STR_SETSRC "1" : CMD_STR_SETSRC "0", parse_done, cb);
+}
+
+void Device::get_source(Callback<bool> cb) {
+    query<bool>(CMD_STR_GETSRC, parse_source, cb);
+}
+
+void Device::set_auto(bool enabled, Callback<Done> cb) {
+    query<Done>(enabled ? CMD_STR_SETAUTO "1" : CMD_STR_SETAUTO "0", parse_done, cb);
+}
+
+void Device::get_auto(uint8_t sensor, Callback<AutoGain> cb) {
+    query<AutoGain>(with_sensor(CMD_STR_GETAUTO, sensor), parse_auto, cb);
+}
+
+void Device::set_format(uint8_t mask, Callback<Done> cb) {
+    query<Done>(fmt(CMD_STR_SETFMT "%X", mask & 0x0F), parse_done, cb);
+}
+
+void Device::get_format(Callback<uint8_t> cb) {
+    query<uint8_t>(CMD_STR_GETFMT, parse_format, cb);
+}
+
+void Device::set_oversample(uint8_t sensor, uint8_t count, bool keep_spread, Callback<Done> cb) {
+    query<Done>(with_sensor(fmt(CMD_STR_SETOVS "%02u%u", count, keep_spread ? 1 : 0), sensor),
+                parse_done, cb);
+}
+
+void Device::get_oversample(uint8_t sensor, Callback<Oversample> cb) {
+    query<Oversample>(with_sensor(CMD_STR_GETOVS, sensor), parse_oversample, cb);
+}
+
+void Device::get_sensors(Callback<std::vector<uint8_t>> cb) {
+    query<std::vector<uint8_t>>(CMD_STR_GETSNS, parse_sensors, cb);
+}
+
+void Device::get_duty(Callback<Duty> cb) {
+    query<Duty>(CMD_STR_GETDUTY, parse_duty, cb);
+}
+
+void Device::time_sync(uint64_t t1_us, uint64_t t4_us, Callback<TimeSyncState> cb) {
+    query<TimeSyncState>(fmt(CMD_STR_TIMESYNC "%016llu%016llu", (unsigned long long) t1_us,
+                             (unsigned long long) t4_us), parse_time_sync, cb, false);
+}
+
+void Device::get_tasks(Callback<std::vector<TaskStats>> cb) {
+    query<std::vector<TaskStats>>(CMD_STR_GETTASK, parse_tasks, cb);
+}
+
+void Device::get_irqs(Callback<std::vector<IrqStats>> cb) {
+    query<std::vector<IrqStats>>(CMD_STR_GETIRQ, parse_irqs, cb);
+}
+
+void Device::read_profile(uint8_t site, Callback<SiteProfile> cb) {
+    query<SiteProfile>(fmt(CMD_STR_PROFILE "%u", site), parse_profile, cb, false);
+}
+
+void Device::read_counters(Callback<CounterSnapshot> cb) {
+    query<CounterSnapshot>(CMD_STR_RDCNT, parse_counters, cb);
+}
+
+void Device::set_trace(bool enabled, Callback<Done> cb) {
+    query<Done>(enabled ? CMD_STR_SETTRC "1" : CMD_STR_SETTRC "0", parse_done, cb);
+}
+
+void Device::read_trace(uint32_t seq, Callback<TracePage> cb) {
+    query<TracePage>(fmt(CMD_STR_RDTRC "%010u", seq), parse_trace, cb);
+}
+
+void Device::set_clock(uint8_t profile, bool persist, Callback<Done> cb) {
+    query<Done>(fmt(CMD_STR_SETCLK "%u%u", profile, persist ? 1 : 0), parse_done, cb);
+}
+
+void Device::get_clock(Callback<ClockInfo> cb) {
+    query<ClockInfo>(CMD_STR_GETCLK, parse_clock, cb);
+}
+
+}  // namespace tcs
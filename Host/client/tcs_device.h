@@ -0,0 +1,223 @@
+#ifndef TCS_DEVICE_H
+#define TCS_DEVICE_H
+
+// Typowane komendy protokolu na Client: parametry jak w process_command, odpowiedzi
+// rozbierane na struktury. Wszystkie wywolania sa asynchroniczne - wynik trafia do
+// funkcji zwrotnej z Client::poll(); await() daje wersje blokujaca.
+
+#include "tcs_client.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tcs {
+
+template <typename T>
+struct Result {
+    Status status = Status::Timeout;
+    ErrorCode error = WRCHSUM;      // Dla Status::DeviceError (NODATA - brak probek)
+    bool bad_reply = false;         // Odpowiedz nie pasuje do formatu komendy
+    T value{};
+    uint8_t attempts = 0;
+    double latency_us = 0;
+
+    bool ok() const { return status == Status::Ok && !bad_reply; }
+};
+
+template <typename T>
+using Callback = std::function<void(const Result<T> &)>;
+
+struct Done {};     // Odpowiedz OK bez danych
+
+// ANS - pola zalezne od SETFMT, T tylko dla RDARCU
+struct Sample {
+    bool has_raw = false;
+    uint16_t r = 0, g = 0, b = 0, c = 0;
+    bool has_spread = false;
+    uint16_t spread = 0;
+    bool has_lux = false;
+    uint32_t lux_x100 = 0;
+    bool has_cct = false;
+    uint32_t cct = 0;
+    bool has_epoch = false;
+    uint64_t epoch_us = 0;          // Czas hosta (po TIMESYNC)
+    bool has_timestamp = false;
+    uint64_t timestamp_us = 0;      // Czas urzadzenia (Timebase_NowUs)
+};
+
+struct ChannelStats {
+    uint16_t mean = 0;
+    uint32_t variance = 0;
+    uint16_t min = 0;
+    uint16_t max = 0;
+};
+
+struct WindowStats {
+    uint16_t window = 0;
+    uint16_t count = 0;
+    std::array<ChannelStats, 4> channels;   // R, G, B, C
+};
+
+struct Trigger {
+    uint8_t index = 0;
+    char type = 0;
+    char channel = 0;
+    uint16_t threshold = 0;
+};
+
+struct AutoGain {
+    bool enabled = false;
+    uint8_t gain_index = 0;
+    uint8_t time_index = 0;
+};
+
+struct Lux {
+    uint32_t lux_x100 = 0;
+    uint32_t cct = 0;
+    bool saturated = false;
+};
+
+struct Duty {
+    uint16_t duty_x100 = 0;         // Wypelnienie pracy rdzenia w 0.01%
+    uint32_t wakeups = 0;
+};
+
+struct Oversample {
+    uint8_t count = 0;
+    bool keep_spread = false;
+};
+
+struct TimeSyncState {
+    uint8_t source = 0;
+    int64_t offset_us = 0;
+    uint32_t delay_us = 0;
+    int32_t drift_ppb = 0;
+};
+
+struct TaskStats {
+    uint32_t runs = 0;
+    uint32_t latency_avg_us = 0;
+    uint32_t latency_max_us = 0;
+    uint32_t exec_max_us = 0;
+};
+
+struct IrqStats {
+    uint8_t prio = 0;
+    uint32_t count = 0;
+    uint32_t exec_max_x10 = 0;      // 0.1 us
+    uint32_t latency_max_x10 = 0;
+};
+
+struct SiteProfile {
+    uint8_t site = 0;
+    uint32_t count = 0;
+    uint32_t min = 0, avg = 0, max = 0;     // Cykle rdzenia
+    std::array<uint32_t, 16> hist{};
+};
+
+struct CounterSnapshot {
+    uint32_t uptime_s = 0;
+    std::vector<uint32_t> values;   // W kolejnosci Counter_t
+};
+
+struct TraceRecord {
+    uint32_t time_us = 0;
+    uint8_t event = 0;
+    uint8_t a8 = 0;
+    uint16_t a16 = 0;
+};
+
+struct TracePage {
+    uint32_t first = 0;             // Numer pierwszego wpisu
+    uint32_t head = 0;              // Nastepny wolny numer
+    std::vector<TraceRecord> entries;
+};
+
+struct ClockInfo {
+    uint8_t profile = 0;
+    uint8_t boot_profile = 0;
+    uint16_t mhz = 0;
+};
+
+class Device {
+public:
+    explicit Device(Client &client) : client_(client) {}
+
+    Client &client() { return client_; }
+
+    void start(Callback<Done> cb);
+    void stop(Callback<Done> cb);
+    void set_interval(uint32_t ms, Callback<Done> cb);
+    void get_interval(Callback<uint32_t> cb);
+    void set_gain(uint8_t sensor, uint8_t gain_index, Callback<Done> cb);
+    void get_gain(uint8_t sensor, Callback<uint8_t> cb);
+    void set_time(uint8_t sensor, uint8_t time_index, Callback<Done> cb);
+    void get_time(uint8_t sensor, Callback<uint8_t> cb);
+    void set_led(bool on, Callback<Done> cb);
+    void get_led(Callback<bool> cb);
+
+    void read_raw(uint8_t sensor, Callback<Sample> cb);
+    void read_archive(uint8_t sensor, uint32_t offset_ms, Callback<Sample> cb);
+    void read_archive_us(uint8_t sensor, uint64_t offset_us, Callback<Sample> cb);
+    void read_stats(uint8_t sensor, Callback<WindowStats> cb);
+    void set_window(uint16_t samples, Callback<Done> cb);
+    void get_window(Callback<uint16_t> cb);
+    void read_lux(uint8_t sensor, Callback<Lux> cb);
+
+    void set_trigger(const Trigger &trigger, Callback<Done> cb);
+    void get_trigger(uint8_t index, Callback<Trigger> cb);
+    void set_source(bool int_pin, Callback<Done> cb);
+    void get_source(Callback<bool> cb);
+    void set_auto(bool enabled, Callback<Done> cb);
+    void get_auto(uint8_t sensor, Callback<AutoGain> cb);
+    void set_format(uint8_t mask, Callback<Done> cb);
+    void get_format(Callback<uint8_t> cb);
+    void set_oversample(uint8_t sensor, uint8_t count, bool keep_spread, Callback<Done> cb);
+    void get_oversample(uint8_t sensor, Callback<Oversample> cb);
+
+    void get_sensors(Callback<std::vector<uint8_t>> cb);
+    void get_duty(Callback<Duty> cb);
+    // Bez retransmisji po przekroczeniu czasu - T4 dotyczy poprzedniej wymiany
+    void time_sync(uint64_t t1_us, uint64_t t4_us, Callback<TimeSyncState> cb);
+    void get_tasks(Callback<std::vector<TaskStats>> cb);
+    void get_irqs(Callback<std::vector<IrqStats>> cb);
+    // Odczyt zeruje statystyki - bez retransmisji po przekroczeniu czasu
+    void read_profile(uint8_t site, Callback<SiteProfile> cb);
+    void read_counters(Callback<CounterSnapshot> cb);
+    void set_trace(bool enabled, Callback<Done> cb);
+    void read_trace(uint32_t seq, Callback<TracePage> cb);
+    void set_clock(uint8_t profile, bool persist, Callback<Done> cb);
+    void get_clock(Callback<ClockInfo> cb);
+
+    // Parsery odpowiedzi - takze dla ramek odebranych poza Device (np. EVT, logi)
+    static bool parse_sample(const std::string &data, Sample &out);
+
+private:
+    template <typename T>
+    void query(const std::string &payload, bool (*parse)(const std::string &, T &),
+               Callback<T> cb, bool retryable = true);
+
+    Client &client_;
+};
+
+// Wersja blokujaca dowolnej komendy:
+//   auto r = tcs::await<uint32_t>(client, [&](auto cb) { dev.get_interval(cb); });
+template <typename T, typename Start>
+Result<T> await(Client &client, Start start) {
+    Result<T> result;
+    bool done = false;
+    start(Callback<T>([&](const Result<T> &r) {
+        result = r;
+        done = true;
+    }));
+    while (!done && client.poll(50)) {
+    }
+    return result;
+}
+
+}  // namespace tcs
+
+#endif
@@ -0,0 +1,158 @@
+#include "tcs_frame.h"
+
+extern "C" {
+#include "crc16.h"
+}
+
+#include <cstdio>
+
+namespace tcs {
+
+namespace {
+
+const char *const kErrorNames[] = {
+    WRCHSUM_STR, WRCMD_STR, WRLEN_STR, WRPOS_STR, WRFRM_STR,
+    WRTIME_STR, NODATA_STR, WRBUSY_STR, WRSENS_STR,
+};
+static_assert(sizeof(kErrorNames) / sizeof(kErrorNames[0]) == WRSENS + 1,
+              "kErrorNames nie odpowiada ErrorCode");
+
+const size_t kHeaderLen = FIELD_ADDR_LEN * 2 + FIELD_DATA_LEN + FIELD_ID_LEN;
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool parse_dec(const std::string &s, size_t pos, size_t len, unsigned &out) {
+    out = 0;
+    for (size_t i = pos; i < pos + len; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return false;
+        }
+        out = out * 10 + (s[i] - '0');
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string encode_frame(const std::string &sender, const std::string &receiver,
+                         uint8_t id, const std::string &data) {
+    if (sender.size() != FIELD_ADDR_LEN || receiver.size() != FIELD_ADDR_LEN
+            || data.size() > MAX_PAYLOAD_LEN - 1 || id >= kFrameIdCount) {
+        return std::string();
+    }
+    static const char kHex[] = "0123456789ABCDEF";
+    char num[8];
+
+    std::string body = sender + receiver;
+    std::snprintf(num, sizeof(num), "%03u%02u", static_cast<unsigned>(data.size() * 2), id);
+    body += num;
+    for (unsigned char c : data) {
+        body.push_back(kHex[c >> 4]);
+        body.push_back(kHex[c & 0x0F]);
+    }
+    uint16_t crc = crc16_ccitt(reinterpret_cast<const uint8_t *>(body.data()), body.size());
+    std::snprintf(num, sizeof(num), "%04X", crc);
+
+    std::string frame;
+    frame.reserve(body.size() + FIELD_CRC_LEN + 2);
+    frame.push_back(PROTOCOL_START_BYTE);
+    frame += body;
+    frame += num;
+    frame.push_back(PROTOCOL_END_BYTE);
+    return frame;
+}
+
+// raw - od & do * wlacznie
+bool decode_frame(const std::string &raw, Frame &frame) {
+    if (raw.size() < MIN_FRAME_LEN || raw.front() != PROTOCOL_START_BYTE
+            || raw.back() != PROTOCOL_END_BYTE) {
+        return false;
+    }
+    unsigned hex_len, id;
+    if (!parse_dec(raw, 1 + FIELD_ADDR_LEN * 2, FIELD_DATA_LEN, hex_len)
+            || !parse_dec(raw, 1 + FIELD_ADDR_LEN * 2 + FIELD_DATA_LEN, FIELD_ID_LEN, id)
+            || hex_len % 2 != 0
+            || raw.size() != 1 + kHeaderLen + hex_len + FIELD_CRC_LEN + 1) {
+        return false;
+    }
+
+    unsigned crc = 0;
+    for (size_t i = 0; i < FIELD_CRC_LEN; i++) {
+        int d = hex_digit(raw[1 + kHeaderLen + hex_len + i]);
+        if (d < 0) {
+            return false;
+        }
+        crc = (crc << 4) | d;
+    }
+    if (crc16_ccitt(reinterpret_cast<const uint8_t *>(raw.data() + 1), kHeaderLen + hex_len) != crc) {
+        return false;
+    }
+
+    frame.sender.assign(raw, 1, FIELD_ADDR_LEN);
+    frame.receiver.assign(raw, 1 + FIELD_ADDR_LEN, FIELD_ADDR_LEN);
+    frame.id = static_cast<uint8_t>(id);
+    frame.data.clear();
+    for (size_t i = 0; i < hex_len; i += 2) {
+        int hi = hex_digit(raw[1 + kHeaderLen + i]);
+        int lo = hex_digit(raw[2 + kHeaderLen + i]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        frame.data.push_back(static_cast<char>((hi << 4) | lo));
+    }
+    return true;
+}
+
+void FrameReader::feed(const char *data, size_t len, const FrameFn &on_frame, const BadFn &on_bad) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == PROTOCOL_START_BYTE) {
+            // Nowy poczatek porzuca niedokonczona ramke (jak parser w firmware)
+            if (!buf_.empty() && on_bad) {
+                on_bad(buf_);
+            }
+            buf_.assign(1, c);
+            continue;
+        }
+        if (buf_.empty()) {
+            continue;
+        }
+        buf_.push_back(c);
+        if (c == PROTOCOL_END_BYTE) {
+            Frame frame;
+            if (decode_frame(buf_, frame)) {
+                on_frame(frame);
+            } else if (on_bad) {
+                on_bad(buf_);
+            }
+            buf_.clear();
+        } else if (buf_.size() > MAX_FRAME_LEN) {
+            if (on_bad) {
+                on_bad(buf_);
+            }
+            buf_.clear();
+        }
+    }
+}
+
+bool error_code_of(const std::string &data, ErrorCode &code) {
+    for (unsigned i = 0; i < sizeof(kErrorNames) / sizeof(kErrorNames[0]); i++) {
+        if (data == kErrorNames[i]) {
+            code = static_cast<ErrorCode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *error_name(ErrorCode code) {
+    unsigned i = static_cast<unsigned>(code);
+    return i < sizeof(kErrorNames) / sizeof(kErrorNames[0]) ? kErrorNames[i] : "?";
+}
+
+}  // namespace tcs
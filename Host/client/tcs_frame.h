@@ -0,0 +1,54 @@
+#ifndef TCS_FRAME_H
+#define TCS_FRAME_H
+
+// Kodek ramek protokolu z protocol.h po stronie hosta:
+// & SSS RRR LLL ID dane(hex) CRC *  (LLL - dlugosc danych hex, ID - 00-99 dziesietnie,
+// CRC16-CCITT z pol od nadawcy do danych, 4 cyfry hex)
+
+extern "C" {
+#include "protocol.h"
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace tcs {
+
+constexpr uint8_t kFrameIdCount = 100;
+
+struct Frame {
+    std::string sender;
+    std::string receiver;
+    uint8_t id = 0;
+    std::string data;       // Zdekodowane dane (ASCII)
+};
+
+// Pusty napis, gdy dane sa za dlugie albo adres nie ma 3 znakow
+std::string encode_frame(const std::string &sender, const std::string &receiver,
+                         uint8_t id, const std::string &data);
+
+// Dzieli strumien bajtow na ramki. Smieci miedzy ramkami sa pomijane, ramka
+// z blednym CRC lub formatem trafia do on_bad (jesli ustawione).
+class FrameReader {
+public:
+    using FrameFn = std::function<void(const Frame &)>;
+    using BadFn = std::function<void(const std::string &raw)>;
+
+    void feed(const char *data, size_t len, const FrameFn &on_frame, const BadFn &on_bad = nullptr);
+    void reset() { buf_.clear(); }
+
+private:
+    std::string buf_;
+};
+
+bool decode_frame(const std::string &raw, Frame &frame);
+
+// Dane odpowiedzi bledu (WRCHSUM...NODATA) na ErrorCode; false dla zwyklych danych
+bool error_code_of(const std::string &data, ErrorCode &code);
+const char *error_name(ErrorCode code);
+
+}  // namespace tcs
+
+#endif
@@ -0,0 +1,142 @@
+#include "hal_host.h"
+
+GPIO_TypeDef host_gpioa = { .id = 0 }, host_gpiob = { .id = 1 }, host_gpioc = { .id = 2 };
+TIM_TypeDef host_tim2 = { .id = 2 }, host_tim5 = { .id = 5 };
+DWT_Type host_dwt;
+CoreDebug_Type host_coredebug;
+uint32_t host_primask = 0;
+uint32_t host_basepri = 0;
+uint32_t SystemCoreClock = 84000000;
+
+#define HOST_GPIO_PORTS  3
+
+static uint64_t now_us = 0;
+static uint16_t pin_state[HOST_GPIO_PORTS];
+
+static HostHal_UartSink_t uart_sink = NULL;
+static void *uart_sink_user = NULL;
+static uint8_t *uart_rx_target = NULL;
+static uint8_t uart_tx_pending = 0;
+static uint8_t uart_tx_draining = 0;
+
+static HostHal_WfiHook_t wfi_hook = NULL;
+static void *wfi_hook_user = NULL;
+
+
+uint64_t HostHal_NowUs(void) {
+    return now_us;
+}
+
+// Przesuniecie zegara symulacji; DWT liczy cykle takze w uspieniu (jak z DBG_SLEEP)
+void HostHal_SetNowUs(uint64_t us) {
+    if (us > now_us && (host_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        host_dwt.CYCCNT += (uint32_t)((us - now_us) * (SystemCoreClock / 1000000U));
+    }
+    // TIM5 liczy mikrosekundy; zawiniecie 32 bitow ustawia UIF
+    if (us > now_us) {
+        uint64_t ticks = us - now_us;
+        if ((uint64_t)host_tim5.CNT + ticks > 0xFFFFFFFFULL) {
+            host_tim5.SR |= TIM_SR_UIF;
+        }
+        host_tim5.CNT = (uint32_t)(host_tim5.CNT + ticks);
+    }
+    now_us = us;
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(now_us / 1000U);
+}
+
+void HostHal_SetPin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    if (port->id >= HOST_GPIO_PORTS) {
+        return;
+    }
+    if (state == GPIO_PIN_SET) {
+        pin_state[port->id] |= pin;
+    } else {
+        pin_state[port->id] &= (uint16_t)~pin;
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    if (port->id >= HOST_GPIO_PORTS) {
+        return GPIO_PIN_RESET;
+    }
+    return (pin_state[port->id] & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    HostHal_SetPin(port, pin, state);
+}
+
+void HostHal_SetUartSink(HostHal_UartSink_t sink, void *user) {
+    uart_sink = sink;
+    uart_sink_user = user;
+}
+
+// Nadawanie konczy sie natychmiast - kolejne bajty z bufora kolowego pobiera
+// HAL_UART_TxCpltCallback aplikacji, wywolywany w petli zamiast rekurencyjnie
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+    if (uart_sink != NULL) {
+        uart_sink(data, size, uart_sink_user);
+    }
+    uart_tx_pending = 1;
+    if (!uart_tx_draining) {
+        uart_tx_draining = 1;
+        while (uart_tx_pending) {
+            uart_tx_pending = 0;
+            HAL_UART_TxCpltCallback(huart);
+        }
+        uart_tx_draining = 0;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size) {
+    (void)huart;
+    (void)size;
+    uart_rx_target = data;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+// Bajty odebrane z zewnatrz - kazdy konczy sie przerwaniem odbioru
+void HostHal_UartReceive(UART_HandleTypeDef *huart, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (uart_rx_target == NULL) {
+            return;
+        }
+        *uart_rx_target = data[i];
+        uart_rx_target = NULL;
+        HAL_UART_RxCpltCallback(huart);
+    }
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    htim->running = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+    htim->running = 0;
+    return HAL_OK;
+}
+
+void HostHal_SetWfiHook(HostHal_WfiHook_t hook, void *user) {
+    wfi_hook = hook;
+    wfi_hook_user = user;
+}
+
+// WFI przesuwa symulacje do nastepnego zdarzenia
+void HostHal_WaitForInterrupt(void) {
+    if (wfi_hook != NULL) {
+        wfi_hook(wfi_hook_user);
+    }
+}
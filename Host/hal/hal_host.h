@@ -0,0 +1,29 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+// Sterowanie zastepczym HAL z poziomu symulatora: zegar, linie GPIO, UART
+
+#include "stm32f4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*HostHal_UartSink_t)(const uint8_t *data, uint16_t len, void *user);
+typedef void (*HostHal_WfiHook_t)(void *user);
+
+uint64_t HostHal_NowUs(void);
+void HostHal_SetNowUs(uint64_t now_us);
+
+void HostHal_SetPin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+void HostHal_SetUartSink(HostHal_UartSink_t sink, void *user);
+void HostHal_UartReceive(UART_HandleTypeDef *huart, const uint8_t *data, size_t len);
+
+void HostHal_SetWfiHook(HostHal_WfiHook_t hook, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef HOST_STM32F4XX_HAL_H
+#define HOST_STM32F4XX_HAL_H
+
+// Zastepczy naglowek HAL dla kompilacji kodu z Core/ na hoscie (Linux).
+// Definiuje tylko to, czego uzywaja moduly niezalezne od sprzetu;
+// czas, GPIO i UART sa obslugiwane przez hal_host.c.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t id;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef host_gpioa, host_gpiob, host_gpioc;
+#define GPIOA (&host_gpioa)
+#define GPIOB (&host_gpiob)
+#define GPIOC (&host_gpioc)
+
+#define GPIO_PIN_0   ((uint16_t)0x0001)
+#define GPIO_PIN_1   ((uint16_t)0x0002)
+#define GPIO_PIN_2   ((uint16_t)0x0004)
+#define GPIO_PIN_3   ((uint16_t)0x0008)
+#define GPIO_PIN_4   ((uint16_t)0x0010)
+#define GPIO_PIN_5   ((uint16_t)0x0020)
+#define GPIO_PIN_6   ((uint16_t)0x0040)
+#define GPIO_PIN_7   ((uint16_t)0x0080)
+#define GPIO_PIN_13  ((uint16_t)0x2000)
+#define GPIO_PIN_14  ((uint16_t)0x4000)
+
+typedef struct {
+    uint32_t id;
+    volatile uint32_t CR1;
+    volatile uint32_t SR;
+    volatile uint32_t EGR;
+    volatile uint32_t CNT;
+    volatile uint32_t ARR;
+} TIM_TypeDef;
+
+extern TIM_TypeDef host_tim2, host_tim5;
+#define TIM2 (&host_tim2)
+#define TIM5 (&host_tim5)
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    uint8_t running;
+} TIM_HandleTypeDef;
+
+#define TIM_SR_UIF        (1UL << 0)
+#define TIM_FLAG_UPDATE   TIM_SR_UIF
+#define __HAL_TIM_SET_COUNTER(handle, value)  ((handle)->Instance->CNT = (value))
+#define __HAL_TIM_CLEAR_FLAG(handle, flag)    ((handle)->Instance->SR &= ~(uint32_t)(flag))
+
+typedef struct {
+    uint32_t id;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    void *Instance;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+} I2C_HandleTypeDef;
+
+typedef struct {
+    void *Instance;
+} UART_HandleTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT  0x00000001U
+#define UART_FLAG_TXE         0x00000080U
+#define __HAL_UART_GET_FLAG(handle, flag)  (SET)
+
+// Rdzen - na hoscie kod wykonuje sie jednowatkowo, przerwania symuluje petla zdarzen
+extern uint32_t host_primask;
+extern uint32_t SystemCoreClock;
+
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline void __disable_irq(void) { host_primask = 1; }
+static inline void __enable_irq(void) { host_primask = 0; }
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { host_primask = primask; }
+extern uint32_t host_basepri;
+#define __NVIC_PRIO_BITS 4U
+static inline uint32_t __get_BASEPRI(void) { return host_basepri; }
+static inline void __set_BASEPRI(uint32_t basepri) { host_basepri = basepri; }
+
+void HostHal_WaitForInterrupt(void);
+#define __WFI() HostHal_WaitForInterrupt()
+
+// Licznik cykli DWT liczony z zegara symulacji
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_coredebug;
+#define DWT        (&host_dwt)
+#define CoreDebug  (&host_coredebug)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+uint32_t HAL_GetTick(void);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,288 @@
+#include "sim_board.h"
+#include "hal_host.h"
+#include "circular_buffer.h"
+#include "protocol.h"
+#include "power.h"
+#include "usart.h"
+#include "tim.h"
+#include "i2c.h"
+#include "timebase.h"
+#include "timesync.h"
+#include "clock_profile.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "counters.h"
+#include "trace.h"
+#include <string.h>
+
+// Odpowiedniki obiektow z main.c / usart.c / tim.c / i2c.c
+volatile uint32_t timer_interval = 1000;
+UART_HandleTypeDef huart2;
+TIM_HandleTypeDef htim2 = { .Instance = TIM2 };
+TIM_HandleTypeDef htim5 = { .Instance = TIM5 };
+I2C_HandleTypeDef hi2c1;
+
+// Konfiguracja stanowiska - uzupelniana w SimBoard_Init: czujniki rozdzielone po
+// magistralach, a przy wiekszej liczbie czujnikow niz magistral - za TCA9548A
+TCS34725_Bus_t tcs_buses[TCS_BUS_COUNT];
+TCS34725_Sensor_t tcs_sensors[TCS_SENSOR_COUNT];
+
+static TcsSim_Sensor_t sim_sensors[TCS_SENSOR_COUNT];
+static SimBus_t sim_buses[TCS_BUS_COUNT];
+static uint8_t int_level[TCS_SENSOR_COUNT];
+
+static uint64_t next_tick_us = 0;       // Nastepne przerwanie TIM2
+static uint64_t period_us = 0;          // Okres TIM2 (aktywny ARR)
+static uint64_t period_preload_us = 0;  // Bufor ARR - obowiazuje od nastepnego update
+static uint32_t timer_interrupts = 0;
+static uint64_t run_end_us = 0;
+static uint32_t loop_iterations = 0;
+static SimBoard_EventFn_t event_hook = NULL;
+static void *event_hook_user = NULL;
+
+
+// Linie INT: czujnik 0 na TCS_INT (PC2) jak na plytce, kolejne na PB0..PB7
+static void int_line(uint8_t sensor, GPIO_TypeDef **port, uint16_t *pin) {
+    if (sensor == 0) {
+        *port = TCS_INT_GPIO_Port;
+        *pin = TCS_INT_Pin;
+    } else {
+        *port = GPIOB;
+        *pin = (uint16_t)(GPIO_PIN_0 << ((sensor - 1) & 7));
+    }
+}
+
+void SimBoard_Init(const TcsSim_Scene_t *scene) {
+    HostHal_SetNowUs(0);
+    next_tick_us = 0;
+    timer_interrupts = 0;
+    loop_iterations = 0;
+
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        memset(&tcs_buses[b], 0, sizeof(tcs_buses[b]));
+        tcs_buses[b].mux_channel = TCS_NO_MUX;
+        SimBus_Init(&sim_buses[b], &tcs_buses[b]);
+    }
+
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TCS34725_Sensor_t *s = &tcs_sensors[i];
+        memset(s, 0, sizeof(*s));
+        s->bus = i % TCS_BUS_COUNT;
+        s->mux_channel = (TCS_SENSOR_COUNT > TCS_BUS_COUNT) ? (uint8_t)(i / TCS_BUS_COUNT) : TCS_NO_MUX;
+        s->gain_index = TCS_DEFAULT_GAIN_INDEX;
+        s->time_index = TCS_DEFAULT_TIME_INDEX;
+        s->gain_applied = TCS_DEFAULT_GAIN_INDEX;
+        s->time_applied = TCS_DEFAULT_TIME_INDEX;
+        s->oversample = 1;
+        int_line(i, &s->int_port, &s->int_pin);
+
+        TcsSim_Init(&sim_sensors[i], scene, s->int_port, s->int_pin);
+        sim_sensors[i].noise_state ^= (uint32_t)i * 0x9E3779B9U;   // Niezalezny szum czujnikow
+        SimBus_Attach(&sim_buses[s->bus], s->mux_channel, &sim_sensors[i]);
+        int_level[i] = 1;
+    }
+}
+
+// Odpowiednik sekcji USER CODE 2 z main.c
+void SimBoard_Boot(void) {
+    Timebase_Init();
+    TimeSync_Init();
+    Clock_Init();
+    Power_Init();
+    Profile_Init();
+    Sched_Init();
+    Sched_AddTask(TCS34725_HandleLoop, SCHED_EVT_SENSOR);
+    Sched_AddTask(process_protocol_data, SCHED_EVT_UART_RX);
+    Sched_AddTask(process_trigger_events, SCHED_EVT_TRIGGER);
+    TCS34725_Init();
+    HAL_UART_Receive_IT(&huart2, &UART_RxBuf[0], 1);
+    UART_TX_FSend("STM INIT\n");
+}
+
+void SimBoard_SetOutput(SimBoard_OutputFn_t fn, void *user) {
+    HostHal_SetUartSink(fn, user);
+}
+
+void SimBoard_Send(const char *data, size_t len) {
+    HostHal_UartReceive(&huart2, (const uint8_t *)data, len);
+}
+
+void SimBoard_SetEventHook(SimBoard_EventFn_t fn, void *user) {
+    event_hook = fn;
+    event_hook_user = user;
+}
+
+TcsSim_Sensor_t* SimBoard_Sensor(uint8_t sensor) {
+    return sensor < TCS_SENSOR_COUNT ? &sim_sensors[sensor] : NULL;
+}
+
+SimBus_t* SimBoard_Bus(uint8_t bus) {
+    return bus < TCS_BUS_COUNT ? &sim_buses[bus] : NULL;
+}
+
+uint64_t SimBoard_NowUs(void) {
+    return HostHal_NowUs();
+}
+
+uint32_t SimBoard_LoopIterations(void) {
+    return loop_iterations;
+}
+
+uint32_t SimBoard_TimerInterrupts(void) {
+    return timer_interrupts;
+}
+
+// Odpowiedniki funkcji z tim.c - ARR z buforowaniem jak przy ARPE
+void TIM2_SetSampleInterval(uint32_t interval_ms) {
+    period_preload_us = (uint64_t)interval_ms * 1000U;
+}
+
+void TIM2_StartSampling(uint32_t interval_ms) {
+    period_preload_us = (uint64_t)interval_ms * 1000U;
+    period_us = period_preload_us;
+    next_tick_us = HostHal_NowUs() + period_us;
+    HAL_TIM_Base_Start_IT(&htim2);
+}
+
+// Zdarzenia do chwili biezacej: integracje czujnikow, zbocza INT, koniec transferow, TIM2
+static void deliver_events(void) {
+    uint64_t now = HostHal_NowUs();
+
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TcsSim_Advance(&sim_sensors[i], now);
+    }
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TCS34725_Sensor_t *s = &tcs_sensors[i];
+        uint8_t level = HAL_GPIO_ReadPin(s->int_port, s->int_pin) == GPIO_PIN_SET;
+        if (int_level[i] && !level) {
+            HAL_GPIO_EXTI_Callback(s->int_pin);
+        }
+        int_level[i] = level;
+    }
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        SimBus_Advance(&sim_buses[b], now);
+    }
+
+    while (htim2.running && next_tick_us <= now) {
+        timer_interrupts++;
+        HAL_TIM_PeriodElapsedCallback(&htim2);
+        period_us = period_preload_us;
+        next_tick_us += period_us;
+    }
+
+    // Przepelnienie 32-bitowego licznika us podstawy czasu
+    if (htim5.running && (TIM5->SR & TIM_SR_UIF)) {
+        __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+        HAL_TIM_PeriodElapsedCallback(&htim5);
+    }
+
+    // Odpowiednik SysTick - zdarzenia odlozone harmonogramu
+    Sched_OnTick();
+
+    if (event_hook != NULL) {
+        event_hook(event_hook_user);
+    }
+}
+
+static uint64_t next_event_us(void) {
+    uint64_t next = UINT64_MAX;
+
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        uint64_t t = TcsSim_NextEventUs(&sim_sensors[i]);
+        if (t < next) {
+            next = t;
+        }
+    }
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        uint64_t t = SimBus_NextEventUs(&sim_buses[b]);
+        if (t < next) {
+            next = t;
+        }
+    }
+    if (htim2.running && next_tick_us < next) {
+        next = next_tick_us;
+    }
+    uint32_t deadline = Sched_NextDeadline();
+    if (deadline != SCHED_NO_DEADLINE && (uint64_t)deadline * 1000U < next) {
+        next = (uint64_t)deadline * 1000U;
+    }
+    if (htim5.running) {
+        uint64_t wrap = HostHal_NowUs() + (0x100000000ULL - TIM5->CNT);
+        if (wrap < next) {
+            next = wrap;
+        }
+    }
+    return next;
+}
+
+// WFI - uspienie do najblizszego zdarzenia (nie dalej niz koniec przebiegu)
+static void on_wfi(void *user) {
+    (void)user;
+    uint64_t next = next_event_us();
+    if (next > run_end_us) {
+        next = run_end_us;
+    }
+    if (next > HostHal_NowUs()) {
+        HostHal_SetNowUs(next);
+    }
+    deliver_events();
+}
+
+void SimBoard_RunUntil(uint64_t end_us) {
+    run_end_us = end_us;
+    HostHal_SetWfiHook(on_wfi, NULL);
+
+    while (HostHal_NowUs() < end_us) {
+        // Czas wykonania iteracji - liczony przez DWT jako praca rdzenia
+        HostHal_SetNowUs(HostHal_NowUs() + SIM_LOOP_COST_US);
+        deliver_events();
+
+        // Odpowiednik petli while(1) z main.c
+        Sched_Run();
+        loop_iterations++;
+    }
+}
+
+void SimBoard_RunFor(uint32_t ms) {
+    SimBoard_RunUntil(HostHal_NowUs() + (uint64_t)ms * 1000U);
+}
+
+// Odpowiedniki callbackow z main.c (USER CODE 0 i 4)
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart == &huart2) {
+        Counter_Inc(CNT_TX_BYTES);
+        if (UART_TX_Empty != UART_TX_Busy) {
+            uint8_t tmp = UART_TxBuf[UART_TX_Busy];
+            UART_TX_Busy++;
+            if (UART_TX_Busy >= UART_TXBUF_LEN) UART_TX_Busy = 0;
+            HAL_UART_Transmit_IT(&huart2, &tmp, 1);
+        }
+    }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart == &huart2) {
+        if (UART_RxBuf[UART_RX_Empty] == PROTOCOL_START_BYTE) {
+            UART_RX_StampStart(UART_RX_Empty, Timebase_NowUs());
+            Trace_Event(TRC_FRAME_START, 0, (UART_RX_Empty - UART_RX_Busy + UART_RXBUF_LEN) % UART_RXBUF_LEN);
+        }
+        UART_RX_Empty++;
+        if (UART_RX_Empty >= UART_RXBUF_LEN) UART_RX_Empty = 0;
+        Counter_Inc(CNT_RX_BYTES);
+        if (UART_RX_Empty == UART_RX_Busy) Counter_Inc(CNT_RX_OVERRUNS);
+        HAL_UART_Receive_IT(&huart2, &UART_RxBuf[UART_RX_Empty], 1);
+        Sched_Signal(SCHED_EVT_UART_RX);
+    }
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    if (htim->Instance == TIM2) {
+        TCS34725_OnTimerTick();
+    } else if (htim->Instance == TIM5) {
+        Timebase_OnOverflow();
+    }
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    TCS34725_OnInterrupt(GPIO_Pin);
+}
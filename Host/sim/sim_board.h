@@ -0,0 +1,40 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+// Plytka symulowana na hoscie: magistrale, czujniki, TIM2, EXTI i UART.
+// Petla glowna z main.c wykonywana jest w symulowanym czasie - WFI w Power_Idle
+// przesuwa zegar do najblizszego zdarzenia (tick timera, koniec transferu, integracja).
+
+#include "tcs34725.h"
+#include "tcs34725_sim.h"
+#include "sim_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Koszt jednej iteracji petli glownej bez uspienia
+#define SIM_LOOP_COST_US  5U
+
+typedef void (*SimBoard_OutputFn_t)(const uint8_t *data, uint16_t len, void *user);
+typedef void (*SimBoard_EventFn_t)(void *user);
+
+void SimBoard_Init(const TcsSim_Scene_t *scene);
+void SimBoard_Boot(void);
+void SimBoard_RunUntil(uint64_t end_us);
+void SimBoard_RunFor(uint32_t ms);
+void SimBoard_Send(const char *data, size_t len);
+void SimBoard_SetOutput(SimBoard_OutputFn_t fn, void *user);
+void SimBoard_SetEventHook(SimBoard_EventFn_t fn, void *user);   // Po kazdej porcji zdarzen
+
+TcsSim_Sensor_t* SimBoard_Sensor(uint8_t sensor);
+SimBus_t* SimBoard_Bus(uint8_t bus);
+uint64_t SimBoard_NowUs(void);
+uint32_t SimBoard_LoopIterations(void);
+uint32_t SimBoard_TimerInterrupts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
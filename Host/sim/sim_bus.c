@@ -0,0 +1,142 @@
+#include "sim_bus.h"
+#include "hal_host.h"
+#include <string.h>
+
+// Start, stop i ewentualny powtorzony start liczone jako pojedyncze bity
+#define SIM_BUS_FRAMING_BITS  3
+
+
+static uint64_t transfer_us(uint16_t bytes) {
+    uint64_t bits = (uint64_t)bytes * 9U + SIM_BUS_FRAMING_BITS;
+    return (bits * 1000000U + SIM_BUS_CLOCK_HZ - 1) / SIM_BUS_CLOCK_HZ;
+}
+
+static HAL_StatusTypeDef start_transfer(SimBus_t *sim, uint8_t is_read, uint16_t addr,
+                                        uint8_t reg, uint8_t *data, uint16_t len) {
+    if (sim->active) {
+        return HAL_BUSY;
+    }
+
+    // Odczyt rejestru: adres + komenda, powtorzony start, adres + dane
+    uint16_t bytes = is_read ? (uint16_t)(len + 3) : (uint16_t)(len + 1);
+    uint64_t duration = transfer_us(bytes);
+
+    sim->active = 1;
+    sim->is_read = is_read;
+    sim->addr = addr;
+    sim->reg = reg;
+    sim->data = data;
+    sim->len = len;
+    sim->done_us = HostHal_NowUs() + duration;
+
+    sim->transfers++;
+    sim->bytes += bytes;
+    sim->busy_us += duration;
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef sim_mem_read(void *ctx, uint16_t addr, uint8_t reg, uint8_t *data, uint16_t len) {
+    return start_transfer((SimBus_t *)ctx, 1, addr, reg, data, len);
+}
+
+static HAL_StatusTypeDef sim_write(void *ctx, uint16_t addr, uint8_t *data, uint16_t len) {
+    return start_transfer((SimBus_t *)ctx, 0, addr, 0, data, len);
+}
+
+static void sim_abort(void *ctx) {
+    ((SimBus_t *)ctx)->active = 0;
+}
+
+static void sim_recover(void *ctx) {
+    ((SimBus_t *)ctx)->active = 0;
+}
+
+const TCS34725_BusOps_t sim_bus_ops = {
+    .mem_read = sim_mem_read,
+    .write = sim_write,
+    .abort = sim_abort,
+    .recover = sim_recover,
+};
+
+void SimBus_Init(SimBus_t *sim, TCS34725_Bus_t *bus) {
+    memset(sim, 0, sizeof(*sim));
+    sim->bus = bus;
+    bus->ops = &sim_bus_ops;
+    bus->ctx = sim;
+}
+
+void SimBus_Attach(SimBus_t *sim, uint8_t mux_channel, TcsSim_Sensor_t *dev) {
+    if (mux_channel == TCS_NO_MUX) {
+        sim->direct = dev;
+    } else if (mux_channel < SIM_BUS_MUX_CHANNELS) {
+        sim->mux[mux_channel] = dev;
+        sim->has_mux = 1;
+    }
+}
+
+void SimBus_InjectErrors(SimBus_t *sim, uint32_t count) {
+    sim->fail_next = count;
+}
+
+// Czujnik odpowiadajacy na adres TCS34725: bezposredni lub na wlaczonym kanale
+static TcsSim_Sensor_t* find_sensor(SimBus_t *sim) {
+    if (sim->direct != NULL) {
+        return sim->direct;
+    }
+    for (uint8_t ch = 0; ch < SIM_BUS_MUX_CHANNELS; ch++) {
+        if ((sim->mux_mask & (1U << ch)) && sim->mux[ch] != NULL) {
+            return sim->mux[ch];
+        }
+    }
+    return NULL;
+}
+
+// Wykonanie transferu w chwili jego zakonczenia; 1 - ACK
+static uint8_t execute(SimBus_t *sim) {
+    if (sim->fail_next > 0) {
+        sim->fail_next--;
+        return 0;
+    }
+
+    if (sim->has_mux && sim->addr == TCA9548A_ADDRESS) {
+        if (sim->is_read) {
+            for (uint16_t i = 0; i < sim->len; i++) {
+                sim->data[i] = sim->mux_mask;
+            }
+        } else if (sim->len > 0) {
+            sim->mux_mask = sim->data[sim->len - 1];
+        }
+        return 1;
+    }
+
+    if (sim->addr != TCS34725_ADDRESS) {
+        return 0;
+    }
+    TcsSim_Sensor_t *dev = find_sensor(sim);
+    if (dev == NULL) {
+        return 0;
+    }
+
+    if (sim->is_read) {
+        return TcsSim_Write(dev, &sim->reg, 1) && TcsSim_Read(dev, sim->data, sim->len);
+    }
+    return TcsSim_Write(dev, sim->data, sim->len);
+}
+
+void SimBus_Advance(SimBus_t *sim, uint64_t now_us) {
+    if (!sim->active || sim->done_us > now_us) {
+        return;
+    }
+
+    sim->active = 0;
+    if (execute(sim)) {
+        TCS34725_BusComplete(sim->bus);
+    } else {
+        sim->errors++;
+        TCS34725_BusError(sim->bus);
+    }
+}
+
+uint64_t SimBus_NextEventUs(const SimBus_t *sim) {
+    return sim->active ? sim->done_us : UINT64_MAX;
+}
@@ -0,0 +1,55 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+// Symulowana magistrala I2C 400kHz z opcjonalnym TCA9548A.
+// Transfer trwa tyle, ile na prawdziwej magistrali (9 bitow na bajt + start/stop),
+// a po jego zakonczeniu wolane jest TCS34725_BusComplete lub TCS34725_BusError.
+
+#include "tcs34725.h"
+#include "tcs34725_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_BUS_CLOCK_HZ     400000U
+#define SIM_BUS_MUX_CHANNELS 8
+
+typedef struct {
+    TCS34725_Bus_t *bus;                              // Magistrala sterownika
+    TcsSim_Sensor_t *direct;                          // Czujnik bez multipleksera
+    TcsSim_Sensor_t *mux[SIM_BUS_MUX_CHANNELS];       // Czujniki na kanalach TCA9548A
+    uint8_t has_mux;
+    uint8_t mux_mask;                                 // Kanaly wlaczone w TCA9548A
+
+    // Transfer w toku
+    uint8_t active;
+    uint8_t is_read;
+    uint16_t addr;
+    uint8_t reg;
+    uint8_t *data;
+    uint16_t len;
+    uint64_t done_us;
+
+    uint32_t fail_next;                               // Wstrzykiwane bledy (NACK)
+
+    // Statystyki
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t errors;
+    uint64_t busy_us;                                 // Laczny czas zajetosci magistrali
+} SimBus_t;
+
+extern const TCS34725_BusOps_t sim_bus_ops;
+
+void SimBus_Init(SimBus_t *sim, TCS34725_Bus_t *bus);
+void SimBus_Attach(SimBus_t *sim, uint8_t mux_channel, TcsSim_Sensor_t *dev);
+void SimBus_InjectErrors(SimBus_t *sim, uint32_t count);
+void SimBus_Advance(SimBus_t *sim, uint64_t now_us);
+uint64_t SimBus_NextEventUs(const SimBus_t *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+#include "clock_profile.h"
+#include "rtc_clock.h"
+
+// Profile zegara na hoscie: bez RCC, zmienia sie tylko SystemCoreClock,
+// z ktorego liczony jest zastepczy DWT->CYCCNT (skala PROFILE i GETIRQ).
+// Profil po starcie zapamietywany jak w firmware - w rejestrze zapasowym RTC.
+static const uint32_t profile_hz[CLOCK_PROFILE_COUNT] = {
+    [CLOCK_PROFILE_LOW_POWER] = CLOCK_LOW_POWER_HZ,
+    [CLOCK_PROFILE_DEFAULT]   = CLOCK_DEFAULT_HZ,
+    [CLOCK_PROFILE_MAX]       = CLOCK_MAX_HZ,
+};
+
+static ClockProfile_t current_profile = CLOCK_PROFILE_DEFAULT;
+
+
+void Clock_Init(void) {
+    current_profile = Clock_GetBootProfile();
+    SystemCoreClock = profile_hz[current_profile];
+}
+
+HAL_StatusTypeDef Clock_SetProfile(ClockProfile_t profile, uint8_t persist) {
+    if (profile >= CLOCK_PROFILE_COUNT) {
+        return HAL_ERROR;
+    }
+    current_profile = profile;
+    SystemCoreClock = profile_hz[profile];
+    if (persist) {
+        RtcClock_BackupWrite(RTC_CLOCK_BKP_CLOCK, CLOCK_BKP_TAG | profile);
+    }
+    return HAL_OK;
+}
+
+ClockProfile_t Clock_GetProfile(void) {
+    return current_profile;
+}
+
+ClockProfile_t Clock_GetBootProfile(void) {
+    uint32_t stored = RtcClock_BackupRead(RTC_CLOCK_BKP_CLOCK);
+
+    if ((stored & 0xFFFFFF00U) == CLOCK_BKP_TAG && (stored & 0xFFU) < CLOCK_PROFILE_COUNT) {
+        return (ClockProfile_t)(stored & 0xFFU);
+    }
+    return CLOCK_PROFILE_BOOT;
+}
+
+uint32_t Clock_GetProfileHz(ClockProfile_t profile) {
+    return profile < CLOCK_PROFILE_COUNT ? profile_hz[profile] : 0;
+}
@@ -0,0 +1,55 @@
+#include "rtc_clock.h"
+#include "hal_host.h"
+
+// RTC na hoscie: kalendarz liczony od zegara symulacji z rozdzielczoscia 1/256 s.
+// Stan jest statyczny, wiec przetrwa ponowne SimBoard_Init/SimBoard_Boot jak domena VBAT.
+#define SIM_RTC_BKP_COUNT  20
+#define SIM_RTC_TICK_US    (1000000.0 / 256.0)
+
+static uint8_t rtc_running = 0;
+static uint64_t set_epoch_s = 0;     // Pelna sekunda ustawiona w kalendarzu
+static uint64_t set_now_us = 0;      // Chwila wyjscia z trybu inicjalizacji
+static uint32_t backup[SIM_RTC_BKP_COUNT];
+
+
+uint8_t RtcClock_Init(void) {
+    if (rtc_running) {
+        return RtcClock_BackupRead(RTC_CLOCK_BKP_MAGIC) == RTC_CLOCK_MAGIC;
+    }
+    for (uint8_t i = 0; i < SIM_RTC_BKP_COUNT; i++) {
+        backup[i] = 0;
+    }
+    rtc_running = 1;
+    return 0;
+}
+
+uint8_t RtcClock_Read(uint64_t *epoch_us) {
+    if (!rtc_running || backup[RTC_CLOCK_BKP_MAGIC] != RTC_CLOCK_MAGIC) {
+        return 0;
+    }
+    uint64_t elapsed_us = HostHal_NowUs() - set_now_us;
+    uint64_t ticks = (uint64_t)((double)elapsed_us / SIM_RTC_TICK_US);
+    *epoch_us = set_epoch_s * 1000000U + (uint64_t)((double)ticks * SIM_RTC_TICK_US)
+                + backup[RTC_CLOCK_BKP_SUBUS];
+    return 1;
+}
+
+void RtcClock_Write(uint64_t epoch_us) {
+    if (!rtc_running) {
+        return;
+    }
+    set_epoch_s = epoch_us / 1000000U;
+    set_now_us = HostHal_NowUs();
+    backup[RTC_CLOCK_BKP_SUBUS] = (uint32_t)(epoch_us % 1000000U);
+    backup[RTC_CLOCK_BKP_MAGIC] = RTC_CLOCK_MAGIC;
+}
+
+uint32_t RtcClock_BackupRead(uint8_t reg) {
+    return reg < SIM_RTC_BKP_COUNT ? backup[reg] : 0;
+}
+
+void RtcClock_BackupWrite(uint8_t reg, uint32_t value) {
+    if (reg < SIM_RTC_BKP_COUNT) {
+        backup[reg] = value;
+    }
+}
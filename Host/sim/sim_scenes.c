@@ -0,0 +1,32 @@
+#include "tcs34725_sim.h"
+#include <string.h>
+
+// Sceny wbudowane - wspolne dla tcs_sim i tcs_pty
+static const TcsSim_Scene_t scenes[] = {
+    { .name = "dark", .segment_count = 1, .noise_permille = 50,
+      .segments = { { 1000, { 0.4f, 0.15f, 0.15f, 0.1f }, { 0.4f, 0.15f, 0.15f, 0.1f } } } },
+    { .name = "office", .segment_count = 1, .noise_permille = 10,
+      .segments = { { 1000, { 120, 45, 48, 32 }, { 120, 45, 48, 32 } } } },
+    { .name = "sunlight", .segment_count = 1, .noise_permille = 5,
+      .segments = { { 1000, { 600, 225, 212, 175 }, { 600, 225, 212, 175 } } } },
+    { .name = "sunrise", .segment_count = 2, .noise_permille = 10,
+      .segments = { { 5000, { 1, 0.5f, 0.3f, 0.2f }, { 800, 320, 280, 200 } },
+                    { 5000, { 800, 320, 280, 200 }, { 3000, 1100, 1000, 850 } } } },
+    { .name = "flicker", .segment_count = 2, .loop = 1, .noise_permille = 10,
+      .segments = { { 300, { 200, 80, 70, 50 }, { 200, 80, 70, 50 } },
+                    { 300, { 20, 8, 7, 5 }, { 20, 8, 7, 5 } } } },
+};
+
+
+const TcsSim_Scene_t* TcsSim_SceneAt(size_t index) {
+    return index < sizeof(scenes) / sizeof(scenes[0]) ? &scenes[index] : NULL;
+}
+
+const TcsSim_Scene_t* TcsSim_FindScene(const char *name) {
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+        if (strcmp(scenes[i].name, name) == 0) {
+            return &scenes[i];
+        }
+    }
+    return NULL;
+}
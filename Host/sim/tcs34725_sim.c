@@ -0,0 +1,322 @@
+#include "tcs34725_sim.h"
+#include "tcs34725.h"
+#include "hal_host.h"
+#include <string.h>
+
+#define SIM_CMD_TYPE_REPEAT   0x00
+#define SIM_CMD_TYPE_AUTOINC  0x01
+#define SIM_CMD_TYPE_SPECIAL  0x03
+#define SIM_ADDR_MASK         0x1F
+#define SIM_INTEGRATION_STEPS 8     // Probki sceny na jedna integracje
+
+static const uint8_t sim_gain_multiplier[4] = { 1, 4, 16, 60 };
+
+
+static uint8_t atime_cycles(const TcsSim_Sensor_t *dev) {
+    return (uint8_t)(256 - dev->regs[TCS34725_ATIME]);
+}
+
+uint16_t TcsSim_FullScale(const TcsSim_Sensor_t *dev) {
+    uint32_t full = (uint32_t)(256 - dev->regs[TCS34725_ATIME]) * 1024U;
+    return full > 65535U ? 65535U : (uint16_t)full;
+}
+
+static uint64_t wait_us(const TcsSim_Sensor_t *dev) {
+    uint64_t us = (uint64_t)(256 - dev->regs[TCS34725_WTIME]) * TCS_SIM_CYCLE_US;
+    if (dev->regs[TCS34725_CONFIG] & TCS34725_CONFIG_WLONG) {
+        us *= TCS34725_WLONG_FACTOR;
+    }
+    return us;
+}
+
+// Linia INT - stan niski, gdy AINT ustawione i AIEN wlaczone
+static void update_int_line(TcsSim_Sensor_t *dev) {
+    if (dev->int_port == NULL) {
+        return;
+    }
+    uint8_t asserted = (dev->regs[TCS34725_STATUS] & TCS34725_STATUS_AINT)
+                       && (dev->regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN);
+    HostHal_SetPin(dev->int_port, dev->int_pin, asserted ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+void TcsSim_Init(TcsSim_Sensor_t *dev, const TcsSim_Scene_t *scene,
+                 GPIO_TypeDef *int_port, uint16_t int_pin) {
+    memset(dev, 0, sizeof(*dev));
+
+    // Wartosci po resecie wg noty katalogowej
+    dev->regs[TCS34725_ATIME] = 0xFF;
+    dev->regs[TCS34725_WTIME] = 0xFF;
+    dev->regs[TCS34725_ID] = TCS34725_EXPECTED_ID;
+    dev->phase = TCS_SIM_SLEEP;
+    dev->int_port = int_port;
+    dev->int_pin = int_pin;
+    TcsSim_SetScene(dev, scene);
+    update_int_line(dev);
+}
+
+void TcsSim_SetScene(TcsSim_Sensor_t *dev, const TcsSim_Scene_t *scene) {
+    dev->scene = scene;
+    dev->noise_state = (scene != NULL && scene->seed != 0) ? scene->seed : 0x12345678U;
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+TcsSim_Light_t TcsSim_SceneLight(const TcsSim_Scene_t *scene, uint64_t t_us) {
+    TcsSim_Light_t none = { 0, 0, 0, 0 };
+    if (scene == NULL || scene->segment_count == 0) {
+        return none;
+    }
+
+    uint64_t total_us = 0;
+    for (uint8_t i = 0; i < scene->segment_count; i++) {
+        total_us += (uint64_t)scene->segments[i].duration_ms * 1000U;
+    }
+
+    const TcsSim_Segment_t *last = &scene->segments[scene->segment_count - 1];
+    if (total_us == 0) {
+        return last->to;
+    }
+    if (t_us >= total_us) {
+        if (!scene->loop) {
+            return last->to;
+        }
+        t_us %= total_us;
+    }
+
+    for (uint8_t i = 0; i < scene->segment_count; i++) {
+        const TcsSim_Segment_t *seg = &scene->segments[i];
+        uint64_t seg_us = (uint64_t)seg->duration_ms * 1000U;
+        if (t_us < seg_us) {
+            float t = (float)t_us / (float)seg_us;
+            TcsSim_Light_t light = {
+                lerp(seg->from.c, seg->to.c, t),
+                lerp(seg->from.r, seg->to.r, t),
+                lerp(seg->from.g, seg->to.g, t),
+                lerp(seg->from.b, seg->to.b, t),
+            };
+            return light;
+        }
+        t_us -= seg_us;
+    }
+    return last->to;
+}
+
+// Szum o rozkladzie zblizonym do normalnego (suma czterech rownomiernych), wariancja 1
+static float noise_sample(TcsSim_Sensor_t *dev) {
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < 4; i++) {
+        uint32_t x = dev->noise_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        dev->noise_state = x;
+        sum += (float)x / 4294967296.0f - 0.5f;
+    }
+    return sum * 1.7320508f;
+}
+
+static uint16_t channel_counts(TcsSim_Sensor_t *dev, float rate, float scale, uint16_t full) {
+    float counts = rate * scale;
+    if (dev->scene != NULL && dev->scene->noise_permille > 0) {
+        counts *= 1.0f + noise_sample(dev) * (float)dev->scene->noise_permille / 1000.0f;
+    }
+    if (counts <= 0.0f) {
+        return 0;
+    }
+    if (counts >= (float)full) {
+        return full;
+    }
+    return (uint16_t)(counts + 0.5f);
+}
+
+static void store16(TcsSim_Sensor_t *dev, uint8_t reg, uint16_t value) {
+    dev->regs[reg] = (uint8_t)(value & 0xFF);
+    dev->regs[reg + 1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t load16(const TcsSim_Sensor_t *dev, uint8_t reg) {
+    return (uint16_t)(dev->regs[reg] | (dev->regs[reg + 1] << 8));
+}
+
+// Liczba kolejnych wynikow poza progami wymagana przez PERS
+static uint8_t persistence_limit(uint8_t pers) {
+    pers &= 0x0F;
+    if (pers <= 3) {
+        return pers;
+    }
+    return (uint8_t)(5 * (pers - 3));
+}
+
+// Koniec integracji: zatrzasniecie danych, AVALID i ocena przerwania
+static void finish_integration(TcsSim_Sensor_t *dev, uint64_t end_us) {
+    uint8_t cycles = atime_cycles(dev);
+    uint16_t full = TcsSim_FullScale(dev);
+    float scale = (float)cycles * sim_gain_multiplier[dev->regs[TCS34725_CONTROL] & 0x03];
+
+    // Srednie natezenie w oknie integracji
+    TcsSim_Light_t avg = { 0, 0, 0, 0 };
+    uint64_t span = end_us - dev->integ_start_us;
+    for (uint8_t i = 0; i < SIM_INTEGRATION_STEPS; i++) {
+        uint64_t t = dev->integ_start_us + span * (2U * i + 1U) / (2U * SIM_INTEGRATION_STEPS);
+        TcsSim_Light_t light = TcsSim_SceneLight(dev->scene, t);
+        avg.c += light.c / SIM_INTEGRATION_STEPS;
+        avg.r += light.r / SIM_INTEGRATION_STEPS;
+        avg.g += light.g / SIM_INTEGRATION_STEPS;
+        avg.b += light.b / SIM_INTEGRATION_STEPS;
+    }
+
+    uint16_t c = channel_counts(dev, avg.c, scale, full);
+    store16(dev, TCS34725_CDATAL, c);
+    store16(dev, TCS34725_CDATAL + 2, channel_counts(dev, avg.r, scale, full));
+    store16(dev, TCS34725_CDATAL + 4, channel_counts(dev, avg.g, scale, full));
+    store16(dev, TCS34725_CDATAL + 6, channel_counts(dev, avg.b, scale, full));
+    dev->regs[TCS34725_STATUS] |= TCS34725_STATUS_AVALID;
+
+    dev->cycles++;
+    if (c >= full) {
+        dev->saturated++;
+    }
+
+    uint8_t limit = persistence_limit(dev->regs[TCS34725_PERS]);
+    uint8_t out_of_range = c < load16(dev, TCS34725_AILTL) || c > load16(dev, TCS34725_AIHTL);
+    if (limit == 0) {
+        out_of_range = 1;
+    }
+    if (out_of_range) {
+        if (dev->pers_count < 255) {
+            dev->pers_count++;
+        }
+        if (dev->pers_count >= limit || limit == 0) {
+            if (!(dev->regs[TCS34725_STATUS] & TCS34725_STATUS_AINT)) {
+                dev->interrupts++;
+            }
+            dev->regs[TCS34725_STATUS] |= TCS34725_STATUS_AINT;
+        }
+    } else {
+        dev->pers_count = 0;
+    }
+    update_int_line(dev);
+}
+
+void TcsSim_Advance(TcsSim_Sensor_t *dev, uint64_t now_us) {
+    while (dev->phase >= TCS_SIM_INIT && dev->phase_end_us <= now_us) {
+        uint64_t t = dev->phase_end_us;
+        switch (dev->phase) {
+            case TCS_SIM_INIT:
+            case TCS_SIM_WAITING:
+                dev->phase = TCS_SIM_INTEGRATING;
+                dev->integ_start_us = t;
+                dev->phase_end_us = t + (uint64_t)atime_cycles(dev) * TCS_SIM_CYCLE_US;
+                break;
+            case TCS_SIM_INTEGRATING:
+                finish_integration(dev, t);
+                if (dev->regs[TCS34725_ENABLE] & TCS34725_ENABLE_WEN) {
+                    dev->phase = TCS_SIM_WAITING;
+                    dev->phase_end_us = t + wait_us(dev);
+                } else {
+                    dev->integ_start_us = t;
+                    dev->phase_end_us = t + (uint64_t)atime_cycles(dev) * TCS_SIM_CYCLE_US;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    dev->now_us = now_us;
+}
+
+uint64_t TcsSim_NextEventUs(const TcsSim_Sensor_t *dev) {
+    if (dev->phase >= TCS_SIM_INIT) {
+        return dev->phase_end_us;
+    }
+    return UINT64_MAX;
+}
+
+// Zapis ENABLE - zmiana fazy pracy (WEN/ATIME dzialaja od nastepnego cyklu)
+static void write_enable(TcsSim_Sensor_t *dev, uint8_t value) {
+    dev->regs[TCS34725_ENABLE] = value & (TCS34725_ENABLE_AIEN | TCS34725_ENABLE_WEN
+                                          | TCS34725_ENABLE_AEN | TCS34725_ENABLE_PON);
+
+    if (!(value & TCS34725_ENABLE_PON)) {
+        dev->phase = TCS_SIM_SLEEP;
+    } else if (!(value & TCS34725_ENABLE_AEN)) {
+        dev->phase = TCS_SIM_IDLE;
+    } else if (dev->phase < TCS_SIM_INIT) {
+        dev->phase = TCS_SIM_INIT;
+        dev->phase_end_us = dev->now_us + TCS_SIM_INIT_US;
+    }
+    update_int_line(dev);
+}
+
+static void write_reg(TcsSim_Sensor_t *dev, uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case TCS34725_ENABLE:
+            write_enable(dev, value);
+            break;
+        case TCS34725_ATIME:
+        case TCS34725_WTIME:
+        case TCS34725_AILTL:
+        case TCS34725_AILTH:
+        case TCS34725_AIHTL:
+        case TCS34725_AIHTH:
+        case TCS34725_PERS:
+            dev->regs[reg] = value;
+            break;
+        case TCS34725_CONFIG:
+            dev->regs[reg] = value & TCS34725_CONFIG_WLONG;
+            break;
+        case TCS34725_CONTROL:
+            dev->regs[reg] = value & 0x03;
+            break;
+        default:
+            break; // Rejestry tylko do odczytu i zarezerwowane
+    }
+}
+
+uint8_t TcsSim_Write(TcsSim_Sensor_t *dev, const uint8_t *data, uint16_t len) {
+    if (len == 0) {
+        return 1;
+    }
+
+    uint8_t cmd = data[0];
+    if (!(cmd & TCS34725_COMMAND_BIT)) {
+        return 0;
+    }
+
+    uint8_t type = (cmd >> 5) & 0x03;
+    uint8_t addr = cmd & SIM_ADDR_MASK;
+
+    if (type == SIM_CMD_TYPE_SPECIAL) {
+        if (addr == TCS34725_SF_CLEAR_INT) {
+            dev->regs[TCS34725_STATUS] &= (uint8_t)~TCS34725_STATUS_AINT;
+            dev->pers_count = 0;
+            update_int_line(dev);
+        }
+        return 1;
+    }
+
+    dev->addr = addr;
+    dev->auto_inc = (type == SIM_CMD_TYPE_AUTOINC);
+
+    for (uint16_t i = 1; i < len; i++) {
+        if (dev->addr < TCS_SIM_REG_COUNT) {
+            write_reg(dev, dev->addr, data[i]);
+        }
+        if (dev->auto_inc) {
+            dev->addr++;
+        }
+    }
+    return 1;
+}
+
+uint8_t TcsSim_Read(TcsSim_Sensor_t *dev, uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = dev->addr < TCS_SIM_REG_COUNT ? dev->regs[dev->addr] : 0;
+        if (dev->auto_inc) {
+            dev->addr++;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,94 @@
+#ifndef TCS34725_SIM_H
+#define TCS34725_SIM_H
+
+// Model rejestrow TCS34725 dla symulacji na hoscie.
+// Odwzorowuje bajt komendy (powtarzanie, auto-inkrementacja, funkcje specjalne),
+// ID, ENABLE, ATIME, WTIME/WLONG, CONTROL, progi i PERS, STATUS oraz rejestry danych.
+// Czas: 2.4ms inicjalizacji po wlaczeniu AEN, integracja ATIME, opcjonalne czekanie WTIME.
+
+#include "stm32f4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCS_SIM_REG_COUNT     0x1C
+#define TCS_SIM_CYCLE_US      2400U   // Krok ATIME / WTIME
+#define TCS_SIM_INIT_US       2400U   // Inicjalizacja RGBC po ustawieniu AEN
+#define TCS_SIM_MAX_SEGMENTS  8
+
+// Natezenie swiatla w zliczeniach na jeden cykl 2.4ms przy wzmocnieniu 1x
+typedef struct {
+    float c, r, g, b;
+} TcsSim_Light_t;
+
+// Odcinek sceny - liniowe przejscie from -> to w czasie duration_ms
+typedef struct {
+    uint32_t duration_ms;
+    TcsSim_Light_t from;
+    TcsSim_Light_t to;
+} TcsSim_Segment_t;
+
+// Scena oswietlenia: kolejne odcinki, po ostatnim powtarzane od poczatku (loop)
+// lub utrzymywany jego koniec. Szum: odchylenie w promilach, deterministyczny generator.
+typedef struct {
+    const char *name;
+    TcsSim_Segment_t segments[TCS_SIM_MAX_SEGMENTS];
+    uint8_t segment_count;
+    uint8_t loop;
+    uint16_t noise_permille;
+    uint32_t seed;
+} TcsSim_Scene_t;
+
+typedef enum {
+    TCS_SIM_SLEEP,            // PON = 0
+    TCS_SIM_IDLE,             // PON = 1, AEN = 0
+    TCS_SIM_INIT,             // Inicjalizacja RGBC
+    TCS_SIM_INTEGRATING,      // Integracja ATIME
+    TCS_SIM_WAITING           // Czekanie WTIME (WEN = 1)
+} TcsSim_Phase_t;
+
+typedef struct {
+    uint8_t regs[TCS_SIM_REG_COUNT];
+    uint8_t addr;             // Wskaznik rejestru z ostatniego bajtu komendy
+    uint8_t auto_inc;         // Tryb auto-inkrementacji z ostatniego bajtu komendy
+    TcsSim_Phase_t phase;
+    uint64_t now_us;          // Czas ostatniego TcsSim_Advance
+    uint64_t phase_end_us;
+    uint64_t integ_start_us;
+    uint8_t pers_count;       // Kolejne wyniki poza progami
+    const TcsSim_Scene_t *scene;
+    uint32_t noise_state;
+    GPIO_TypeDef *int_port;   // Linia INT (aktywna niskim, otwarty dren)
+    uint16_t int_pin;
+
+    // Statystyki dla testow i pomiarow
+    uint32_t cycles;          // Zakonczone integracje
+    uint32_t saturated;       // Integracje z nasyconym kanalem C
+    uint32_t interrupts;      // Ustawienia AINT
+} TcsSim_Sensor_t;
+
+void TcsSim_Init(TcsSim_Sensor_t *dev, const TcsSim_Scene_t *scene,
+                 GPIO_TypeDef *int_port, uint16_t int_pin);
+void TcsSim_SetScene(TcsSim_Sensor_t *dev, const TcsSim_Scene_t *scene);
+TcsSim_Light_t TcsSim_SceneLight(const TcsSim_Scene_t *scene, uint64_t t_us);
+
+// Transakcje I2C (adres juz rozpoznany): 1 - ACK, 0 - NACK
+uint8_t TcsSim_Write(TcsSim_Sensor_t *dev, const uint8_t *data, uint16_t len);
+uint8_t TcsSim_Read(TcsSim_Sensor_t *dev, uint8_t *data, uint16_t len);
+
+// Przebieg stanow czujnika do chwili now_us i czas nastepnej zmiany (UINT64_MAX - brak)
+void TcsSim_Advance(TcsSim_Sensor_t *dev, uint64_t now_us);
+uint64_t TcsSim_NextEventUs(const TcsSim_Sensor_t *dev);
+
+uint16_t TcsSim_FullScale(const TcsSim_Sensor_t *dev);
+
+// Sceny wbudowane (sim_scenes.c): kolejne po indeksie (NULL za ostatnia) lub po nazwie
+const TcsSim_Scene_t* TcsSim_SceneAt(size_t index);
+const TcsSim_Scene_t* TcsSim_FindScene(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+#include "test_board.h"
+#include "protocol.h"
+#include "crc16.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_ADDR "PC1"
+#define HEADER_LEN (FIELD_ADDR_LEN * 2 + FIELD_DATA_LEN + FIELD_ID_LEN)
+
+static int failures = 0;
+
+static char rx_frame[MAX_FRAME_LEN + 1];
+static size_t rx_len = 0;
+static int awaited_id = -1;
+static uint8_t reply_ready = 0;
+static uint64_t reply_us = 0;
+static char reply_data[MAX_PAYLOAD_LEN + 1];
+static uint8_t next_id = 1;
+
+
+void Test_Check(int ok, const char *file, int line, const char *expr) {
+    if (!ok) {
+        fprintf(stderr, "%s:%d: niespelnione %s\n", file, line, expr);
+        failures++;
+    }
+}
+
+void Test_CheckEq(long long actual, long long expected, const char *file, int line, const char *expr) {
+    if (actual != expected) {
+        fprintf(stderr, "%s:%d: %s = %lld, oczekiwano %lld\n", file, line, expr, actual, expected);
+        failures++;
+    }
+}
+
+void Test_CheckRange(long long actual, long long lo, long long hi, const char *file, int line,
+                     const char *expr) {
+    if (actual < lo || actual > hi) {
+        fprintf(stderr, "%s:%d: %s = %lld, oczekiwano %lld..%lld\n", file, line, expr, actual, lo, hi);
+        failures++;
+    }
+}
+
+int Test_Main(const TestCase_t *cases, size_t count, int argc, char **argv) {
+    if (argc == 2) {
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(cases[i].name, argv[1]) == 0) {
+                cases[i].run();
+                if (failures) {
+                    fprintf(stderr, "%s: %d bledow\n", cases[i].name, failures);
+                }
+                return failures ? 1 : 0;
+            }
+        }
+    }
+    fprintf(stderr, "Uzycie: %s PRZYPADEK (", argv[0]);
+    for (size_t i = 0; i < count; i++) {
+        fprintf(stderr, "%s%s", i ? ", " : "", cases[i].name);
+    }
+    fprintf(stderr, ")\n");
+    return 2;
+}
+
+// Ramka odpowiedzi urzadzenia: & SSS RRR LLL ID dane CRC *
+static void on_frame(const char *frame, size_t len) {
+    char num[4] = { 0 };
+    if (len < MIN_FRAME_LEN || strncmp(frame + 1, DEVICE_ID, FIELD_ADDR_LEN) != 0) {
+        return;
+    }
+    memcpy(num, frame + 1 + FIELD_ADDR_LEN * 2, FIELD_DATA_LEN);
+    size_t hex_len = (size_t)atoi(num);
+    if (len != 1 + HEADER_LEN + hex_len + FIELD_CRC_LEN + 1) {
+        return;
+    }
+    char crc_hex[FIELD_CRC_LEN + 1] = { 0 };
+    memcpy(crc_hex, frame + 1 + HEADER_LEN + hex_len, FIELD_CRC_LEN);
+    if (crc16_ccitt((const uint8_t *)frame + 1, HEADER_LEN + hex_len) != strtoul(crc_hex, NULL, 16)) {
+        return;
+    }
+    char id_str[FIELD_ID_LEN + 1] = { frame[10], frame[11], 0 };
+    if (atoi(id_str) != awaited_id) {
+        return;
+    }
+
+    char hex[MAX_PAYLOAD_LEN * 2 + 1];
+    memcpy(hex, frame + 1 + HEADER_LEN, hex_len);
+    hex[hex_len] = '\0';
+    if (hex_decode_string(hex, reply_data, sizeof(reply_data)) >= 0) {
+        reply_ready = 1;
+        reply_us = SimBoard_NowUs();
+    }
+}
+
+static void on_output(const uint8_t *data, uint16_t len, void *user) {
+    (void)user;
+    for (uint16_t i = 0; i < len; i++) {
+        char ch = (char)data[i];
+        if (ch == PROTOCOL_START_BYTE) {
+            rx_len = 0;
+        }
+        if (rx_len < MAX_FRAME_LEN) {
+            rx_frame[rx_len++] = ch;
+        }
+        if (ch == PROTOCOL_END_BYTE && rx_frame[0] == PROTOCOL_START_BYTE) {
+            on_frame(rx_frame, rx_len);
+            rx_len = 0;
+        }
+    }
+}
+
+void TestBoard_Boot(const char *scene_name) {
+    const TcsSim_Scene_t *scene = TcsSim_FindScene(scene_name);
+    if (scene == NULL) {
+        fprintf(stderr, "Nieznana scena '%s'\n", scene_name);
+        exit(2);
+    }
+    SimBoard_Init(scene);
+    SimBoard_SetOutput(on_output, NULL);
+    SimBoard_Boot();
+    SimBoard_RunFor(20);
+}
+
+uint8_t TestBoard_Send(const char *payload) {
+    char frame[MAX_FRAME_LEN + 1];
+    uint8_t id = next_id;
+    next_id = next_id >= 99 ? 1 : next_id + 1;
+
+    if (!build_response_frame(frame, sizeof(frame), HOST_ADDR, DEVICE_ID, id, payload, 0)) {
+        return 0;
+    }
+    SimBoard_Send(frame, strlen(frame));
+    return id;
+}
+
+uint8_t TestBoard_WaitReply(uint8_t id, char *reply, size_t reply_size) {
+    if (id == 0) {
+        return 0;
+    }
+    awaited_id = id;
+    reply_ready = 0;
+    for (uint32_t ms = 0; ms < TEST_REPLY_TIMEOUT_MS && !reply_ready; ms++) {
+        SimBoard_RunFor(1);
+    }
+    awaited_id = -1;
+    if (!reply_ready) {
+        return 0;
+    }
+    snprintf(reply, reply_size, "%s", reply_data);
+    return 1;
+}
+
+uint8_t TestBoard_Command(const char *payload, char *reply, size_t reply_size) {
+    return TestBoard_WaitReply(TestBoard_Send(payload), reply, reply_size);
+}
+
+uint64_t TestBoard_ReplyUs(void) {
+    return reply_us;
+}
+
+void TestBoard_Expect(const char *payload, const char *expected, const char *file, int line) {
+    char reply[MAX_PAYLOAD_LEN + 1];
+    if (!TestBoard_Command(payload, reply, sizeof(reply))) {
+        fprintf(stderr, "%s:%d: %s - brak odpowiedzi\n", file, line, payload);
+        failures++;
+    } else if (strcmp(reply, expected) != 0) {
+        fprintf(stderr, "%s:%d: %s -> %s, oczekiwano %s\n", file, line, payload, reply, expected);
+        failures++;
+    }
+}
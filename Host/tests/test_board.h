@@ -0,0 +1,52 @@
+#ifndef TEST_BOARD_H
+#define TEST_BOARD_H
+
+// Wspolne narzedzia testow ctest: przypadki wybierane nazwa z linii komend
+// (kazdy w osobnym procesie - stan modulow Core jest statyczny), asercje
+// i rozmowa z symulowana plytka ramkami protokolu.
+
+#include "sim_board.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} TestCase_t;
+
+#define CHECK(cond) \
+    Test_Check((cond) != 0, __FILE__, __LINE__, #cond)
+#define CHECK_EQ(actual, expected) \
+    Test_CheckEq((long long)(actual), (long long)(expected), __FILE__, __LINE__, #actual)
+#define CHECK_RANGE(actual, lo, hi) \
+    Test_CheckRange((long long)(actual), (long long)(lo), (long long)(hi), __FILE__, __LINE__, #actual)
+
+void Test_Check(int ok, const char *file, int line, const char *expr);
+void Test_CheckEq(long long actual, long long expected, const char *file, int line, const char *expr);
+void Test_CheckRange(long long actual, long long lo, long long hi, const char *file, int line,
+                     const char *expr);
+int Test_Main(const TestCase_t *cases, size_t count, int argc, char **argv);
+
+#define TEST_MAIN(cases) \
+    int main(int argc, char **argv) { \
+        return Test_Main(cases, sizeof(cases) / sizeof(cases[0]), argc, argv); \
+    }
+
+// Plytka ze scena o podanej nazwie po rozruchu (czujniki skonfigurowane)
+void TestBoard_Boot(const char *scene_name);
+// Komenda w ramce protokolu i odpowiedz z tym samym frame_id (dane zdekodowane).
+// Zwraca 0, gdy odpowiedz nie nadeszla w TEST_REPLY_TIMEOUT_MS czasu symulacji.
+#define TEST_REPLY_TIMEOUT_MS  500
+uint8_t TestBoard_Command(const char *payload, char *reply, size_t reply_size);
+// To samo w dwoch krokach - kilka ramek moze czekac w buforze RX plytki.
+// TestBoard_Send zwraca frame_id (0 - blad), symulacja rusza dopiero w TestBoard_WaitReply.
+uint8_t TestBoard_Send(const char *payload);
+uint8_t TestBoard_WaitReply(uint8_t id, char *reply, size_t reply_size);
+// Chwila symulacji, w ktorej nadeszla ostatnia oczekiwana odpowiedz
+uint64_t TestBoard_ReplyUs(void);
+// Komenda, ktorej odpowiedzia ma byc dokladnie expected
+void TestBoard_Expect(const char *payload, const char *expected, const char *file, int line);
+#define EXPECT_REPLY(payload, expected) \
+    TestBoard_Expect(payload, expected, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,425 @@
+// Klient PC (Client, Device) na symulowanej plytce przez socketpair: dopasowanie
+// odpowiedzi po frame_id, retransmisje po przekroczeniu czasu i WRCHSUM, komendy
+// bez powtorzen, bledy bez frame_id oraz parsery odpowiedzi.
+
+#include "tcs_device.h"
+
+extern "C" {
+#include "test_board.h"
+#include "timesync.h"
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kTimeoutMs = 40;          // Na probe - kilkadziesiat krokow symulacji
+
+// Linia miedzy klientem a plytka. Kazde pump() to 1 ms symulacji; ramki odpowiedzi
+// moga byc wstrzymane i wypuszczone w odwrotnej kolejnosci lub po czasie.
+class Line {
+public:
+    Line() {
+        int fds[2];
+        CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+        client_fd = fds[0];
+        board_fd_ = fds[1];
+        SimBoard_SetOutput(on_output, this);
+    }
+
+    ~Line() {
+        close(client_fd);
+        close(board_fd_);
+    }
+
+    void pump() {
+        char buf[512];
+        ssize_t n;
+        while ((n = read(board_fd_, buf, sizeof(buf))) > 0) {
+            frames_to_board += static_cast<unsigned>(std::count(buf, buf + n, PROTOCOL_START_BYTE));
+            SimBoard_Send(buf, static_cast<size_t>(n));
+        }
+        SimBoard_RunFor(1);
+        if (held_.size() >= hold_count || release_) {
+            for (auto it = held_.rbegin(); it != held_.rend(); ++it) {
+                write_board(*it);
+            }
+            held_.clear();
+            hold_count = 0;
+            release_ = false;
+        }
+    }
+
+    // Kolejne count ramek wstrzymane i wyslane razem, ostatnia pierwsza
+    void hold_reversed(size_t count) { hold_count = count; }
+    void release() { release_ = true; }
+    size_t held() const { return held_.size(); }
+
+    int client_fd = -1;
+    unsigned frames_to_board = 0;
+
+private:
+    static void on_output(const uint8_t *data, uint16_t len, void *user) {
+        Line *line = static_cast<Line *>(user);
+        for (uint16_t i = 0; i < len; i++) {
+            char ch = static_cast<char>(data[i]);
+            line->partial_.push_back(ch);
+            if (ch != PROTOCOL_END_BYTE) {
+                continue;
+            }
+            if (line->hold_count > 0) {
+                line->held_.push_back(line->partial_);
+            } else {
+                line->write_board(line->partial_);
+            }
+            line->partial_.clear();
+        }
+    }
+
+    void write_board(const std::string &frame) {
+        CHECK(write(board_fd_, frame.data(), frame.size()) == static_cast<ssize_t>(frame.size()));
+    }
+
+    int board_fd_ = -1;
+    size_t hold_count = 0;
+    bool release_ = false;
+    std::string partial_;
+    std::vector<std::string> held_;
+};
+
+tcs::ClientOptions test_options() {
+    tcs::ClientOptions options;
+    options.timeout_ms = kTimeoutMs;
+    return options;
+}
+
+void run(tcs::Client &client, Line &line) {
+    for (int i = 0; i < 5000 && client.pending() > 0; i++) {
+        client.poll(0);
+        line.pump();
+        client.poll(1);
+    }
+    CHECK_EQ(client.pending(), 0);
+}
+
+template <typename T, typename Start>
+tcs::Result<T> call(tcs::Client &client, Line &line, Start start) {
+    tcs::Result<T> result;
+    start([&](const tcs::Result<T> &r) { result = r; });
+    run(client, line);
+    return result;
+}
+
+// Trzy zapytania w locie, odpowiedzi wracaja od ostatniej: kazda trafia do swojego
+// zapytania po frame_id
+void test_out_of_order() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+
+    std::vector<int> order;
+    tcs::Result<uint32_t> interval;
+    tcs::Result<uint16_t> window;
+    tcs::Result<std::vector<uint8_t>> sensors;
+    line.hold_reversed(3);
+    dev.get_interval([&](const tcs::Result<uint32_t> &r) { interval = r; order.push_back(0); });
+    dev.get_window([&](const tcs::Result<uint16_t> &r) { window = r; order.push_back(1); });
+    dev.get_sensors([&](const tcs::Result<std::vector<uint8_t>> &r) { sensors = r; order.push_back(2); });
+    run(client, line);
+
+    CHECK(order == std::vector<int>({ 2, 1, 0 }));
+    CHECK(interval.ok());
+    CHECK_EQ(interval.value, 1000);
+    CHECK(window.ok());
+    CHECK(sensors.ok());
+    CHECK(!sensors.value.empty());
+    CHECK_EQ(client.stats().replies, 3);
+    CHECK_EQ(client.stats().unmatched, 0);
+    CHECK_EQ(client.stats().retransmits, 0);
+}
+
+// Ramka zgubiona na linii: retransmisja po timeout_ms; bez odpowiedzi na zadna
+// z prob - Timeout po max_retries powtorzeniach
+void test_retransmit_timeout() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+    bool drop_all = false;
+    client.on_transmit([&](std::string &frame, uint8_t attempt) {
+        if (attempt == 0 || drop_all) {
+            frame.clear();
+        }
+    });
+
+    auto r = call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_interval(2000, cb); });
+    CHECK(r.ok());
+    CHECK_EQ(r.attempts, 2);
+    CHECK_EQ(line.frames_to_board, 1);
+    CHECK_EQ(client.stats().retransmits, 1);
+    CHECK_RANGE(r.latency_us, kTimeoutMs * 1000, kTimeoutMs * 1000 * 20);
+
+    auto interval = call<uint32_t>(client, line, [&](tcs::Callback<uint32_t> cb) { dev.get_interval(cb); });
+    CHECK_EQ(interval.value, 2000);
+
+    drop_all = true;
+    interval = call<uint32_t>(client, line, [&](tcs::Callback<uint32_t> cb) { dev.get_interval(cb); });
+    CHECK(interval.status == tcs::Status::Timeout);
+    CHECK_EQ(interval.attempts, client.options().max_retries + 1);
+    CHECK_EQ(client.stats().timeouts, 1);
+}
+
+// Znieksztalcony CRC: urzadzenie odpowiada WRCHSUM z tym samym frame_id, klient
+// powtarza od razu - rowniez komendy bez retransmisji po czasie
+void test_wrchsum_retry() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+    bool corrupt_all = false;
+    client.on_transmit([&](std::string &frame, uint8_t attempt) {
+        if (attempt == 0 || corrupt_all) {
+            char &digit = frame[frame.size() - 2];
+            digit = digit == '0' ? '1' : '0';
+        }
+    });
+
+    auto r = call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_window(20, cb); });
+    CHECK(r.ok());
+    CHECK_EQ(r.attempts, 2);
+    CHECK(r.latency_us < kTimeoutMs * 1000);
+
+    auto sync = call<tcs::TimeSyncState>(client, line, [&](tcs::Callback<tcs::TimeSyncState> cb) {
+        dev.time_sync(1700000000000000ULL, 0, cb);
+    });
+    CHECK(sync.ok());
+    CHECK_EQ(sync.attempts, 2);
+
+    corrupt_all = true;
+    auto window = call<uint16_t>(client, line, [&](tcs::Callback<uint16_t> cb) { dev.get_window(cb); });
+    CHECK(window.status == tcs::Status::DeviceError);
+    CHECK(window.error == WRCHSUM);
+    CHECK_EQ(window.attempts, client.options().max_retries + 1);
+    CHECK_EQ(line.frames_to_board, 2 + 2 + window.attempts);
+    CHECK_EQ(client.stats().timeouts, 0);
+}
+
+// TIMESYNC i PROFILE bez odpowiedzi w czasie: jedna ramka, Timeout, a spozniona
+// odpowiedz jest liczona jako niedopasowana
+void test_no_resend() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+    client.on_transmit([&](std::string &frame, uint8_t) { frame.clear(); });
+
+    auto sync = call<tcs::TimeSyncState>(client, line, [&](tcs::Callback<tcs::TimeSyncState> cb) {
+        dev.time_sync(1700000000000000ULL, 0, cb);
+    });
+    CHECK(sync.status == tcs::Status::Timeout);
+    CHECK_EQ(sync.attempts, 1);
+    auto profile = call<tcs::SiteProfile>(client, line, [&](tcs::Callback<tcs::SiteProfile> cb) {
+        dev.read_profile(0, cb);
+    });
+    CHECK(profile.status == tcs::Status::Timeout);
+    CHECK_EQ(profile.attempts, 1);
+    CHECK_EQ(client.stats().retransmits, 0);
+    CHECK_EQ(line.frames_to_board, 0);
+    CHECK_EQ(TimeSync_GetSource(), TIMESYNC_NONE);
+
+    // Ramka dochodzi, odpowiedz wstrzymana ponad timeout_ms: TIMESYNC wykonany raz
+    client.on_transmit(nullptr);
+    line.hold_reversed(2);
+    sync = call<tcs::TimeSyncState>(client, line, [&](tcs::Callback<tcs::TimeSyncState> cb) {
+        dev.time_sync(1700000000000000ULL, 0, cb);
+    });
+    CHECK(sync.status == tcs::Status::Timeout);
+    CHECK_EQ(line.frames_to_board, 1);
+    CHECK_EQ(line.held(), 1);
+    // Klient czyta port tylko z zapytaniem w locie
+    line.release();
+    CHECK(call<uint32_t>(client, line, [&](tcs::Callback<uint32_t> cb) { dev.get_interval(cb); }).ok());
+    CHECK_EQ(client.stats().unmatched, 1);
+    CHECK_EQ(client.stats().retransmits, 0);
+}
+
+// WRFRM na ramke z nieczytelnym frame_id przychodzi z numerem 0: trafia do on_error,
+// nie do on_event, a zapytanie konczy retransmisja. EVT nadal do on_event.
+void test_error_without_id() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+    std::vector<ErrorCode> errors;
+    std::vector<std::string> events;
+    client.on_error([&](ErrorCode code, const tcs::Frame &) { errors.push_back(code); });
+    client.on_event([&](const tcs::Frame &frame) { events.push_back(frame.data); });
+    client.on_transmit([&](std::string &frame, uint8_t attempt) {
+        if (attempt == 0) {
+            frame[10] = 'X';
+            frame[11] = 'X';
+        }
+    });
+
+    auto r = call<uint32_t>(client, line, [&](tcs::Callback<uint32_t> cb) { dev.get_interval(cb); });
+    CHECK(r.ok());
+    CHECK_EQ(r.attempts, 2);
+    CHECK(errors == std::vector<ErrorCode>({ WRFRM }));
+    CHECK(events.empty());
+    CHECK_EQ(client.stats().device_errors, 1);
+    CHECK_EQ(client.stats().events, 0);
+
+    client.on_transmit(nullptr);
+    tcs::Trigger trigger;
+    trigger.type = 'A';
+    trigger.channel = 'C';
+    trigger.threshold = 1;
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_trigger(trigger, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.start(cb); }).ok());
+    // EVT odbierane w trakcie zapytan - bez nich poll() nie czyta portu
+    for (int i = 0; i < 5000 && events.empty(); i++) {
+        if (client.pending() == 0) {
+            dev.get_interval(nullptr);
+        }
+        client.poll(0);
+        line.pump();
+    }
+    CHECK(!events.empty());
+    CHECK(!events.empty() && events[0].compare(0, sizeof(EVT_PREFIX) - 1, EVT_PREFIX) == 0);
+    CHECK_EQ(errors.size(), 1);
+}
+
+// Odpowiedzi plytki przez parsery Device - wartosci wpisane komendami SET wracaja
+// w polach struktur
+void test_parse_replies() {
+    TestBoard_Boot("office");
+    Line line;
+    tcs::Client client(line.client_fd, test_options());
+    tcs::Device dev(client);
+
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_interval(500, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_gain(0, 2, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_time(0, 1, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_window(8, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_format(0x0F, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) {
+        dev.set_oversample(0, 3, true, cb);
+    }).ok());
+    tcs::Trigger trigger;
+    trigger.index = 1;
+    trigger.type = 'R';
+    trigger.channel = 'G';
+    trigger.threshold = 1234;
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.set_trigger(trigger, cb); }).ok());
+    CHECK(call<tcs::Done>(client, line, [&](tcs::Callback<tcs::Done> cb) { dev.start(cb); }).ok());
+    SimBoard_RunFor(3000);
+
+    CHECK_EQ(call<uint32_t>(client, line, [&](tcs::Callback<uint32_t> cb) { dev.get_interval(cb); }).value, 500);
+    CHECK_EQ(call<uint8_t>(client, line, [&](tcs::Callback<uint8_t> cb) { dev.get_gain(0, cb); }).value, 2);
+    CHECK_EQ(call<uint8_t>(client, line, [&](tcs::Callback<uint8_t> cb) { dev.get_time(0, cb); }).value, 1);
+    CHECK_EQ(call<uint16_t>(client, line, [&](tcs::Callback<uint16_t> cb) { dev.get_window(cb); }).value, 8);
+    CHECK_EQ(call<uint8_t>(client, line, [&](tcs::Callback<uint8_t> cb) { dev.get_format(cb); }).value, 0x0F);
+
+    auto ovs = call<tcs::Oversample>(client, line, [&](tcs::Callback<tcs::Oversample> cb) { dev.get_oversample(0, cb); });
+    CHECK(ovs.ok());
+    CHECK_EQ(ovs.value.count, 3);
+    CHECK(ovs.value.keep_spread);
+
+    auto trg = call<tcs::Trigger>(client, line, [&](tcs::Callback<tcs::Trigger> cb) { dev.get_trigger(1, cb); });
+    CHECK(trg.ok());
+    CHECK_EQ(trg.value.type, 'R');
+    CHECK_EQ(trg.value.channel, 'G');
+    CHECK_EQ(trg.value.threshold, 1234);
+
+    auto raw = call<tcs::Sample>(client, line, [&](tcs::Callback<tcs::Sample> cb) { dev.read_raw(0, cb); });
+    CHECK(raw.ok());
+    CHECK(raw.value.has_raw && raw.value.has_spread && raw.value.has_lux && raw.value.has_cct);
+    CHECK(raw.value.c > 0);
+    auto arc = call<tcs::Sample>(client, line, [&](tcs::Callback<tcs::Sample> cb) { dev.read_archive_us(0, 1000, cb); });
+    CHECK(arc.ok());
+    CHECK(arc.value.has_timestamp);
+    CHECK_RANGE(arc.value.timestamp_us, 1, SimBoard_NowUs());
+
+    auto stats = call<tcs::WindowStats>(client, line, [&](tcs::Callback<tcs::WindowStats> cb) { dev.read_stats(0, cb); });
+    CHECK(stats.ok());
+    CHECK_EQ(stats.value.window, 8);
+    CHECK(stats.value.count > 0);
+    CHECK(stats.value.channels[3].min <= stats.value.channels[3].mean);
+    CHECK(stats.value.channels[3].mean <= stats.value.channels[3].max);
+
+    CHECK(call<tcs::Lux>(client, line, [&](tcs::Callback<tcs::Lux> cb) { dev.read_lux(0, cb); }).ok());
+    CHECK(call<tcs::AutoGain>(client, line, [&](tcs::Callback<tcs::AutoGain> cb) { dev.get_auto(0, cb); }).ok());
+    CHECK(call<tcs::Duty>(client, line, [&](tcs::Callback<tcs::Duty> cb) { dev.get_duty(cb); }).ok());
+    CHECK(call<tcs::ClockInfo>(client, line, [&](tcs::Callback<tcs::ClockInfo> cb) { dev.get_clock(cb); }).ok());
+    CHECK(call<tcs::SiteProfile>(client, line, [&](tcs::Callback<tcs::SiteProfile> cb) { dev.read_profile(0, cb); }).ok());
+    CHECK(call<tcs::TracePage>(client, line, [&](tcs::Callback<tcs::TracePage> cb) { dev.read_trace(0, cb); }).ok());
+
+    auto tasks = call<std::vector<tcs::TaskStats>>(client, line, [&](tcs::Callback<std::vector<tcs::TaskStats>> cb) {
+        dev.get_tasks(cb);
+    });
+    CHECK(tasks.ok() && !tasks.value.empty());
+    auto irqs = call<std::vector<tcs::IrqStats>>(client, line, [&](tcs::Callback<std::vector<tcs::IrqStats>> cb) {
+        dev.get_irqs(cb);
+    });
+    CHECK(irqs.ok() && !irqs.value.empty());
+    auto counters = call<tcs::CounterSnapshot>(client, line, [&](tcs::Callback<tcs::CounterSnapshot> cb) {
+        dev.read_counters(cb);
+    });
+    CHECK(counters.ok() && !counters.value.values.empty());
+
+    auto sync = call<tcs::TimeSyncState>(client, line, [&](tcs::Callback<tcs::TimeSyncState> cb) {
+        dev.time_sync(1700000000000000ULL, 0, cb);
+    });
+    CHECK(sync.ok());
+    CHECK_EQ(client.stats().unmatched, 0);
+    CHECK_EQ(client.stats().bad_frames, 0);
+}
+
+// parse_sample na danych spoza plytki: pola w dowolnej kolejnosci, bledy formatu
+void test_parse_sample() {
+    tcs::Sample s;
+    CHECK(tcs::Device::parse_sample(RESP_ANS_PREFIX "R00001G00002B00003C00004V00005L00000123K03000"
+                                    "E1700000000000001T0000000012000345", s));
+    CHECK(s.has_raw && s.has_spread && s.has_lux && s.has_cct && s.has_epoch && s.has_timestamp);
+    CHECK_EQ(s.r, 1);
+    CHECK_EQ(s.g, 2);
+    CHECK_EQ(s.b, 3);
+    CHECK_EQ(s.c, 4);
+    CHECK_EQ(s.spread, 5);
+    CHECK_EQ(s.lux_x100, 123);
+    CHECK_EQ(s.cct, 3000);
+    CHECK_EQ(s.epoch_us, 1700000000000001ULL);
+    CHECK_EQ(s.timestamp_us, 12000345ULL);
+
+    CHECK(tcs::Device::parse_sample(RESP_ANS_PREFIX "K04500R00010G00020B00030C00040", s));
+    CHECK(s.has_raw && s.has_cct && !s.has_lux && !s.has_timestamp);
+    CHECK_EQ(s.cct, 4500);
+    CHECK(tcs::Device::parse_sample(RESP_ANS_PREFIX, s));
+    CHECK(!s.has_raw);
+
+    CHECK(!tcs::Device::parse_sample("R00001G00002B00003C00004", s));
+    CHECK(!tcs::Device::parse_sample(RESP_ANS_PREFIX "R00001G00002B00003", s));
+    CHECK(!tcs::Device::parse_sample(RESP_ANS_PREFIX "R0000AG00002B00003C00004", s));
+    CHECK(!tcs::Device::parse_sample(RESP_ANS_PREFIX "V0005", s));
+    CHECK(!tcs::Device::parse_sample(RESP_ANS_PREFIX "X00001", s));
+}
+
+const TestCase_t cases[] = {
+    { "out_of_order", test_out_of_order },
+    { "retransmit_timeout", test_retransmit_timeout },
+    { "wrchsum_retry", test_wrchsum_retry },
+    { "no_resend", test_no_resend },
+    { "error_without_id", test_error_without_id },
+    { "parse_replies", test_parse_replies },
+    { "parse_sample", test_parse_sample },
+};
+
+}  // namespace
+
+TEST_MAIN(cases)
@@ -0,0 +1,144 @@
+// ColorCalc_Compute wobec wzorow TAOS DN40 liczonych w double: wszystkie wzmocnienia
+// i czasy integracji, probki losowe i brzegowe. Blad nie wieksze niz krok zaokraglenia
+// wyniku - 0.005 lx i 0.5 K.
+
+#include "test_board.h"
+#include "color_calc.h"
+#include "protocol.h"
+#include <math.h>
+#include <stdio.h>
+
+#define RANDOM_SAMPLES   100000U     // Na kazda pare wzmocnienie / czas integracji
+#define LUX_MAX_ERROR    (0.005 + 1e-6)
+#define CCT_MAX_ERROR    (0.5 + 1e-6)
+
+static const double REF_GAIN[GAIN_VALUES_COUNT] = { 1.0, 4.0, 16.0, 60.0 };
+
+static double max_lux_error = 0.0;
+static double max_cct_error = 0.0;
+static uint32_t compared = 0;
+
+static uint32_t lcg_state = 12345U;
+
+static uint32_t lcg_next(uint32_t range) {
+    lcg_state = lcg_state * 1664525U + 1013904223U;
+    return (uint32_t)(((uint64_t)(lcg_state >> 8) * range) >> 24);
+}
+
+// DN40: IR = (R+G+B-C)/2, G'' = 0.136R' + G' - 0.444B', lux = G'' * DF / (ATIME_ms * AGAINx),
+// CCT = CT_COEF * B'/R' + CT_OFFSET. Zwraca 0, gdy CCT nieokreslone (R' <= 0).
+static uint8_t reference(const TCS34725_Data_t *d, uint8_t gain_index, uint8_t time_index,
+                         double *lux, double *cct) {
+    double ir = ((double)d->r + d->g + d->b - d->c) / 2.0;
+    if (ir < 0.0) {
+        ir = 0.0;
+    }
+    double r = d->r - ir;
+    double g = d->g - ir;
+    double b = d->b - ir;
+    double g2 = 0.136 * r + 1.0 * g - 0.444 * b;
+    double atime_ms = 2.4 * (256 - (TIME_TABLE[time_index] & 0xFF));
+
+    *lux = g2 > 0.0 ? g2 * 310.0 / (atime_ms * REF_GAIN[gain_index]) : 0.0;
+    if (r <= 0.0) {
+        return 0;
+    }
+    *cct = 3810.0 * (b > 0.0 ? b : 0.0) / r + 1391.0;
+    return 1;
+}
+
+static void compare(const TCS34725_Data_t *d, uint8_t gain_index, uint8_t time_index) {
+    ColorCalc_Result_t result;
+    double lux, cct;
+    uint8_t cct_valid = reference(d, gain_index, time_index, &lux, &cct);
+
+    if (!ColorCalc_Compute(d, gain_index, time_index, &result)) {
+        fprintf(stderr, "C=%u R=%u G=%u B=%u g%u t%u: odrzucona probka ponizej pelnej skali\n",
+                d->c, d->r, d->g, d->b, gain_index, time_index);
+        CHECK(0);
+        return;
+    }
+    compared++;
+
+    // Wartosci poza zakresem odpowiedzi sa obcinane do *_INVALID
+    if (result.lux_x100 == LUX_INVALID) {
+        CHECK(lux * 100.0 >= LUX_INVALID - 0.5);
+    } else {
+        double err = fabs(result.lux_x100 / 100.0 - lux);
+        if (err > max_lux_error) {
+            max_lux_error = err;
+        }
+    }
+    if (!cct_valid) {
+        CHECK_EQ(result.cct, CCT_INVALID);
+    } else if (result.cct == CCT_INVALID) {
+        CHECK(cct >= CCT_INVALID - 0.5);
+    } else {
+        double err = fabs((double)result.cct - cct);
+        if (err > max_cct_error) {
+            max_cct_error = err;
+        }
+    }
+}
+
+static void compare_channels(uint16_t c, uint16_t r, uint16_t g, uint16_t b,
+                             uint8_t gain_index, uint8_t time_index) {
+    TCS34725_Data_t d = { .c = c, .r = r, .g = g, .b = b };
+    compare(&d, gain_index, time_index);
+}
+
+static void test_dn40_reference(void) {
+    for (uint8_t t = 0; t < TIME_VALUES_COUNT; t++) {
+        uint32_t full = ColorCalc_FullScale(t);
+        for (uint8_t gi = 0; gi < GAIN_VALUES_COUNT; gi++) {
+            // Brzegi: ciemnosc, sam kanal C, R'=0 i G''<=0, tuz pod pelna skala
+            compare_channels(0, 0, 0, 0, gi, t);
+            compare_channels(1, 0, 0, 0, gi, t);
+            compare_channels(100, 0, 50, 50, gi, t);
+            compare_channels(100, 10, 10, 200, gi, t);
+            compare_channels(100, 200, 10, 10, gi, t);
+            compare_channels((uint16_t)(full - 1), (uint16_t)(full - 1), (uint16_t)(full - 1),
+                             (uint16_t)(full - 1), gi, t);
+            compare_channels((uint16_t)(full - 1), (uint16_t)(full / 3), (uint16_t)(full / 3),
+                             (uint16_t)(full / 3), gi, t);
+
+            // Losowe RGB wokol C (rowniez suma ponizej C - bez kompensacji IR)
+            for (uint32_t i = 0; i < RANDOM_SAMPLES; i++) {
+                uint32_t c = lcg_next(full);
+                uint32_t span = c / 2 + 2;
+                compare_channels((uint16_t)c, (uint16_t)lcg_next(span), (uint16_t)lcg_next(span),
+                                 (uint16_t)lcg_next(span), gi, t);
+            }
+        }
+    }
+
+    printf("%lu probek: max blad %.6f lx, %.6f K\n", (unsigned long)compared,
+           max_lux_error, max_cct_error);
+    CHECK(max_lux_error <= LUX_MAX_ERROR);
+    CHECK(max_cct_error <= CCT_MAX_ERROR);
+}
+
+// Kanal C od pelnej skali: wynik niewiarygodny, pola *_INVALID
+static void test_saturation(void) {
+    for (uint8_t t = 0; t < TIME_VALUES_COUNT; t++) {
+        uint32_t full = ColorCalc_FullScale(t);
+        for (uint8_t gi = 0; gi < GAIN_VALUES_COUNT; gi++) {
+            TCS34725_Data_t d = { .c = (uint16_t)full, .r = 100, .g = 100, .b = 100 };
+            ColorCalc_Result_t result;
+            CHECK_EQ(ColorCalc_Compute(&d, gi, t, &result), 0);
+            CHECK_EQ(result.lux_x100, LUX_INVALID);
+            CHECK_EQ(result.cct, CCT_INVALID);
+        }
+    }
+    TCS34725_Data_t d = { .c = 100, .r = 50, .g = 50, .b = 50 };
+    ColorCalc_Result_t result;
+    CHECK_EQ(ColorCalc_Compute(&d, GAIN_VALUES_COUNT, 0, &result), 0);
+    CHECK_EQ(ColorCalc_Compute(&d, 0, TIME_VALUES_COUNT, &result), 0);
+}
+
+static const TestCase_t cases[] = {
+    { "dn40_reference", test_dn40_reference },
+    { "saturation", test_saturation },
+};
+
+TEST_MAIN(cases)
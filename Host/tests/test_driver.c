@@ -0,0 +1,241 @@
+// Sterownik TCS34725 na symulowanej plytce: rozruch, rytm probkowania,
+// blad I2C z odblokowaniem magistrali i kolejnosc zakonczen transakcji DMA.
+
+#include "test_board.h"
+#include "circular_buffer.h"
+#include "protocol.h"
+
+#define MAX_SAMPLES 256
+
+static uint64_t sample_us[MAX_SAMPLES];     // Znaczniki czasu kolejnych probek archiwum
+static uint8_t sample_gain[MAX_SAMPLES];    // Ustawienia zapisane z probka
+static uint8_t sample_time[MAX_SAMPLES];
+static uint32_t sample_count = 0;
+static uint64_t last_sample_us = 0;         // Ostatnia probka widziana w archiwum
+static uint32_t states_seen = 0;            // Maska (1 << TCS_State_t) stanow czujnika 0
+static uint64_t ready_us = 0;               // Pierwsze przejscie do READY
+static uint8_t change_armed = 0;            // Zmiana ustawien przy najblizszym odczycie danych
+static uint32_t change_sample = 0;          // Liczba probek w chwili zmiany
+
+static void on_event(void *user) {
+    ColorBufferEntry_t entry;
+    (void)user;
+
+    states_seen |= 1U << tcs_sensors[0].state;
+    if (ready_us == 0 && tcs_sensors[0].state == TCS_STATE_READY) {
+        ready_us = SimBoard_NowUs();
+    }
+    if (ColorBuffer_ReadLatest(0, &entry) && entry.timestamp_us != last_sample_us) {
+        last_sample_us = entry.timestamp_us;
+        if (sample_count < MAX_SAMPLES) {
+            sample_gain[sample_count] = entry.gain_index;
+            sample_time[sample_count] = entry.time_index;
+            sample_us[sample_count++] = entry.timestamp_us;
+        }
+    }
+    if (change_armed && tcs_sensors[0].state == TCS_STATE_BUSY) {
+        change_armed = 0;
+        change_sample = sample_count;
+        CHECK_EQ(TCS34725_SetGain(0, 2), HAL_OK);
+        CHECK_EQ(TCS34725_SetTime(0, 2), HAL_OK);
+    }
+}
+
+// Plytka z rejestratorem zdarzen od pierwszej chwili symulacji
+static void boot_recorded(void) {
+    SimBoard_SetEventHook(on_event, NULL);
+    TestBoard_Boot("office");
+}
+
+static void start_sampling(const char *interval) {
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY(interval, RESP_OK);
+    EXPECT_REPLY("START", RESP_OK);
+}
+
+// Odczyt ID, konfiguracja ATIME/CONTROL/ENABLE i 3ms rozruchu oscylatora
+static void test_init(void) {
+    boot_recorded();
+    TcsSim_Sensor_t *dev = SimBoard_Sensor(0);
+
+    CHECK_EQ(tcs_sensors[0].state, TCS_STATE_READY);
+    CHECK(states_seen & (1U << TCS_STATE_POWERUP_WAIT));
+    CHECK_RANGE(ready_us, 3000, 10000);
+    CHECK_EQ(dev->regs[TCS34725_ATIME], TIME_TABLE[TCS_DEFAULT_TIME_INDEX] & 0xFF);
+    CHECK_EQ(dev->regs[TCS34725_CONTROL], GAIN_TABLE[TCS_DEFAULT_GAIN_INDEX]);
+    CHECK_EQ(dev->regs[TCS34725_ENABLE] & (TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN),
+             TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+    CHECK_EQ(SimBoard_Bus(0)->errors, 0);
+    CHECK_EQ(sample_count, 0);
+}
+
+// SETINT00100 z timera: 20 probek w 2s, odstepy 100ms z dokladnoscia do drgan magistrali
+static void test_cadence(void) {
+    boot_recorded();
+    start_sampling("SETINT00100");
+    sample_count = 0;
+    SimBoard_RunFor(2000);
+
+    CHECK_RANGE(sample_count, 19, 20);
+    for (uint32_t i = 1; i < sample_count; i++) {
+        CHECK_RANGE(sample_us[i] - sample_us[i - 1], 99500, 100500);
+    }
+    CHECK_EQ(SimBoard_Bus(0)->errors, 0);
+}
+
+// Tryb INT: do ok. 7.37s odstep odmierza czujnik (WTIME/WLONG, bez TIM2), dluzszy
+// przechodzi na TIM2 z wylaczonym przerwaniem czujnika zamiast obcinac odstep
+static void test_int_long_interval(void) {
+    boot_recorded();
+    EXPECT_REPLY("SETSRC1", RESP_OK);
+    EXPECT_REPLY("SETINT05000", RESP_OK);
+    EXPECT_REPLY("START", RESP_OK);
+    sample_count = 0;
+    SimBoard_RunFor(20000);
+
+    CHECK_RANGE(sample_count, 3, 4);
+    for (uint32_t i = 1; i < sample_count; i++) {
+        CHECK_RANGE(sample_us[i] - sample_us[i - 1], 4990000, 5010000);
+    }
+    CHECK_EQ(SimBoard_TimerInterrupts(), 0);
+    CHECK(SimBoard_Sensor(0)->regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN);
+
+    EXPECT_REPLY("SETINT20000", RESP_OK);
+    SimBoard_RunFor(7000);
+    sample_count = 0;
+    SimBoard_RunFor(60000);
+
+    CHECK_EQ(sample_count, 3);
+    for (uint32_t i = 1; i < sample_count; i++) {
+        CHECK_RANGE(sample_us[i] - sample_us[i - 1], 19999000, 20001000);
+    }
+    CHECK_EQ(SimBoard_TimerInterrupts(), 3);
+    CHECK_EQ(SimBoard_Sensor(0)->regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN, 0);
+
+    // Powrot do odstepu w zasiegu czujnika - TIM2 zatrzymany, znowu linia INT
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    SimBoard_RunFor(21000);
+    uint32_t interrupts = SimBoard_TimerInterrupts();
+    sample_count = 0;
+    SimBoard_RunFor(5000);
+    CHECK_EQ(SimBoard_TimerInterrupts(), interrupts);
+    CHECK_RANGE(sample_count, 4, 5);
+    CHECK(SimBoard_Sensor(0)->regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN);
+}
+
+// NACK w trakcie probkowania: stan RECOVERY, jedno odblokowanie, ponowna konfiguracja
+// i dalsze probki z tymi samymi ustawieniami
+static void test_i2c_recovery(void) {
+    boot_recorded();
+    start_sampling("SETINT00100");
+    SimBoard_RunFor(500);
+
+    states_seen = 0;
+    SimBus_InjectErrors(SimBoard_Bus(0), 1);
+    SimBoard_RunFor(300);
+    CHECK(states_seen & (1U << TCS_STATE_RECOVERY));
+    CHECK_EQ(SimBoard_Bus(0)->errors, 1);
+    CHECK_EQ(tcs_recovery_count, 1);
+
+    sample_count = 0;
+    SimBoard_RunFor(1000);
+    CHECK_EQ(tcs_sensors[0].state, TCS_STATE_READY);
+    CHECK_RANGE(sample_count, 9, 10);
+    CHECK_EQ(SimBoard_Sensor(0)->regs[TCS34725_ATIME], TIME_TABLE[1] & 0xFF);
+    CHECK_EQ(tcs_recovery_count, 1);
+}
+
+// Zmiana wzmocnienia i czasu w trakcie odczytu danych: probka w drodze zostaje opisana
+// starymi ustawieniami, kolejne nowymi. GETGAIN/GETTIME od razu zwracaja nowe.
+static void test_settings_apply(void) {
+    boot_recorded();
+    start_sampling("SETINT00200");
+    SimBoard_RunFor(500);
+
+    sample_count = 0;
+    change_armed = 1;
+    SimBoard_RunFor(1000);
+    CHECK(!change_armed);
+    EXPECT_REPLY("GETGAIN", GAIN_PREFIX "2");
+    EXPECT_REPLY("GETTIME", TIME_PREFIX "2");
+    CHECK_EQ(SimBoard_Sensor(0)->regs[TCS34725_CONTROL], GAIN_TABLE[2]);
+    CHECK_EQ(SimBoard_Sensor(0)->regs[TCS34725_ATIME], TIME_TABLE[2] & 0xFF);
+
+    CHECK(sample_count > change_sample + 1);
+    for (uint32_t i = 0; i < sample_count; i++) {
+        uint8_t changed = i > change_sample;
+        CHECK_EQ(sample_gain[i], changed ? 2 : TCS_DEFAULT_GAIN_INDEX);
+        CHECK_EQ(sample_time[i], changed ? 2 : 1);
+    }
+    CHECK_EQ(tcs_sensors[0].gain_applied, 2);
+    CHECK_EQ(tcs_sensors[0].time_applied, 2);
+}
+
+#define ORDER_XFERS 4
+
+static uint8_t order_tag[ORDER_XFERS];
+static uint8_t order_value[ORDER_XFERS];
+static uint64_t order_us[ORDER_XFERS];
+static uint8_t order_count = 0;
+
+static void record_xfer(uint8_t tag, TCS34725_Xfer_t *xfer) {
+    if (order_count < ORDER_XFERS) {
+        order_tag[order_count] = tag;
+        order_value[order_count] = xfer->type == TCS_XFER_READ ? xfer->data[0] : xfer->data[1];
+        order_us[order_count] = SimBoard_NowUs();
+        order_count++;
+    }
+}
+
+static void on_xfer0(uint8_t sensor, TCS34725_Xfer_t *xfer) { (void)sensor; record_xfer(0, xfer); }
+static void on_xfer1(uint8_t sensor, TCS34725_Xfer_t *xfer) { (void)sensor; record_xfer(1, xfer); }
+static void on_xfer2(uint8_t sensor, TCS34725_Xfer_t *xfer) { (void)sensor; record_xfer(2, xfer); }
+static void on_xfer3(uint8_t sensor, TCS34725_Xfer_t *xfer) { (void)sensor; record_xfer(3, xfer); }
+
+// Transakcje koncza sie asynchronicznie, jedna po drugiej w kolejnosci zlecenia,
+// a odczyt po zapisie widzi zapisana wartosc. Pelna kolejka odrzuca zlecenie.
+static void test_dma_order(void) {
+    boot_recorded();
+
+    CHECK_EQ(TCS34725_QueueWrite(0, TCS34725_ATIME, 0xC0, on_xfer0), HAL_OK);
+    CHECK_EQ(TCS34725_QueueRead(0, TCS34725_ATIME, 1, on_xfer1), HAL_OK);
+    CHECK_EQ(TCS34725_QueueWrite(0, TCS34725_ATIME, 0xF6, on_xfer2), HAL_OK);
+    CHECK_EQ(TCS34725_QueueRead(0, TCS34725_ATIME, 1, on_xfer3), HAL_OK);
+    CHECK_EQ(order_count, 0);
+    CHECK_EQ(tcs_buses[0].count, ORDER_XFERS);
+    CHECK(tcs_buses[0].active);
+
+    SimBoard_RunFor(5);
+    CHECK_EQ(order_count, ORDER_XFERS);
+    for (uint8_t i = 0; i < order_count; i++) {
+        CHECK_EQ(order_tag[i], i);
+        if (i > 0) {
+            CHECK(order_us[i] > order_us[i - 1]);
+        }
+    }
+    CHECK_EQ(order_value[1], 0xC0);
+    CHECK_EQ(order_value[3], 0xF6);
+    CHECK_EQ(tcs_buses[0].count, 0);
+    CHECK(!tcs_buses[0].active);
+
+    TCS34725_HoldBuses(1);
+    for (uint8_t i = 0; i < TCS_XFER_QUEUE_LEN; i++) {
+        CHECK_EQ(TCS34725_QueueRead(0, TCS34725_ID, 1, NULL), HAL_OK);
+    }
+    CHECK_EQ(TCS34725_QueueRead(0, TCS34725_ID, 1, NULL), HAL_BUSY);
+    TCS34725_HoldBuses(0);
+    SimBoard_RunFor(10);
+    CHECK_EQ(tcs_buses[0].count, 0);
+    CHECK_EQ(SimBoard_Bus(0)->errors, 0);
+}
+
+static const TestCase_t cases[] = {
+    { "init", test_init },
+    { "cadence", test_cadence },
+    { "int_long_interval", test_int_long_interval },
+    { "i2c_recovery", test_i2c_recovery },
+    { "dma_order", test_dma_order },
+    { "settings_apply", test_settings_apply },
+};
+
+TEST_MAIN(cases)
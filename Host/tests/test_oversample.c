@@ -0,0 +1,259 @@
+// Nadprobkowanie (SETOVS/GETOVS) na symulowanej plytce: kazda probka archiwum porownana
+// z odczytami rejestrow danych, z ktorych powstala (srednia, rozrzut C, nasycenie,
+// znacznik czasu), a odczyty z modelem czujnika - z timera i z linii INT.
+
+#include "test_board.h"
+#include "circular_buffer.h"
+#include "color_calc.h"
+#include "protocol.h"
+#include "sim_bus.h"
+#include <stdio.h>
+
+#define MAX_READS          256
+#define MODEL_SIGMAS       5        // Odczyt w granicach szumu sceny
+#define INT_STAMP_TOL_US   50       // Tryb INT - koniec integracji ze zbocza linii
+#define BUS_READ_US        500      // Odczyt danych na magistrali, zapas
+
+typedef struct {
+    uint16_t c, r, g, b;
+    uint64_t end_us;                // Koniec integracji w modelu czujnika
+    uint32_t atime_us;
+    uint16_t full;
+} Read_t;
+
+static const uint8_t gain_multiplier[4] = { 1, 4, 16, 60 };
+
+static Read_t reads[MAX_READS];
+static uint32_t read_count = 0;
+static const uint8_t *pending_data = NULL;  // Bufor odczytu danych w toku
+static uint32_t pending_transfer = 0;
+static Read_t pending;
+static uint32_t last_cycles = 0;
+static uint64_t last_end_us = 0;
+static uint64_t last_sample_us = 0;
+
+static uint32_t samples = 0;                // Probki archiwum sprawdzone
+static uint32_t spread_samples = 0;         // Z rozrzutem wiekszym od 0
+static uint32_t mixed_saturation = 0;       // Nasycona tylko czesc integracji probki
+static uint64_t max_stamp_error_us = 0;
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Odczyt w granicach modelu: srednie natezenie sceny w oknie integracji razy cykle
+// i wzmocnienie, szum sceny w promilach
+static void check_model(const TcsSim_Sensor_t *dev, const Read_t *rd) {
+    uint32_t cycles = 256U - dev->regs[TCS34725_ATIME];
+    float scale = (float)cycles * gain_multiplier[dev->regs[TCS34725_CONTROL] & 0x03];
+    float c = 0.0f;
+    for (uint32_t i = 0; i < 8; i++) {
+        uint64_t t = rd->end_us - rd->atime_us + (uint64_t)rd->atime_us * (2U * i + 1U) / 16U;
+        c += TcsSim_SceneLight(dev->scene, t).c * scale / 8.0f;
+    }
+    float tol = c * dev->scene->noise_permille / 1000.0f * MODEL_SIGMAS + 1.0f;
+    if (c - tol >= rd->full) {
+        CHECK_EQ(rd->c, rd->full);
+    } else if (c + tol >= rd->full) {
+        CHECK_RANGE(rd->c, (long long)(c - tol), rd->full);
+    } else {
+        CHECK_RANGE(rd->c, (long long)(c - tol), (long long)(c + tol));
+    }
+}
+
+// Probka z count ostatnich odczytow: srednia z zaokragleniem, C na pelnej skali przy
+// nasyceniu ktorejkolwiek integracji, rozrzut max-min C, srodek od pierwszej do ostatniej
+static void check_sample(const ColorBufferEntry_t *entry, uint8_t count, uint8_t keep_spread,
+                         uint64_t stamp_tol_us) {
+    if (read_count < count) {
+        CHECK(read_count >= count);
+        return;
+    }
+    const Read_t *first = &reads[read_count - count];
+    const Read_t *last = &reads[read_count - 1];
+    uint32_t sum[4] = { 0, 0, 0, 0 };
+    uint16_t min = 0xFFFF, max = 0;
+    uint8_t saturated = 0;
+
+    for (const Read_t *rd = first; rd <= last; rd++) {
+        sum[0] += rd->c;
+        sum[1] += rd->r;
+        sum[2] += rd->g;
+        sum[3] += rd->b;
+        min = rd->c < min ? rd->c : min;
+        max = rd->c > max ? rd->c : max;
+        saturated |= rd->c >= rd->full;
+    }
+    uint16_t mean_c = (uint16_t)((sum[0] + count / 2) / count);
+    CHECK_EQ(entry->data.c, saturated ? last->full : mean_c);
+    CHECK_EQ(entry->data.r, (sum[1] + count / 2) / count);
+    CHECK_EQ(entry->data.g, (sum[2] + count / 2) / count);
+    CHECK_EQ(entry->data.b, (sum[3] + count / 2) / count);
+    CHECK_EQ(entry->spread, keep_spread ? max - min : TCS_SPREAD_NONE);
+    if (keep_spread && max > min) {
+        spread_samples++;
+    }
+    if (saturated && mean_c < last->full) {
+        mixed_saturation++;
+    }
+
+    uint64_t mid_first = first->end_us - first->atime_us / 2;
+    uint64_t mid_last = last->end_us - last->atime_us / 2;
+    uint64_t expected = mid_first + (mid_last - mid_first) / 2;
+    uint64_t error = entry->timestamp_us > expected ? entry->timestamp_us - expected
+                                                    : expected - entry->timestamp_us;
+    CHECK(error <= stamp_tol_us);
+    if (error > max_stamp_error_us) {
+        max_stamp_error_us = error;
+    }
+    samples++;
+}
+
+static uint8_t check_count = 1;
+static uint8_t check_spread = 0;
+static uint64_t check_tol_us = 0;
+
+// Odczyty rejestrow danych czujnika 0 (8 bajtow od CDATAL) z koncem integracji, ktora
+// zatrzasnela dane, i nowe probki archiwum
+static void on_event(void *user) {
+    TcsSim_Sensor_t *dev = SimBoard_Sensor(0);
+    SimBus_t *bus = SimBoard_Bus(0);
+    ColorBufferEntry_t entry;
+    (void)user;
+
+    if (dev->cycles != last_cycles) {
+        last_cycles = dev->cycles;
+        last_end_us = SimBoard_NowUs();
+    }
+    if (pending_data != NULL && (!bus->active || bus->transfers != pending_transfer)) {
+        pending.c = le16(&pending_data[0]);
+        pending.r = le16(&pending_data[2]);
+        pending.g = le16(&pending_data[4]);
+        pending.b = le16(&pending_data[6]);
+        pending_data = NULL;
+        check_model(dev, &pending);
+        if (read_count < MAX_READS) {
+            reads[read_count++] = pending;
+        }
+    }
+    if (bus->active && bus->is_read && bus->len == 8 && (bus->reg & 0x1F) == TCS34725_CDATAL
+            && bus->transfers != pending_transfer) {
+        pending_data = bus->data;
+        pending_transfer = bus->transfers;
+        pending.end_us = last_end_us;
+        pending.atime_us = (256U - dev->regs[TCS34725_ATIME]) * TCS_SIM_CYCLE_US;
+        pending.full = TcsSim_FullScale(dev);
+    }
+
+    if (ColorBuffer_ReadLatest(0, &entry) && entry.timestamp_us != last_sample_us) {
+        last_sample_us = entry.timestamp_us;
+        if (check_count > 1) {
+            check_sample(&entry, check_count, check_spread, check_tol_us);
+        }
+    }
+}
+
+static void boot_recorded(const char *scene) {
+    SimBoard_SetEventHook(on_event, NULL);
+    TestBoard_Boot(scene);
+}
+
+// Ustawienia przyjete - kolejne probki sprawdzane z count integracji
+static void expect_oversample(const char *setovs, const char *getovs, uint64_t tol_us) {
+    EXPECT_REPLY(setovs, RESP_OK);
+    EXPECT_REPLY(CMD_STR_GETOVS, getovs);
+    check_count = (uint8_t)((setovs[6] - '0') * 10 + (setovs[7] - '0'));
+    check_spread = (uint8_t)(setovs[8] - '0');
+    check_tol_us = tol_us;
+}
+
+// Parametry SETOVS: zakres, znak rozrzutu, dlugosc i suma integracji ponizej interwalu
+static void test_setovs_params(void) {
+    boot_recorded("office");
+    EXPECT_REPLY("GETOVS", "OVS01S0");
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY("SETINT00300", RESP_OK);
+
+    EXPECT_REPLY("SETOVS000", WRCMD_STR);
+    EXPECT_REPLY("SETOVS170", WRCMD_STR);
+    EXPECT_REPLY("SETOVS042", WRCMD_STR);
+    EXPECT_REPLY("SETOVS04", WRLEN_STR);
+    EXPECT_REPLY("SETOVS131", WRTIME_STR);     // 13 x 24ms >= 300ms
+    EXPECT_REPLY("GETOVS", "OVS01S0");
+
+    // Bez zapisu rozrzutu
+    expect_oversample("SETOVS120", "OVS12S0", 24000 / 2 + BUS_READ_US);
+    EXPECT_REPLY("START", RESP_OK);
+    SimBoard_RunFor(3000);
+    CHECK_RANGE(samples, 9, 10);
+    CHECK_EQ(spread_samples, 0);
+}
+
+// Z timera: 4 integracje po kolei od ticku TIM2, srodek integracji szacowany z odczytu
+// (blad do ATIME/2)
+static void test_timer_mean_spread(void) {
+    boot_recorded("office");
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    expect_oversample("SETOVS041", "OVS04S1", 24000 / 2 + BUS_READ_US);
+    EXPECT_REPLY("START", RESP_OK);
+    uint32_t interrupts = SimBoard_TimerInterrupts();
+    SimBoard_RunFor(10000);
+
+    printf("%lu probek, %lu odczytow, max blad znacznika %llu us\n", (unsigned long)samples,
+           (unsigned long)read_count, (unsigned long long)max_stamp_error_us);
+    CHECK_RANGE(samples, 9, 10);
+    CHECK_RANGE(read_count, samples * 4, samples * 4 + 3);     // Probka w toku
+    CHECK(spread_samples > 0);
+    CHECK_EQ(SimBoard_TimerInterrupts() - interrupts, 10);
+}
+
+// Z linii INT: integracje co 250ms (WTIME), koniec integracji ze zbocza - znacznik
+// w granicach kilkudziesieciu us, TIM2 zatrzymany
+static void test_int_mean_spread(void) {
+    boot_recorded("office");
+    EXPECT_REPLY("SETSRC1", RESP_OK);
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    expect_oversample("SETOVS041", "OVS04S1", INT_STAMP_TOL_US);
+    EXPECT_REPLY("START", RESP_OK);
+    uint32_t interrupts = SimBoard_TimerInterrupts();
+    SimBoard_RunFor(10000);
+
+    printf("%lu probek, %lu odczytow, max blad znacznika %llu us\n", (unsigned long)samples,
+           (unsigned long)read_count, (unsigned long long)max_stamp_error_us);
+    CHECK_RANGE(samples, 9, 10);
+    CHECK(spread_samples > 0);
+    CHECK_EQ(SimBoard_TimerInterrupts(), interrupts);
+    CHECK(SimBoard_Sensor(0)->regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN);
+    CHECK(reads[read_count - 1].end_us - reads[read_count - 2].end_us > 240000);
+}
+
+// Scena migajaca 200/20 co 300ms przy 16x: jasne integracje nasycone, ciemne nie.
+// Probka z czesci nasyconych ma C na pelnej skali, choc srednia jest ponizej.
+static void test_saturation(void) {
+    boot_recorded("flicker");
+    EXPECT_REPLY("SETSRC1", RESP_OK);
+    EXPECT_REPLY("SETGAIN2", RESP_OK);
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    expect_oversample("SETOVS081", "OVS08S1", INT_STAMP_TOL_US);
+    EXPECT_REPLY("START", RESP_OK);
+    SimBoard_RunFor(10000);
+
+    ColorBufferEntry_t entry;
+    CHECK(ColorBuffer_ReadLatest(0, &entry));
+    CHECK_EQ(entry.data.c, ColorCalc_FullScale(1));
+    CHECK_RANGE(samples, 9, 10);
+    CHECK_EQ(mixed_saturation, samples);
+    EXPECT_REPLY("RDLUX", "LUX99999999K99999S1");
+}
+
+static const TestCase_t cases[] = {
+    { "setovs_params", test_setovs_params },
+    { "timer_mean_spread", test_timer_mean_spread },
+    { "int_mean_spread", test_int_mean_spread },
+    { "saturation", test_saturation },
+};
+
+TEST_MAIN(cases)
@@ -0,0 +1,28 @@
+// Komendy protokolu na symulowanej plytce - walidacja parametrow i odpowiedzi.
+
+#include "test_board.h"
+#include "protocol.h"
+
+// Prog SETTRG miesci sie w 16 bitach reguly: 65535 przyjete, wieksze odrzucone
+// bez zmiany zapisanej reguly (wczesniej 70000 zapisywalo sie jako 4464)
+static void test_settrg_threshold(void) {
+    TestBoard_Boot("office");
+
+    EXPECT_REPLY("SETTRG0AC65535", RESP_OK);
+    EXPECT_REPLY("GETTRG0", "TRG0AC65535");
+
+    EXPECT_REPLY("SETTRG0AC65536", WRCMD_STR);
+    EXPECT_REPLY("SETTRG0RG65536", WRCMD_STR);
+    EXPECT_REPLY("SETTRG0AC70000", WRCMD_STR);
+    EXPECT_REPLY("SETTRG0AC99999", WRCMD_STR);
+    EXPECT_REPLY("GETTRG0", "TRG0AC65535");
+
+    EXPECT_REPLY("SETTRG1RG00000", RESP_OK);
+    EXPECT_REPLY("GETTRG1", "TRG1RG00000");
+}
+
+static const TestCase_t cases[] = {
+    { "settrg_threshold", test_settrg_threshold },
+};
+
+TEST_MAIN(cases)
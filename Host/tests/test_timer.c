@@ -0,0 +1,90 @@
+// Timer probkowania TIM2: jedno przerwanie na probke i zmiana SETINT w trakcie pracy
+// z buforowanym ARR (biezacy okres konczy sie na starym interwale).
+
+#include "test_board.h"
+#include "circular_buffer.h"
+#include "protocol.h"
+#include "tim.h"
+
+#define MAX_TICKS 32
+#define TICK_TOLERANCE_US 100
+
+static uint64_t timer_start_us = 0;         // Start TIM2 (0 - jeszcze nie uruchomiony)
+static uint64_t tick_us[MAX_TICKS];         // Chwile kolejnych przerwan TIM2
+static uint32_t tick_count = 0;
+static uint32_t last_interrupts = 0;
+static uint32_t sample_count = 0;           // Nowe probki w archiwum czujnika 0
+static uint64_t last_sample_us = 0;
+
+static void on_event(void *user) {
+    ColorBufferEntry_t entry;
+    (void)user;
+
+    if (timer_start_us == 0 && htim2.running) {
+        timer_start_us = SimBoard_NowUs();
+    }
+    uint32_t interrupts = SimBoard_TimerInterrupts();
+    while (last_interrupts < interrupts) {
+        if (tick_count < MAX_TICKS) {
+            tick_us[tick_count++] = SimBoard_NowUs();
+        }
+        last_interrupts++;
+    }
+    if (ColorBuffer_ReadLatest(0, &entry) && entry.timestamp_us != last_sample_us) {
+        last_sample_us = entry.timestamp_us;
+        sample_count++;
+    }
+}
+
+static void boot_recorded(void) {
+    SimBoard_SetEventHook(on_event, NULL);
+    TestBoard_Boot("office");
+}
+
+// 10s przy 1000ms: 10 przerwan TIM2 i 10 probek, zamiast przerwania co 1ms
+static void test_isr_per_sample(void) {
+    boot_recorded();
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    EXPECT_REPLY("START", RESP_OK);
+
+    uint32_t interrupts = SimBoard_TimerInterrupts();
+    sample_count = 0;
+    SimBoard_RunFor(10000);
+
+    CHECK_EQ(SimBoard_TimerInterrupts() - interrupts, 10);
+    CHECK_EQ(sample_count, 10);
+}
+
+// 5000 -> 200 (po 1s) -> 1000 (po 6.1s): okresy 5000, 200 x6, 1000 bez okresu
+// skroconego ani wydluzonego w chwili zmiany
+static void test_interval_change(void) {
+    static const uint32_t expected_ms[] = { 5000, 200, 200, 200, 200, 200, 200, 1000, 1000 };
+    const uint32_t expected_count = sizeof(expected_ms) / sizeof(expected_ms[0]);
+
+    boot_recorded();
+    EXPECT_REPLY("SETTIME1", RESP_OK);
+    EXPECT_REPLY("SETINT05000", RESP_OK);
+    EXPECT_REPLY("START", RESP_OK);
+    CHECK(timer_start_us != 0);
+
+    SimBoard_RunUntil(timer_start_us + 1000000U);
+    EXPECT_REPLY("SETINT00200", RESP_OK);
+    SimBoard_RunUntil(timer_start_us + 6100000U);
+    EXPECT_REPLY("SETINT01000", RESP_OK);
+    SimBoard_RunUntil(timer_start_us + 8500000U);
+
+    CHECK_EQ(tick_count, expected_count);
+    for (uint32_t i = 0; i < tick_count && i < expected_count; i++) {
+        uint64_t prev = i == 0 ? timer_start_us : tick_us[i - 1];
+        CHECK_RANGE(tick_us[i] - prev, expected_ms[i] * 1000U - TICK_TOLERANCE_US,
+                    expected_ms[i] * 1000U + TICK_TOLERANCE_US);
+    }
+    CHECK_EQ(sample_count, tick_count);
+}
+
+static const TestCase_t cases[] = {
+    { "isr_per_sample", test_isr_per_sample },
+    { "interval_change", test_interval_change },
+};
+
+TEST_MAIN(cases)
@@ -0,0 +1,142 @@
+// TIMESYNC na symulowanej plytce: zegar hosta ze znanym przesunieciem i dryfem wzgledem
+// zegara symulacji, T2 przy kilku ramkach w buforze RX, odrzucanie wymian o duzym opoznieniu.
+
+#include "test_board.h"
+#include "protocol.h"
+#include "timesync.h"
+#include "rtc_clock.h"
+#include "hal_host.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HOST_EPOCH_US   1700000000000000ULL   // Czas hosta w chwili startu symulacji
+#define SYNC_TOLERANCE_US  2
+
+static int64_t host_slew_ppb = 0;       // Dryf zegara hosta wzgledem zegara plytki
+
+static uint64_t host_now(uint64_t sim_us) {
+    return HOST_EPOCH_US + sim_us + (uint64_t)((int64_t)sim_us * host_slew_ppb / 1000000000LL);
+}
+
+static uint8_t send_timesync(uint64_t t1, uint64_t t4) {
+    char payload[MAX_PAYLOAD_LEN + 1];
+    snprintf(payload, sizeof(payload), CMD_STR_TIMESYNC "%016llu%016llu",
+             (unsigned long long)t1, (unsigned long long)t4);
+    return TestBoard_Send(payload);
+}
+
+// Jedna wymiana: T1 przy wyslaniu, zwraca T4 - odbior odpowiedzi przez hosta
+static uint64_t exchange(uint64_t prev_t4) {
+    char reply[MAX_PAYLOAD_LEN + 1];
+    uint8_t id = send_timesync(host_now(SimBoard_NowUs()), prev_t4);
+    CHECK(TestBoard_WaitReply(id, reply, sizeof(reply)));
+    CHECK(strncmp(reply, TSY_PREFIX, sizeof(TSY_PREFIX) - 1) == 0);
+    return host_now(TestBoard_ReplyUs());
+}
+
+// Czas plytki po synchronizacji minus czas hosta
+static int64_t clock_error_us(void) {
+    uint64_t now = SimBoard_NowUs();
+    return (int64_t)(TimeSync_ToEpochUs(now) - host_now(now));
+}
+
+// Przesuniecie zegara hosta o staly czas: po dwoch wymianach zegar plytki i RTC
+// pokazuja czas hosta
+static void test_known_offset(void) {
+    TestBoard_Boot("office");
+    CHECK_EQ(TimeSync_GetSource(), TIMESYNC_NONE);
+
+    uint64_t t4 = exchange(0);
+    SimBoard_RunFor(1000);
+    exchange(t4);
+
+    CHECK_EQ(TimeSync_GetSource(), TIMESYNC_HOST);
+    CHECK_RANGE(TimeSync_GetLastOffsetUs(), -(int64_t)HOST_EPOCH_US - SYNC_TOLERANCE_US,
+                -(int64_t)HOST_EPOCH_US + SYNC_TOLERANCE_US);
+    CHECK_RANGE(TimeSync_GetLastDelayUs(), 0, SYNC_TOLERANCE_US);
+    CHECK_RANGE(clock_error_us(), -SYNC_TOLERANCE_US, SYNC_TOLERANCE_US);
+
+    SimBoard_RunFor(5000);
+    uint64_t rtc_us;
+    CHECK(RtcClock_Read(&rtc_us));
+    CHECK_RANGE((int64_t)(rtc_us - host_now(SimBoard_NowUs())), -4000, 0);   // Krok RTC 1/256 s
+}
+
+// TIMESYNC i kolejna ramka w buforze RX przed przetworzeniem: T2 pochodzi ze znaku
+// startu ramki TIMESYNC, a nie z pozniejszej
+static void test_pipelined_t2(void) {
+    char reply[MAX_PAYLOAD_LEN + 1];
+    TestBoard_Boot("office");
+
+    uint8_t id = send_timesync(host_now(SimBoard_NowUs()), 0);
+    HostHal_SetNowUs(SimBoard_NowUs() + 5000);
+    CHECK(TestBoard_Send(CMD_STR_GETINT) != 0);
+    CHECK(TestBoard_WaitReply(id, reply, sizeof(reply)));
+    uint64_t t4 = host_now(TestBoard_ReplyUs());
+
+    SimBoard_RunFor(1000);
+    exchange(t4);
+    CHECK_EQ(TimeSync_GetSource(), TIMESYNC_HOST);
+    CHECK_RANGE(TimeSync_GetLastDelayUs(), 0, SYNC_TOLERANCE_US);
+    CHECK_RANGE(clock_error_us(), -SYNC_TOLERANCE_US, SYNC_TOLERANCE_US);
+}
+
+// Zegar hosta szybszy o 100 ppm: wymiany co 10s zbiegaja do dryfu 100000 ppb,
+// zapisanego tez w rejestrze zapasowym RTC
+static void test_slewed_drift(void) {
+    host_slew_ppb = 100000;
+    TestBoard_Boot("office");
+
+    uint64_t t4 = 0;
+    for (int i = 0; i < 20; i++) {
+        t4 = exchange(t4);
+        SimBoard_RunFor(TIMESYNC_DRIFT_MIN_US / 1000);
+    }
+    exchange(t4);
+
+    int32_t drift = TimeSync_GetDriftPpb();
+    printf("dryf %ld ppb, blad zegara %lld us\n", (long)drift, (long long)clock_error_us());
+    CHECK_RANGE(drift, 99000, 101000);
+    CHECK_EQ((int32_t)RtcClock_BackupRead(RTC_CLOCK_BKP_DRIFT), drift);
+
+    // Bez kolejnych wymian zegar plytki nadaza za hostem
+    SimBoard_RunFor(60000);
+    CHECK_RANGE(clock_error_us(), -100, 100);
+}
+
+// Wymiana o opoznieniu ponad TIMESYNC_MAX_DELAY_US (T4 zgloszone pozniej) nie koryguje
+// zegara; opoznienie w granicy jest przyjmowane
+static void test_delay_rejection(void) {
+    TestBoard_Boot("office");
+    uint64_t t4 = exchange(0);
+    SimBoard_RunFor(1000);
+    t4 = exchange(t4);
+    int64_t offset = TimeSync_GetLastOffsetUs();
+    uint32_t delay = TimeSync_GetLastDelayUs();
+
+    SimBoard_RunFor(1000);
+    t4 = exchange(t4 + TIMESYNC_MAX_DELAY_US + 1000);
+    CHECK_EQ(TimeSync_GetLastOffsetUs(), offset);
+    CHECK_EQ(TimeSync_GetLastDelayUs(), delay);
+    CHECK_RANGE(clock_error_us(), -SYNC_TOLERANCE_US, SYNC_TOLERANCE_US);
+
+    // T4 przed T1 - wymiana pominieta
+    SimBoard_RunFor(1000);
+    t4 = exchange(HOST_EPOCH_US);
+    CHECK_EQ(TimeSync_GetLastOffsetUs(), offset);
+
+    SimBoard_RunFor(1000);
+    exchange(t4 + TIMESYNC_MAX_DELAY_US - 2000);
+    CHECK_RANGE(TimeSync_GetLastDelayUs(), TIMESYNC_MAX_DELAY_US - 2000 - SYNC_TOLERANCE_US,
+                TIMESYNC_MAX_DELAY_US - 2000 + SYNC_TOLERANCE_US);
+    CHECK(TimeSync_GetLastOffsetUs() != offset);
+}
+
+static const TestCase_t cases[] = {
+    { "known_offset", test_known_offset },
+    { "pipelined_t2", test_pipelined_t2 },
+    { "slewed_drift", test_slewed_drift },
+    { "delay_rejection", test_delay_rejection },
+};
+
+TEST_MAIN(cases)
@@ -0,0 +1,411 @@
+// Mikrobenchmarki protokolu, CRC i archiwum pomiarow na hoscie.
+// Uzycie: tcs_bench [--filter=tekst] [--min-time=s] [--out=plik] [--baseline=plik]
+// Kazdy przypadek jest powtarzany (podwajanie liczby iteracji) az pomiar trwa
+// co najmniej min-time; wynik to ns na operacje oraz liczba i rozmiar alokacji
+// sterty na operacje. --out zapisuje wyniki jako linie "nazwa ns alokacje bajty",
+// --baseline porownuje z takim plikiem i drukuje zmiane czasu w procentach.
+
+extern "C" {
+#include "protocol.h"
+#include "crc16.h"
+#include "circular_buffer.h"
+#include "timebase.h"
+#include "trace.h"
+#include "hal_host.h"
+}
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Licznik alokacji: malloc/free z glibc przechwycone w pliku wykonywalnym,
+// operator new z libstdc++ tez przez nie przechodzi
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+bool alloc_counting = false;
+uint64_t alloc_count = 0;
+uint64_t alloc_bytes = 0;
+
+void count_alloc(size_t size) {
+    if (alloc_counting) {
+        alloc_count++;
+        alloc_bytes += size;
+    }
+}
+
+}  // namespace
+
+extern "C" {
+
+void *malloc(size_t size) {
+    count_alloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    count_alloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+}  // extern "C"
+
+namespace {
+
+// Stan przebiegu w stylu Google Benchmark: for ([[maybe_unused]] auto _ : state) { ... }
+class BenchState {
+public:
+    explicit BenchState(uint64_t iterations) : iterations_(iterations) {}
+
+    struct Iterator {
+        uint64_t left;
+        bool operator!=(const Iterator &) const { return left != 0; }
+        void operator++() { left--; }
+        int operator*() const { return 0; }
+    };
+
+    // Przygotowanie danych przed petla nie wchodzi do pomiaru czasu ani alokacji
+    Iterator begin() {
+        alloc_count = 0;
+        alloc_bytes = 0;
+        start_ = std::chrono::steady_clock::now();
+        return Iterator{ iterations_ };
+    }
+    Iterator end() {
+        return Iterator{ 0 };
+    }
+
+    uint64_t iterations() const { return iterations_; }
+    std::chrono::steady_clock::time_point start() const { return start_; }
+
+private:
+    uint64_t iterations_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+template <typename T>
+inline void DoNotOptimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+typedef void (*BenchFn)(BenchState &);
+
+struct Bench {
+    const char *name;
+    BenchFn fn;
+};
+
+std::vector<Bench> &registry() {
+    static std::vector<Bench> benches;
+    return benches;
+}
+
+struct BenchRegistrar {
+    BenchRegistrar(const char *name, BenchFn fn) { registry().push_back({ name, fn }); }
+};
+
+#define BENCHMARK(fn) static BenchRegistrar registrar_##fn(#fn, fn)
+
+struct Result {
+    double ns;
+    double allocs;
+    double bytes;
+};
+
+Result run(const Bench &bench, double min_time_s) {
+    for (uint64_t iterations = 1;; iterations *= 2) {
+        BenchState state(iterations);
+        alloc_counting = true;
+        bench.fn(state);
+        auto stop = std::chrono::steady_clock::now();
+        alloc_counting = false;
+
+        double elapsed = std::chrono::duration<double>(stop - state.start()).count();
+        if (elapsed >= min_time_s || iterations >= (1ULL << 40)) {
+            return Result{ elapsed * 1e9 / (double) iterations,
+                           (double) alloc_count / (double) iterations,
+                           (double) alloc_bytes / (double) iterations };
+        }
+    }
+}
+
+// Kod bledu jest pomijany, gdy ramka niesie dane
+const ErrorCode kNoError = (ErrorCode) 0;
+
+// Ramka od hosta, jak wysyla ja PC (nadawca PC1, odbiorca STM)
+std::string host_frame(const char *payload, uint8_t id) {
+    char frame[MAX_FRAME_LEN + 1];
+    if (!build_response_frame(frame, sizeof(frame), "PC1", DEVICE_ID, id, payload, kNoError)) {
+        std::fprintf(stderr, "Nie mozna zbudowac ramki '%s'\n", payload);
+        std::exit(1);
+    }
+    return frame;
+}
+
+void parse_case(BenchState &state, const std::string &frame, ParseResult expected) {
+    Frame parsed;
+    char response[MAX_FRAME_LEN];
+    if (parse_frame(frame.c_str(), frame.size(), &parsed, response, sizeof(response)) != expected) {
+        std::fprintf(stderr, "parse_frame: nieoczekiwany wynik dla %s\n", frame.c_str());
+        std::exit(1);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        ParseResult result = parse_frame(frame.c_str(), frame.size(), &parsed,
+                                         response, sizeof(response));
+        DoNotOptimize(result);
+        DoNotOptimize(parsed);
+    }
+}
+
+// ---- CRC ----
+
+void crc16_case(BenchState &state, size_t len) {
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t) ('0' + i % 43);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        uint16_t crc = crc16_ccitt(data.data(), data.size());
+        DoNotOptimize(crc);
+    }
+}
+
+void BM_crc16_ccitt_16(BenchState &state) { crc16_case(state, 16); }
+void BM_crc16_ccitt_256(BenchState &state) { crc16_case(state, 256); }
+void BM_crc16_ccitt_512(BenchState &state) { crc16_case(state, MAX_PAYLOAD_LEN * 2); }
+BENCHMARK(BM_crc16_ccitt_16);
+BENCHMARK(BM_crc16_ccitt_256);
+BENCHMARK(BM_crc16_ccitt_512);
+
+void BM_calculate_frame_crc(BenchState &state) {
+    std::string frame = host_frame("SETINT00100", 7);
+    Frame parsed;
+    char response[MAX_FRAME_LEN];
+    parse_frame(frame.c_str(), frame.size(), &parsed, response, sizeof(response));
+    for ([[maybe_unused]] auto _ : state) {
+        uint16_t crc = calculate_frame_crc(&parsed);
+        DoNotOptimize(crc);
+    }
+}
+BENCHMARK(BM_calculate_frame_crc);
+
+// ---- parse_frame ----
+
+void BM_parse_frame_RDRAW(BenchState &state) {
+    parse_case(state, host_frame("RDRAW", 1), PARSE_OK);
+}
+void BM_parse_frame_SETINT(BenchState &state) {
+    parse_case(state, host_frame("SETINT00100", 2), PARSE_OK);
+}
+void BM_parse_frame_TIMESYNC(BenchState &state) {
+    parse_case(state, host_frame("TIMESYNC00000001700000000000000000000000", 3), PARSE_OK);
+}
+void BM_parse_frame_bad_crc(BenchState &state) {
+    std::string frame = host_frame("RDRAW", 4);
+    char &crc_digit = frame[frame.size() - 2];
+    crc_digit = crc_digit == '0' ? '1' : '0';
+    parse_case(state, frame, PARSE_CRC_ERROR);
+}
+BENCHMARK(BM_parse_frame_RDRAW);
+BENCHMARK(BM_parse_frame_SETINT);
+BENCHMARK(BM_parse_frame_TIMESYNC);
+BENCHMARK(BM_parse_frame_bad_crc);
+
+// ---- build_response_frame ----
+
+void build_case(BenchState &state, const char *payload, ErrorCode error) {
+    char frame[MAX_FRAME_LEN + 1];
+    for ([[maybe_unused]] auto _ : state) {
+        uint8_t ok = build_response_frame(frame, sizeof(frame), DEVICE_ID, "PC1", 42, payload, error);
+        DoNotOptimize(ok);
+        DoNotOptimize(frame);
+    }
+}
+
+void BM_build_response_frame_OK(BenchState &state) {
+    build_case(state, RESP_OK, kNoError);
+}
+void BM_build_response_frame_ANS(BenchState &state) {
+    build_case(state, "ANSR00449G00478B00323C01196", kNoError);
+}
+void BM_build_response_frame_error(BenchState &state) {
+    build_case(state, NULL, WRCHSUM);
+}
+void BM_build_response_frame_RDTRC(BenchState &state) {
+    // Najdluzsza odpowiedz w uzyciu: pelna strona sladu
+    std::string payload = "TRCQ0000000000H0000000256N14";
+    for (int i = 0; i < (int) TRACE_PAGE_LEN; i++) {
+        payload += "0001E24007010203";
+    }
+    build_case(state, payload.c_str(), kNoError);
+}
+BENCHMARK(BM_build_response_frame_OK);
+BENCHMARK(BM_build_response_frame_ANS);
+BENCHMARK(BM_build_response_frame_error);
+BENCHMARK(BM_build_response_frame_RDTRC);
+
+// ---- kodek hex ----
+
+void BM_hex_encode_string(BenchState &state) {
+    const char *input = "ANSR00449G00478B00323C01196";
+    char output[MAX_PAYLOAD_LEN * 2 + 1];
+    for ([[maybe_unused]] auto _ : state) {
+        int len = hex_encode_string(input, output, sizeof(output));
+        DoNotOptimize(len);
+        DoNotOptimize(output);
+    }
+}
+void BM_hex_decode_string(BenchState &state) {
+    char hex[MAX_PAYLOAD_LEN * 2 + 1];
+    char output[MAX_PAYLOAD_LEN + 1];
+    hex_encode_string("ANSR00449G00478B00323C01196", hex, sizeof(hex));
+    for ([[maybe_unused]] auto _ : state) {
+        int len = hex_decode_string(hex, output, sizeof(output));
+        DoNotOptimize(len);
+        DoNotOptimize(output);
+    }
+}
+BENCHMARK(BM_hex_encode_string);
+BENCHMARK(BM_hex_decode_string);
+
+// ---- archiwum pomiarow ----
+
+// Pelne archiwum czujnika 0 z probkami co timer_interval ms, zegar tuz po ostatniej
+void fill_archive() {
+    static bool filled = false;
+    if (filled) {
+        return;
+    }
+    Timebase_Init();
+    for (uint32_t i = 0; i < COLOR_BUFFER_SIZE; i++) {
+        TCS34725_Data_t data = {};
+        data.c = (uint16_t) (1000 + i);
+        data.r = 400;
+        data.g = 450;
+        data.b = 300;
+        uint64_t ts = (uint64_t) (i + 1) * timer_interval * 1000;
+        HostHal_SetNowUs(ts);
+        ColorBuffer_Put(0, &data, TCS_SPREAD_NONE, ts);
+    }
+    HostHal_SetNowUs(HostHal_NowUs() + 1000);
+    filled = true;
+}
+
+void read_by_offset_case(BenchState &state, uint32_t offset_ms) {
+    fill_archive();
+    ColorBufferEntry_t entry;
+    if (!ColorBuffer_ReadByTimeOffset(0, offset_ms, &entry)) {
+        std::fprintf(stderr, "ColorBuffer_ReadByTimeOffset: brak wpisu dla %lu ms\n",
+                     (unsigned long) offset_ms);
+        std::exit(1);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        uint8_t found = ColorBuffer_ReadByTimeOffset(0, offset_ms, &entry);
+        DoNotOptimize(found);
+        DoNotOptimize(entry);
+    }
+}
+
+// Najnowszy wpis (przeszukanie konczy sie na pierwszym) i najstarszy (cale archiwum)
+void BM_ColorBuffer_ReadByTimeOffset_newest(BenchState &state) {
+    read_by_offset_case(state, timer_interval);
+}
+void BM_ColorBuffer_ReadByTimeOffset_oldest(BenchState &state) {
+    read_by_offset_case(state, (COLOR_BUFFER_SIZE - 1) * timer_interval);
+}
+BENCHMARK(BM_ColorBuffer_ReadByTimeOffset_newest);
+BENCHMARK(BM_ColorBuffer_ReadByTimeOffset_oldest);
+
+std::map<std::string, Result> load_baseline(const char *path) {
+    std::map<std::string, Result> baseline;
+    std::ifstream in(path);
+    if (!in) {
+        std::fprintf(stderr, "Nie mozna otworzyc %s\n", path);
+        std::exit(1);
+    }
+    std::string name;
+    Result r;
+    while (in >> name >> r.ns >> r.allocs >> r.bytes) {
+        baseline[name] = r;
+    }
+    return baseline;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::string filter;
+    double min_time_s = 0.2;
+    const char *out_path = nullptr;
+    const char *baseline_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0) {
+            filter = arg.substr(9);
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            min_time_s = std::atof(arg.c_str() + 11);
+        } else if (arg.rfind("--out=", 0) == 0) {
+            out_path = argv[i] + 6;
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            baseline_path = argv[i] + 11;
+        } else {
+            std::fprintf(stderr, "Uzycie: %s [--filter=tekst] [--min-time=s] [--out=plik] "
+                         "[--baseline=plik]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::map<std::string, Result> baseline;
+    if (baseline_path) {
+        baseline = load_baseline(baseline_path);
+    }
+    std::FILE *out = nullptr;
+    if (out_path && !(out = std::fopen(out_path, "w"))) {
+        std::fprintf(stderr, "Nie mozna zapisac %s\n", out_path);
+        return 1;
+    }
+
+    std::printf("%-42s %12s %10s %10s%s\n", "Benchmark", "ns/op", "allocs/op", "bytes/op",
+                baseline_path ? "   vs baseline" : "");
+    for (const Bench &bench : registry()) {
+        if (!filter.empty() && std::strstr(bench.name, filter.c_str()) == nullptr) {
+            continue;
+        }
+        Result r = run(bench, min_time_s);
+        std::printf("%-42s %12.1f %10.2f %10.1f", bench.name, r.ns, r.allocs, r.bytes);
+        auto base = baseline.find(bench.name);
+        if (base != baseline.end() && base->second.ns > 0) {
+            std::printf("   %+7.1f%%", (r.ns / base->second.ns - 1.0) * 100.0);
+        }
+        std::printf("\n");
+        if (out) {
+            std::fprintf(out, "%s %.3f %.3f %.3f\n", bench.name, r.ns, r.allocs, r.bytes);
+        }
+    }
+    if (out) {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+// Symulowana plytka za pseudo-terminalem: kod z Core/ (protokol, archiwum, maszyna stanow
+// TCS34725) obsluguje port jak prawdziwe urzadzenie, wiec tcs_query, klient PC czy testy
+// obciazeniowe moga laczyc sie z procesem zamiast z plytka.
+// Uzycie: tcs_pty [-s scena] [-b baud] [-x tempo] [-l dowiazanie] [-t sekundy]
+//   -x tempo - wielokrotnosc czasu rzeczywistego (domyslnie 1), 0 - bez ograniczen
+//   -l       - dowiazanie symboliczne do /dev/pts/N (stala sciezka dla skryptow)
+//   -t       - koniec po podanym czasie symulacji (domyslnie do SIGINT)
+// Bajty w obie strony sa rozlozone w czasie symulacji wg predkosci 8N1 - paczka zapisana
+// do pty naraz nie przepelnia 128-bajtowego bufora odbiorczego UART jak na plytce.
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include "sim_board.h"
+#include "power.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PTY_QUEUE_LEN     4096U     // Bajty czekajace na linii w kazda strone
+#define PTY_FREE_SLICE_US 10000U    // Krok symulacji bez ograniczenia tempa
+#define PTY_POLL_MS       1         // Odstep obslugi pty w czasie rzeczywistym
+
+// Kolejka bajtow na linii UART: glowa wychodzi w chwili next_us, kolejne co byte_us
+typedef struct {
+    uint8_t data[PTY_QUEUE_LEN];
+    size_t head;
+    size_t count;
+    uint64_t next_us;
+    uint64_t bytes;
+    uint64_t dropped;
+} LineQueue_t;
+
+static LineQueue_t rx_line;     // pty -> UART urzadzenia
+static LineQueue_t tx_line;     // UART urzadzenia -> pty
+static uint64_t byte_us = 87;
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+static void line_push(LineQueue_t *q, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (q->count == PTY_QUEUE_LEN) {
+            q->dropped++;
+            continue;
+        }
+        if (q->count == 0) {
+            q->next_us = SimBoard_NowUs() + byte_us;
+        }
+        q->data[(q->head + q->count) % PTY_QUEUE_LEN] = data[i];
+        q->count++;
+    }
+}
+
+static uint8_t line_pop(LineQueue_t *q) {
+    uint8_t b = q->data[q->head];
+    q->head = (q->head + 1) % PTY_QUEUE_LEN;
+    q->count--;
+    q->bytes++;
+    q->next_us += byte_us;
+    return b;
+}
+
+static void on_output(const uint8_t *data, uint16_t len, void *user) {
+    (void)user;
+    line_push(&tx_line, data, len);
+}
+
+static void read_input(int fd) {
+    uint8_t buf[256];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        line_push(&rx_line, buf, (size_t)n);
+    }
+}
+
+// Bajty nadane do chwili biezacej. Bez czytelnika po drugiej stronie (pelny bufor pty)
+// gina jak na linii UART bez odbiornika.
+static void write_output(int fd) {
+    uint8_t buf[256];
+    size_t n = 0;
+    uint64_t now = SimBoard_NowUs();
+
+    while (tx_line.count > 0 && tx_line.next_us <= now) {
+        buf[n++] = line_pop(&tx_line);
+        if (n == sizeof(buf) || tx_line.count == 0 || tx_line.next_us > now) {
+            ssize_t w = write(fd, buf, n);
+            if (w < (ssize_t)n) {
+                tx_line.dropped += n - (w > 0 ? (size_t)w : 0U);
+            }
+            n = 0;
+        }
+    }
+}
+
+// Symulacja do target_us z odbiorem kazdego bajtu w jego chwili na linii
+static void run_until(uint64_t target_us) {
+    while (SimBoard_NowUs() < target_us) {
+        uint64_t until = target_us;
+        if (rx_line.count > 0 && rx_line.next_us < until) {
+            until = rx_line.next_us;
+        }
+        if (until > SimBoard_NowUs()) {
+            SimBoard_RunUntil(until);
+        }
+        while (rx_line.count > 0 && rx_line.next_us <= SimBoard_NowUs()) {
+            char b = (char)line_pop(&rx_line);
+            SimBoard_Send(&b, 1);
+        }
+    }
+}
+
+static int open_pty(char *slave_name, size_t name_len, int *slave_fd) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        return -1;
+    }
+    const char *name = ptsname(master);
+    if (name == NULL) {
+        return -1;
+    }
+    snprintf(slave_name, name_len, "%s", name);
+
+    // Wlasny deskryptor strony podrzednej - bez niego odczyt z mastera zwraca EIO,
+    // dopoki klient nie otworzy portu
+    *slave_fd = open(slave_name, O_RDWR | O_NOCTTY);
+    if (*slave_fd < 0) {
+        return -1;
+    }
+    struct termios tio;
+    if (tcgetattr(*slave_fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(*slave_fd, TCSANOW, &tio);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Uzycie: tcs_pty [-s scena] [-b baud] [-x tempo] [-l dowiazanie] [-t sekundy]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *scene_name = "office";
+    const char *link_path = NULL;
+    unsigned long baud = 115200;
+    double speed = 1.0;
+    double duration_s = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:b:x:l:t:")) != -1) {
+        switch (opt) {
+        case 's': scene_name = optarg; break;
+        case 'b': baud = strtoul(optarg, NULL, 10); break;
+        case 'x': speed = strtod(optarg, NULL); break;
+        case 'l': link_path = optarg; break;
+        case 't': duration_s = strtod(optarg, NULL); break;
+        default: usage(); return 1;
+        }
+    }
+    const TcsSim_Scene_t *scene = TcsSim_FindScene(scene_name);
+    if (scene == NULL || baud == 0 || speed < 0 || duration_s < 0) {
+        if (scene == NULL) {
+            fprintf(stderr, "Nieznana scena '%s'\n", scene_name);
+        }
+        usage();
+        return 1;
+    }
+    byte_us = (10U * 1000000U + baud / 2U) / baud;
+
+    char slave_name[64];
+    int slave_fd;
+    int fd = open_pty(slave_name, sizeof(slave_name), &slave_fd);
+    if (fd < 0) {
+        perror("pty");
+        return 1;
+    }
+    if (link_path != NULL) {
+        unlink(link_path);
+        if (symlink(slave_name, link_path) != 0) {
+            perror(link_path);
+            return 1;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    SimBoard_Init(scene);
+    SimBoard_SetOutput(on_output, NULL);
+    SimBoard_Boot();
+
+    printf("%s\n", link_path != NULL ? link_path : slave_name);
+    fflush(stdout);
+
+    uint64_t end_us = duration_s > 0 ? SimBoard_NowUs() + (uint64_t)(duration_s * 1e6) : UINT64_MAX;
+    uint64_t sim_start = SimBoard_NowUs();
+    uint64_t real_start = monotonic_us();
+
+    while (!stop_requested && SimBoard_NowUs() < end_us) {
+        uint64_t target;
+        if (speed > 0) {
+            // Czas symulacji nie wyprzedza rzeczywistego przemnozonego przez tempo
+            target = sim_start + (uint64_t)((double)(monotonic_us() - real_start) * speed);
+        } else {
+            target = SimBoard_NowUs() + PTY_FREE_SLICE_US;
+        }
+        if (target > end_us) {
+            target = end_us;
+        }
+
+        read_input(fd);
+        run_until(target);
+        write_output(fd);
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        poll(&pfd, 1, speed > 0 ? PTY_POLL_MS : 0);
+    }
+
+    if (link_path != NULL) {
+        unlink(link_path);
+    }
+    double sim_s = (double)(SimBoard_NowUs() - sim_start) / 1e6;
+    double real_s = (double)(monotonic_us() - real_start) / 1e6;
+    printf("--- %s, %.3f s symulacji w %.3f s (x%.1f)\n", scene->name, sim_s, real_s,
+           real_s > 0 ? sim_s / real_s : 0.0);
+    printf("UART %lu baud: odebrane %llu B (utracone %llu), wyslane %llu B (utracone %llu)\n",
+           baud, (unsigned long long)rx_line.bytes, (unsigned long long)rx_line.dropped,
+           (unsigned long long)tx_line.bytes, (unsigned long long)tx_line.dropped);
+    printf("petla glowna: %lu iteracji, wypelnienie %.2f%%, przerwania timera %lu\n",
+           (unsigned long)SimBoard_LoopIterations(), Power_GetDuty() / 100.0,
+           (unsigned long)SimBoard_TimerInterrupts());
+    close(slave_fd);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Zapytania do urzadzenia przez port szeregowy (lub pty symulatora) z biblioteki tcs_client.
+// Uzycie: tcs_query [-b baud] [-n w_locie] [-t timeout_ms] [-r powtorzenia] port KOMENDA...
+// Wszystkie komendy sa wysylane od razu (do -n naraz), odpowiedzi drukowane w kolejnosci
+// nadejscia z czasem od pierwszego wyslania i liczba prob.
+
+#include "tcs_client.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+    unsigned baud = 115200;
+    tcs::ClientOptions options;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:t:r:")) != -1) {
+        switch (opt) {
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'n': options.max_in_flight = static_cast<size_t>(std::atoi(optarg)); break;
+        case 't': options.timeout_ms = std::atoi(optarg); break;
+        case 'r': options.max_retries = std::atoi(optarg); break;
+        default:
+            std::fprintf(stderr, "Uzycie: %s [-b baud] [-n w_locie] [-t timeout_ms] [-r powtorzenia] "
+                         "port KOMENDA...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind + 1 >= argc) {
+        std::fprintf(stderr, "Brak portu lub komend\n");
+        return 1;
+    }
+
+    int fd = tcs::open_serial(argv[optind], baud);
+    if (fd < 0) {
+        std::perror(argv[optind]);
+        return 1;
+    }
+
+    tcs::Client client(fd, options);
+    client.on_event([](const tcs::Frame &frame) {
+        std::printf("%-12s %s\n", "(zdarzenie)", frame.data.c_str());
+    });
+    client.on_error([](ErrorCode code, const tcs::Frame &) {
+        std::printf("%-12s blad %s\n", "(bez numeru)", tcs::error_name(code));
+    });
+
+    int failures = 0;
+    for (int i = optind + 1; i < argc; i++) {
+        std::string command = argv[i];
+        client.request(command, [command, &failures](const tcs::Reply &reply) {
+            switch (reply.status) {
+            case tcs::Status::Ok:
+                std::printf("%-12s %s", command.c_str(), reply.data.c_str());
+                break;
+            case tcs::Status::DeviceError:
+                std::printf("%-12s blad %s", command.c_str(), tcs::error_name(reply.error));
+                failures++;
+                break;
+            case tcs::Status::Timeout:
+                std::printf("%-12s brak odpowiedzi", command.c_str());
+                failures++;
+                break;
+            case tcs::Status::Closed:
+                std::printf("%-12s port zamkniety", command.c_str());
+                failures++;
+                break;
+            }
+            std::printf("  (%.1f ms, proby %u)\n", reply.latency_us / 1000.0, reply.attempts);
+        });
+    }
+    client.run_until_idle();
+
+    const tcs::ClientStats &s = client.stats();
+    std::fprintf(stderr, "wyslane %llu, retransmisje %llu, odpowiedzi %llu, bez odpowiedzi %llu, "
+                 "niedopasowane %llu, bledne ramki %llu\n",
+                 (unsigned long long) s.sent, (unsigned long long) s.retransmits,
+                 (unsigned long long) s.replies, (unsigned long long) s.timeouts,
+                 (unsigned long long) s.unmatched, (unsigned long long) s.bad_frames);
+    close(fd);
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,155 @@
+// Demonstracja sterownika TCS34725 na symulowanej plytce.
+// Uzycie: tcs_sim [scena] [czas_ms] [komenda...]
+// Komendy (np. SETSRC1, SETINT00100, START) wysylane sa w ramkach protokolu na poczatku
+// przebiegu; "+ms" miedzy nimi przesuwa symulacje o podany czas przed kolejna komenda.
+// Odpowiedzi sa dekodowane, a na koncu drukowane statystyki symulacji.
+
+#include "sim_board.h"
+#include "protocol.h"
+#include "circular_buffer.h"
+#include "power.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_ADDR "PC1"
+
+static const char *const state_names[] = {
+    "INIT_READ_ID", "CONFIGURING", "POWERUP_WAIT", "READY",
+    "BUSY", "CLEARING", "RECOVERY", "ERROR",
+};
+
+static char rx_line[MAX_FRAME_LEN + 1];
+static size_t rx_len = 0;
+
+static void print_frame(const char *frame, size_t len) {
+    double t_ms = (double)SimBoard_NowUs() / 1000.0;
+    // & SSS RRR LLL ID dane CRC *
+    if (len < MIN_FRAME_LEN) {
+        printf("%10.3f  ?? %.*s\n", t_ms, (int)len, frame);
+        return;
+    }
+    int data_len = atoi((char[]){ frame[7], frame[8], frame[9], 0 });
+    printf("%10.3f  %.3s->%.3s #%.2s  ", t_ms, frame + 1, frame + 4, frame + 10);
+    for (int i = 0; i + 1 < data_len && 12 + i + 1 < (int)len; i += 2) {
+        char hex[3] = { frame[12 + i], frame[13 + i], 0 };
+        putchar((int)strtol(hex, NULL, 16));
+    }
+    putchar('\n');
+}
+
+static void on_output(const uint8_t *data, uint16_t len, void *user) {
+    (void)user;
+    for (uint16_t i = 0; i < len; i++) {
+        char ch = (char)data[i];
+        if (ch == PROTOCOL_START_BYTE) {
+            rx_len = 0;
+        }
+        if (rx_len < MAX_FRAME_LEN) {
+            rx_line[rx_len++] = ch;
+        }
+        if (ch == PROTOCOL_END_BYTE && rx_line[0] == PROTOCOL_START_BYTE) {
+            print_frame(rx_line, rx_len);
+            rx_len = 0;
+        } else if (ch == '\n' && rx_line[0] != PROTOCOL_START_BYTE) {
+            printf("%10.3f  %.*s", (double)SimBoard_NowUs() / 1000.0, (int)rx_len, rx_line);
+            rx_len = 0;
+        }
+    }
+}
+
+static TCS_State_t last_state[TCS_SENSOR_COUNT];
+static uint64_t last_ts[TCS_SENSOR_COUNT];
+
+// Po kazdym zdarzeniu symulacji - zmiany stanu czujnikow i nowe probki w archiwum
+static void on_event(void *user) {
+    (void)user;
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        ColorBufferEntry_t entry;
+        if (tcs_sensors[i].state != last_state[i]) {
+            last_state[i] = tcs_sensors[i].state;
+            printf("%10.3f  @%u stan %s\n", (double)SimBoard_NowUs() / 1000.0, i,
+                   state_names[last_state[i]]);
+        }
+        if (ColorBuffer_ReadLatest(i, &entry) && entry.timestamp_us != last_ts[i]) {
+            last_ts[i] = entry.timestamp_us;
+            printf("%10.3f  @%u C%u R%u G%u B%u gain %u time %u",
+                   (double)SimBoard_NowUs() / 1000.0, i, entry.data.c, entry.data.r,
+                   entry.data.g, entry.data.b, entry.gain_index, entry.time_index);
+            if (entry.spread != TCS_SPREAD_NONE) {
+                printf(" spread %u", entry.spread);
+            }
+            putchar('\n');
+        }
+    }
+}
+
+static void send_command(const char *payload, uint8_t id) {
+    char frame[MAX_FRAME_LEN + 1];
+    if (build_response_frame(frame, sizeof(frame), HOST_ADDR, DEVICE_ID, id, payload, 0)) {
+        SimBoard_Send(frame, strlen(frame));
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *scene_name = argc > 1 ? argv[1] : "office";
+    uint32_t duration_ms = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 3000;
+    const TcsSim_Scene_t *scene = TcsSim_FindScene(scene_name);
+
+    if (scene == NULL) {
+        fprintf(stderr, "Nieznana scena '%s' (", scene_name);
+        for (size_t i = 0; TcsSim_SceneAt(i) != NULL; i++) {
+            fprintf(stderr, "%s%s", i ? ", " : "", TcsSim_SceneAt(i)->name);
+        }
+        fprintf(stderr, ")\n");
+        return 1;
+    }
+
+    SimBoard_Init(scene);
+    SimBoard_SetOutput(on_output, NULL);
+    SimBoard_Boot();
+    SimBoard_RunFor(10);
+
+    for (int i = 3; i < argc; i++) {
+        if (argv[i][0] == '+') {
+            SimBoard_RunFor((uint32_t)strtoul(argv[i] + 1, NULL, 10));
+            continue;
+        }
+        send_command(argv[i], (uint8_t)((i - 3) % 100));
+        SimBoard_RunFor(5);
+    }
+    if (argc <= 3) {
+        send_command("START", 0);
+    }
+
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        last_state[i] = tcs_sensors[i].state;
+    }
+    SimBoard_SetEventHook(on_event, NULL);
+    SimBoard_RunFor(duration_ms);
+    SimBoard_SetEventHook(NULL, NULL);
+
+    printf("--- %s, %lu ms\n", scene->name, (unsigned long)duration_ms);
+    for (uint8_t i = 0; i < TCS_SENSOR_COUNT; i++) {
+        TcsSim_Sensor_t *dev = SimBoard_Sensor(i);
+        ColorBufferEntry_t last;
+        printf("czujnik %u: stan %s, integracje %lu (nasycone %lu), przerwania %lu",
+               i, state_names[tcs_sensors[i].state], (unsigned long)dev->cycles,
+               (unsigned long)dev->saturated, (unsigned long)dev->interrupts);
+        if (ColorBuffer_ReadLatest(i, &last)) {
+            printf(", ostatni C%u R%u G%u B%u", last.data.c, last.data.r, last.data.g, last.data.b);
+        }
+        putchar('\n');
+    }
+    for (uint8_t b = 0; b < TCS_BUS_COUNT; b++) {
+        SimBus_t *bus = SimBoard_Bus(b);
+        printf("magistrala %u: transfery %lu, bajty %lu, bledy %lu, zajetosc %.2f%%\n",
+               b, (unsigned long)bus->transfers, (unsigned long)bus->bytes,
+               (unsigned long)bus->errors, 100.0 * (double)bus->busy_us / (double)SimBoard_NowUs());
+    }
+    printf("petla glowna: %lu iteracji, wypelnienie %.2f%%, wybudzenia %lu/s\n",
+           (unsigned long)SimBoard_LoopIterations(), Power_GetDuty() / 100.0,
+           (unsigned long)Power_GetWakeups());
+    printf("przerwania timera probkowania: %lu\n", (unsigned long)SimBoard_TimerInterrupts());
+    return 0;
+}
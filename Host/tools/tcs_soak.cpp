@@ -0,0 +1,410 @@
+// Generator obciazenia i test dlugotrwaly protokolu przez port szeregowy (lub pty tcs_pty).
+// Uzycie: tcs_soak [opcje] port
+//   -R zapytania/s  docelowe tempo (domyslnie 20), 0 - tyle, ile pozwala okno w locie
+//   -d sekundy      czas pomiaru (10)
+//   -m mieszanka    wagi klas zapytan, np. RDRAW=4,RDARC=2,SET=1,GET=3 (domyslna)
+//   -c promile      ramki z uszkodzonym CRC (pierwsza proba)
+//   -k promile      ramki uciete przed koncem (pierwsza proba)
+//   -p ms           SETINT i START przed pomiarem - archiwum dla RDRAW/RDARC
+//   -b baud, -n w_locie, -t timeout_ms, -r powtorzenia - jak w tcs_query; domyslnie bez
+//                   retransmisji, zeby wstrzykniete bledy byly widoczne wprost w raporcie
+// Raport: przepustowosc, opoznienia p50/p99/p999 wg klas i lacznie, bledy wg ErrorCode.
+// SET zapisuje wartosci odczytane na poczatku, wiec nie zmienia konfiguracji urzadzenia.
+
+#include "tcs_device.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Kind { KIND_RDRAW, KIND_RDARC, KIND_SET, KIND_GET, KIND_COUNT };
+
+const char *const kKindNames[KIND_COUNT] = { "RDRAW", "RDARC", "SET", "GET" };
+
+const uint32_t kArchiveSpanMs = 5000;   // Przesuniecia RDARC losowane z 0..kArchiveSpanMs
+const uint8_t kSensor = 0;
+const size_t kErrorCount = WRSENS + 1;
+
+struct KindStats {
+    uint64_t issued = 0;
+    uint64_t ok = 0;
+    uint64_t timeouts = 0;
+    uint64_t closed = 0;
+    uint64_t bad_replies = 0;
+    std::array<uint64_t, kErrorCount> errors{};
+    std::vector<double> latency_us;     // Wszystkie odpowiedzi (OK i kody bledow)
+};
+
+std::array<KindStats, KIND_COUNT> stats;
+std::array<uint64_t, kErrorCount> event_errors{};    // Bledy bez frame_id (np. WRFRM)
+uint64_t injected_crc = 0;
+uint64_t injected_truncated = 0;
+volatile std::sig_atomic_t stop_requested = 0;
+
+void on_signal(int) {
+    stop_requested = 1;
+}
+
+template <typename T>
+tcs::Callback<T> record(Kind kind) {
+    return [kind](const tcs::Result<T> &r) {
+        KindStats &s = stats[kind];
+        switch (r.status) {
+        case tcs::Status::Ok:
+            if (r.bad_reply) {
+                s.bad_replies++;
+            } else {
+                s.ok++;
+            }
+            s.latency_us.push_back(r.latency_us);
+            break;
+        case tcs::Status::DeviceError:
+            s.errors[r.error]++;
+            s.latency_us.push_back(r.latency_us);
+            break;
+        case tcs::Status::Timeout:
+            s.timeouts++;
+            break;
+        case tcs::Status::Closed:
+            s.closed++;
+            break;
+        }
+    };
+}
+
+// Wartosci zapisywane przez SET - biezaca konfiguracja urzadzenia
+struct Config {
+    uint32_t interval_ms = 0;
+    uint8_t gain_index = 0;
+    uint8_t time_index = 0;
+};
+
+class Generator {
+public:
+    Generator(tcs::Device &dev, const Config &config, const std::array<unsigned, KIND_COUNT> &weights)
+        : dev_(dev), config_(config), pick_(weights.begin(), weights.end()), rng_(12345) {}
+
+    void issue() {
+        Kind kind = static_cast<Kind>(pick_(rng_));
+        stats[kind].issued++;
+        switch (kind) {
+        case KIND_RDRAW:
+            dev_.read_raw(kSensor, record<tcs::Sample>(kind));
+            break;
+        case KIND_RDARC:
+            dev_.read_archive(kSensor, rng_() % (kArchiveSpanMs + 1), record<tcs::Sample>(kind));
+            break;
+        case KIND_SET:
+            switch (set_turn_++ % 3) {
+            case 0: dev_.set_interval(config_.interval_ms, record<tcs::Done>(kind)); break;
+            case 1: dev_.set_gain(kSensor, config_.gain_index, record<tcs::Done>(kind)); break;
+            default: dev_.set_time(kSensor, config_.time_index, record<tcs::Done>(kind)); break;
+            }
+            break;
+        default:
+            switch (get_turn_++ % 5) {
+            case 0: dev_.get_interval(record<uint32_t>(kind)); break;
+            case 1: dev_.get_gain(kSensor, record<uint8_t>(kind)); break;
+            case 2: dev_.get_time(kSensor, record<uint8_t>(kind)); break;
+            case 3: dev_.get_duty(record<tcs::Duty>(kind)); break;
+            default: dev_.get_clock(record<tcs::ClockInfo>(kind)); break;
+            }
+            break;
+        }
+    }
+
+private:
+    tcs::Device &dev_;
+    Config config_;
+    std::discrete_distribution<int> pick_;
+    std::mt19937 rng_;
+    unsigned set_turn_ = 0;
+    unsigned get_turn_ = 0;
+};
+
+// KLASA=waga[,KLASA=waga...]; klasy pominiete maja wage 0
+bool parse_mix(const char *text, std::array<unsigned, KIND_COUNT> &weights) {
+    weights.fill(0);
+    std::string mix = text;
+    size_t pos = 0;
+    while (pos < mix.size()) {
+        size_t end = mix.find(',', pos);
+        if (end == std::string::npos) {
+            end = mix.size();
+        }
+        std::string item = mix.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string name = item.substr(0, eq);
+        int k = 0;
+        while (k < KIND_COUNT && name != kKindNames[k]) {
+            k++;
+        }
+        if (k == KIND_COUNT) {
+            return false;
+        }
+        weights[k] = static_cast<unsigned>(std::strtoul(item.c_str() + eq + 1, nullptr, 10));
+        pos = end + 1;
+    }
+    for (unsigned w : weights) {
+        if (w > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Percentyl metoda najblizszej rangi; v posortowany
+double percentile(const std::vector<double> &v, double q) {
+    if (v.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(v.size())));
+    return v[std::min(v.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void print_row(const char *name, uint64_t issued, uint64_t ok, std::vector<double> &latency) {
+    std::sort(latency.begin(), latency.end());
+    std::printf("%-6s %8llu %8llu %8llu %9.2f %9.2f %9.2f %9.2f\n", name,
+                (unsigned long long) issued, (unsigned long long) ok,
+                (unsigned long long) latency.size(),
+                percentile(latency, 0.50) / 1000.0, percentile(latency, 0.99) / 1000.0,
+                percentile(latency, 0.999) / 1000.0,
+                latency.empty() ? 0.0 : latency.back() / 1000.0);
+}
+
+template <typename T, typename Start>
+bool read_config(tcs::Client &client, const char *name, Start start, T &value) {
+    tcs::Result<T> r = tcs::await<T>(client, start);
+    if (!r.ok()) {
+        std::fprintf(stderr, "%s: brak poprawnej odpowiedzi\n", name);
+        return false;
+    }
+    value = r.value;
+    return true;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr, "Uzycie: %s [-R zapytania/s] [-d sekundy] [-m mieszanka] [-c promile] "
+                 "[-k promile] [-p ms] [-b baud] [-n w_locie] [-t timeout_ms] [-r powtorzenia] port\n",
+                 argv0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    unsigned baud = 115200;
+    double rate = 20;
+    double duration_s = 10;
+    unsigned crc_permille = 0;
+    unsigned truncate_permille = 0;
+    uint32_t start_interval_ms = 0;
+    std::array<unsigned, KIND_COUNT> weights = { 4, 2, 1, 3 };
+    tcs::ClientOptions options;
+    options.max_retries = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "R:d:m:c:k:p:b:n:t:r:")) != -1) {
+        switch (opt) {
+        case 'R': rate = std::atof(optarg); break;
+        case 'd': duration_s = std::atof(optarg); break;
+        case 'm':
+            if (!parse_mix(optarg, weights)) {
+                std::fprintf(stderr, "Bledna mieszanka '%s' (klasy RDRAW, RDARC, SET, GET)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c': crc_permille = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'k': truncate_permille = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'p': start_interval_ms = static_cast<uint32_t>(std::atoi(optarg)); break;
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'n': options.max_in_flight = static_cast<size_t>(std::atoi(optarg)); break;
+        case 't': options.timeout_ms = std::atoi(optarg); break;
+        case 'r': options.max_retries = std::atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind + 1 != argc || rate < 0 || duration_s <= 0 || crc_permille + truncate_permille > 1000) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fd = tcs::open_serial(argv[optind], baud);
+    if (fd < 0) {
+        std::perror(argv[optind]);
+        return 1;
+    }
+    tcs::Client client(fd, options);
+    tcs::Device dev(client);
+
+    if (start_interval_ms > 0) {
+        auto set = tcs::await<tcs::Done>(client, [&](auto cb) { dev.set_interval(start_interval_ms, cb); });
+        auto start = tcs::await<tcs::Done>(client, [&](auto cb) { dev.start(cb); });
+        if (!set.ok() || !start.ok()) {
+            const tcs::Result<tcs::Done> &failed = set.ok() ? start : set;
+            std::fprintf(stderr, "%s: urzadzenie nie przyjelo konfiguracji (%s)\n",
+                         set.ok() ? CMD_STR_START : CMD_STR_SETINT,
+                         failed.status == tcs::Status::DeviceError ? tcs::error_name(failed.error)
+                                                                   : "brak odpowiedzi");
+            return 1;
+        }
+    }
+    Config config;
+    if (!read_config<uint32_t>(client, "GETINT", [&](auto cb) { dev.get_interval(cb); }, config.interval_ms)
+            || !read_config<uint8_t>(client, "GETGAIN", [&](auto cb) { dev.get_gain(kSensor, cb); }, config.gain_index)
+            || !read_config<uint8_t>(client, "GETTIME", [&](auto cb) { dev.get_time(kSensor, cb); }, config.time_index)) {
+        return 1;
+    }
+    if (start_interval_ms > 0) {
+        // Archiwum dla RDARC - probki z calego zakresu przesuniec
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(kArchiveSpanMs, start_interval_ms * 4)));
+    }
+
+    // Wstrzykiwanie tylko w pierwszej probie - retransmisja (-r) pokazuje czas naprawy
+    std::mt19937 fault_rng(54321);
+    client.on_transmit([&](std::string &frame, uint8_t attempt) {
+        if (attempt > 0) {
+            return;
+        }
+        unsigned roll = fault_rng() % 1000;
+        if (roll < crc_permille) {
+            // Ostatnia cyfra CRC przed '*' zmieniona na inna cyfre hex
+            char &digit = frame[frame.size() - 2];
+            digit = digit == '0' ? '1' : '0';
+            injected_crc++;
+        } else if (roll < crc_permille + truncate_permille) {
+            frame.resize(1 + fault_rng() % (frame.size() - 2));
+            injected_truncated++;
+        }
+    });
+    client.on_error([](ErrorCode code, const tcs::Frame &) {
+        event_errors[code]++;
+    });
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    Generator generator(dev, config, weights);
+    // Przy przeciazeniu zapytania czekaja w kolejce klienta; ponad ten limit sa pomijane,
+    // zeby opoznienie mierzone od wyslania nie roslo bez konca
+    const size_t backlog = options.max_in_flight * 4;
+    const auto period = rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / rate)) : Clock::duration::zero();
+    uint64_t skipped = 0;
+
+    const Clock::time_point started = Clock::now();
+    const Clock::time_point end = started + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(duration_s));
+    Clock::time_point next = started;
+
+    for (Clock::time_point now = started; now < end && !stop_requested; now = Clock::now()) {
+        if (rate > 0) {
+            for (; next <= now; next += period) {
+                if (client.pending() < backlog) {
+                    generator.issue();
+                } else {
+                    skipped++;
+                }
+            }
+        } else {
+            while (client.pending() < client.options().max_in_flight) {
+                generator.issue();
+            }
+            next = now + std::chrono::milliseconds(50);
+        }
+
+        Clock::time_point wake = std::min(next, end);
+        int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+        if (client.pending() > 0) {
+            client.poll(std::max(wait_ms, 0));
+        } else {
+            std::this_thread::sleep_until(wake);
+        }
+    }
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - started).count();
+    client.run_until_idle();
+
+    uint64_t issued = 0, ok = 0, timeouts = 0, closed = 0, bad_replies = 0;
+    std::array<uint64_t, kErrorCount> errors{};
+    std::vector<double> all;
+    std::printf("%-6s %8s %8s %8s %9s %9s %9s %9s\n", "klasa", "wyslane", "ok", "odp",
+                "p50 ms", "p99 ms", "p999 ms", "max ms");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        KindStats &s = stats[k];
+        if (s.issued == 0) {
+            continue;
+        }
+        print_row(kKindNames[k], s.issued, s.ok, s.latency_us);
+        issued += s.issued;
+        ok += s.ok;
+        timeouts += s.timeouts;
+        closed += s.closed;
+        bad_replies += s.bad_replies;
+        for (size_t e = 0; e < kErrorCount; e++) {
+            errors[e] += s.errors[e];
+        }
+        all.insert(all.end(), s.latency_us.begin(), s.latency_us.end());
+    }
+    print_row("razem", issued, ok, all);
+
+    std::printf("czas %.2f s, tempo %.1f/s (cel ", elapsed_s, static_cast<double>(issued) / elapsed_s);
+    if (rate > 0) {
+        std::printf("%.1f/s", rate);
+    } else {
+        std::printf("maks.");
+    }
+    std::printf("), odpowiedzi %.1f/s, pominiete %llu\n", static_cast<double>(all.size()) / elapsed_s,
+                (unsigned long long) skipped);
+
+    std::printf("bledy:");
+    bool any = false;
+    for (size_t e = 0; e < kErrorCount; e++) {
+        if (errors[e] > 0) {
+            std::printf(" %s %llu", tcs::error_name(static_cast<ErrorCode>(e)), (unsigned long long) errors[e]);
+            any = true;
+        }
+        if (event_errors[e] > 0) {
+            std::printf(" %s(bez id) %llu", tcs::error_name(static_cast<ErrorCode>(e)),
+                        (unsigned long long) event_errors[e]);
+            any = true;
+        }
+    }
+    if (timeouts > 0) {
+        std::printf(" brak_odpowiedzi %llu", (unsigned long long) timeouts);
+        any = true;
+    }
+    if (bad_replies > 0) {
+        std::printf(" zly_format %llu", (unsigned long long) bad_replies);
+        any = true;
+    }
+    if (closed > 0) {
+        std::printf(" port_zamkniety %llu", (unsigned long long) closed);
+        any = true;
+    }
+    std::printf("%s\n", any ? "" : " brak");
+    std::printf("wstrzykniete: CRC %llu, uciete %llu\n", (unsigned long long) injected_crc,
+                (unsigned long long) injected_truncated);
+
+    const tcs::ClientStats &cs = client.stats();
+    std::printf("klient: ramki %llu, retransmisje %llu, niedopasowane %llu, bledne ramki %llu\n",
+                (unsigned long long) cs.sent, (unsigned long long) cs.retransmits,
+                (unsigned long long) cs.unmatched, (unsigned long long) cs.bad_frames);
+    close(fd);
+    return closed > 0 ? 2 : 0;
+}
@@ -0,0 +1,320 @@
+// Dekoder sladu zdarzen z komendy RDTRC - chronologiczny przebieg z czasami.
+// Uzycie: trace_decode [-t prog_us] [plik]
+// Wejscie (plik lub stdin): linie z odpowiedziami "TRCQ..." (np. wyjscie tcs_sim)
+// albo surowe ramki protokolu "&...*". Strony moga sie powtarzac i nakladac -
+// wpisy sa laczone po numerze. Ramki, ktorych czas od znaku & do konca komendy
+// przekracza prog, sa oznaczane "!!" razem ze zdarzeniami, ktore im towarzyszyly.
+
+extern "C" {
+#include "trace.h"
+#include "protocol.h"
+#include "tcs34725.h"
+}
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *const kEventNames[] = {
+    "NONE", "FRAME_START", "FRAME_END", "PARSE", "CMD_START", "CMD_END",
+    "TX_LEVEL", "XFER_START", "XFER_DONE", "BUS_ERROR", "STATE", "SAMPLE",
+    "TIMER_TICK",
+};
+static_assert(sizeof(kEventNames) / sizeof(kEventNames[0]) == TRC_EVENT_COUNT,
+              "kEventNames nie odpowiada TraceEvent_t");
+
+const char *const kParseNames[] = {
+    "OK", "WRONG_RECIPIENT", "TOO_SHORT", "INVALID_FORMAT", "FORBIDDEN_CHARS",
+    "LENGTH_MISMATCH", "CRC_ERROR", "CMD_ERROR",
+};
+static_assert(sizeof(kParseNames) / sizeof(kParseNames[0]) == PARSE_CMD_ERROR + 1,
+              "kParseNames nie odpowiada ParseResult");
+
+const char *const kStateNames[] = {
+    "INIT_READ_ID", "CONFIGURING", "POWERUP_WAIT", "READY",
+    "BUSY", "CLEARING", "RECOVERY", "ERROR",
+};
+static_assert(sizeof(kStateNames) / sizeof(kStateNames[0]) == TCS_STATE_ERROR + 1,
+              "kStateNames nie odpowiada TCS_State_t");
+
+template <size_t N>
+const char *name_of(const char *const (&names)[N], unsigned index) {
+    return index < N ? names[index] : "?";
+}
+
+bool parse_hex(const std::string &s, size_t pos, size_t len, uint32_t &out) {
+    if (pos + len > s.size()) {
+        return false;
+    }
+    out = 0;
+    for (size_t i = pos; i < pos + len; i++) {
+        char c = s[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else return false;
+        out = (out << 4) | d;
+    }
+    return true;
+}
+
+bool parse_dec(const std::string &s, size_t pos, size_t len, uint32_t &out) {
+    if (pos + len > s.size()) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = pos; i < pos + len; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (s[i] - '0');
+    }
+    out = static_cast<uint32_t>(value);
+    return true;
+}
+
+// Dane z surowej ramki: & SSS RRR LLL ID dane(hex) CRC *
+std::string frame_payload(const std::string &line) {
+    size_t start = line.find(PROTOCOL_START_BYTE);
+    size_t end = line.find(PROTOCOL_END_BYTE, start);
+    if (start == std::string::npos || end == std::string::npos || end - start < MIN_FRAME_LEN - 1) {
+        return line;
+    }
+    uint32_t hex_len;
+    if (!parse_dec(line, start + 7, 3, hex_len) || start + 12 + hex_len > end) {
+        return line;
+    }
+    std::string payload;
+    for (uint32_t i = 0; i + 1 < hex_len; i += 2) {
+        uint32_t byte;
+        if (!parse_hex(line, start + 12 + i, 2, byte)) {
+            return line;
+        }
+        payload.push_back(static_cast<char>(byte));
+    }
+    return payload;
+}
+
+void flush(std::vector<std::string> &lines, const char *mark) {
+    for (const auto &l : lines) {
+        std::printf("%s %s\n", mark, l.c_str());
+    }
+    lines.clear();
+}
+
+class TraceLog {
+public:
+    // Jedna strona RDTRC: TRCQ<10>H<10>N<2> i N wpisow po 16 znakow hex
+    bool add_page(const std::string &line) {
+        std::string payload = frame_payload(line);
+        size_t pos = payload.find(TRC_PREFIX "Q");
+        if (pos == std::string::npos) {
+            return false;
+        }
+        pos += 4;
+        uint32_t first, head, count;
+        if (!parse_dec(payload, pos, 10, first) || payload[pos + 10] != 'H'
+                || !parse_dec(payload, pos + 11, 10, head) || payload[pos + 21] != 'N'
+                || !parse_dec(payload, pos + 22, 2, count)) {
+            return false;
+        }
+        pos += 24;
+        for (uint32_t i = 0; i < count; i++, pos += 16) {
+            uint32_t time_us, event, a8, a16;
+            if (!parse_hex(payload, pos, 8, time_us) || !parse_hex(payload, pos + 8, 2, event)
+                    || !parse_hex(payload, pos + 10, 2, a8) || !parse_hex(payload, pos + 12, 4, a16)) {
+                return false;
+            }
+            entries_[first + i] = TraceEntry_t{ time_us, static_cast<uint8_t>(event),
+                                                static_cast<uint8_t>(a8), static_cast<uint16_t>(a16) };
+        }
+        return true;
+    }
+
+    bool empty() const { return entries_.empty(); }
+
+    void print(uint32_t threshold_us) const;
+
+private:
+    std::map<uint32_t, TraceEntry_t> entries_;
+};
+
+void TraceLog::print(uint32_t threshold_us) const {
+    uint64_t now_us = 0;
+    uint32_t prev_time = 0;
+    uint32_t prev_seq = 0;
+    bool first = true;
+
+    uint64_t frame_start_us = 0;
+    uint64_t cmd_start_us = 0;
+    uint64_t xfer_start_us[256] = {};
+    uint32_t event_counts[TRC_EVENT_COUNT] = {};
+    uint32_t slow_frames = 0;
+    uint64_t worst_us = 0;
+    uint32_t worst_seq = 0;
+    std::vector<std::string> pending;   // Zdarzenia od znaku & do konca komendy
+
+    for (const auto &item : entries_) {
+        uint32_t seq = item.first;
+        const TraceEntry_t &e = item.second;
+
+        if (!first && seq != prev_seq + 1) {
+            std::printf("--- utracone wpisy: %lu\n", static_cast<unsigned long>(seq - prev_seq - 1));
+        }
+        // Czas 32-bitowy zawija sie co ~71.6 min - liczone sa tylko przyrosty
+        uint32_t delta = first ? 0 : e.time_us - prev_time;
+        now_us += delta;
+        prev_time = e.time_us;
+        prev_seq = seq;
+        first = false;
+
+        char detail[96] = "";
+        switch (e.event) {
+        case TRC_FRAME_START:
+            frame_start_us = now_us;
+            std::snprintf(detail, sizeof(detail), "bufor RX %u", e.a16);
+            break;
+        case TRC_FRAME_END:
+            std::snprintf(detail, sizeof(detail), "dlugosc %u", e.a16);
+            break;
+        case TRC_PARSE:
+            std::snprintf(detail, sizeof(detail), "%s", name_of(kParseNames, e.a8));
+            break;
+        case TRC_CMD_START:
+            cmd_start_us = now_us;
+            std::snprintf(detail, sizeof(detail), "komenda %u ramka #%02u", e.a8, e.a16);
+            break;
+        case TRC_CMD_END:
+            std::snprintf(detail, sizeof(detail), "komenda %u ramka #%02u: wykonanie %llu us, od & %llu us",
+                          e.a8, e.a16, static_cast<unsigned long long>(now_us - cmd_start_us),
+                          static_cast<unsigned long long>(now_us - frame_start_us));
+            break;
+        case TRC_TX_LEVEL:
+            std::snprintf(detail, sizeof(detail), "bufor TX %u", e.a16);
+            break;
+        case TRC_XFER_START:
+            xfer_start_us[e.a8] = now_us;
+            std::snprintf(detail, sizeof(detail), "magistrala %u czujnik %u rejestr 0x%02X",
+                          e.a8, e.a16 >> 8, e.a16 & 0xFF);
+            break;
+        case TRC_XFER_DONE:
+            std::snprintf(detail, sizeof(detail), "magistrala %u czujnik %u: %llu us", e.a8, e.a16,
+                          static_cast<unsigned long long>(now_us - xfer_start_us[e.a8]));
+            break;
+        case TRC_BUS_ERROR:
+            std::snprintf(detail, sizeof(detail), "magistrala %u", e.a8);
+            break;
+        case TRC_STATE:
+            std::snprintf(detail, sizeof(detail), "czujnik %u -> %s", e.a8, name_of(kStateNames, e.a16));
+            break;
+        case TRC_SAMPLE:
+            std::snprintf(detail, sizeof(detail), "czujnik %u C%u", e.a8, e.a16);
+            break;
+        default:
+            break;
+        }
+        if (e.event < TRC_EVENT_COUNT) {
+            event_counts[e.event]++;
+        }
+
+        char line[160];
+        std::snprintf(line, sizeof(line), "%10lu %12.3f ms %+9ld us  %-11s %s",
+                      static_cast<unsigned long>(seq), static_cast<double>(now_us) / 1000.0,
+                      static_cast<long>(delta), name_of(kEventNames, e.event), detail);
+
+        if (e.event == TRC_CMD_END) {
+            uint64_t latency = now_us - frame_start_us;
+            if (latency > worst_us) {
+                worst_us = latency;
+                worst_seq = seq;
+            }
+            // Wolna ramka - wszystko, co dzialo sie od znaku &, jest kandydatem na przyczyne
+            const char *mark = "  ";
+            if (threshold_us && latency > threshold_us) {
+                mark = "!!";
+                slow_frames++;
+            }
+            flush(pending, mark);
+            std::printf("%s %s\n", mark, line);
+            continue;
+        }
+        if (e.event == TRC_FRAME_START) {
+            flush(pending, "  ");
+        }
+        if (threshold_us && (e.event == TRC_FRAME_START || !pending.empty())) {
+            pending.push_back(line);
+            // Ramka odrzucona - komenda nie zostanie wykonana
+            if (e.event == TRC_PARSE && e.a8 != PARSE_OK) {
+                flush(pending, "  ");
+            }
+            continue;
+        }
+        std::printf("   %s\n", line);
+    }
+    flush(pending, "  ");
+
+    std::printf("--- wpisy %lu, czas %.3f ms\n", static_cast<unsigned long>(entries_.size()),
+                static_cast<double>(now_us) / 1000.0);
+    for (unsigned i = 1; i < TRC_EVENT_COUNT; i++) {
+        if (event_counts[i]) {
+            std::printf("%-11s %lu\n", kEventNames[i], static_cast<unsigned long>(event_counts[i]));
+        }
+    }
+    if (worst_us) {
+        std::printf("najwolniejsza ramka: %llu us od &, wpis %lu\n",
+                    static_cast<unsigned long long>(worst_us), static_cast<unsigned long>(worst_seq));
+    }
+    if (threshold_us) {
+        std::printf("ramki ponad %lu us: %lu\n", static_cast<unsigned long>(threshold_us),
+                    static_cast<unsigned long>(slow_frames));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint32_t threshold_us = 0;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            threshold_us = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (path == nullptr && arg[0] != '-') {
+            path = argv[i];
+        } else {
+            std::fprintf(stderr, "Uzycie: %s [-t prog_us] [plik]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream file;
+    if (path != nullptr) {
+        file.open(path);
+        if (!file) {
+            std::fprintf(stderr, "Nie mozna otworzyc %s\n", path);
+            return 1;
+        }
+    }
+    std::istream &in = path != nullptr ? static_cast<std::istream &>(file) : std::cin;
+
+    TraceLog log;
+    std::string line;
+    while (std::getline(in, line)) {
+        log.add_page(line);
+    }
+    if (log.empty()) {
+        std::fprintf(stderr, "Brak stron " TRC_PREFIX " na wejsciu\n");
+        return 1;
+    }
+    log.print(threshold_us);
+    return 0;
+}